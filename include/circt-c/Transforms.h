@@ -0,0 +1,46 @@
+//===-- circt-c/Transforms.h - C API for CIRCT transforms ---------*- C -*-===//
+//
+// This header declares the C interface for the incremental simplifier, which
+// folds and canonicalizes the fan-out cone of a set of changed operations.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_C_TRANSFORMS_H
+#define CIRCT_C_TRANSFORMS_H
+
+#include "mlir-c/IR.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct MlirIncrementalSimplifier {
+  void *ptr;
+};
+typedef struct MlirIncrementalSimplifier MlirIncrementalSimplifier;
+
+/// A callback for returning operations.
+typedef void (*MlirOperationCallback)(MlirOperation, void *userData);
+
+/// Creates a simplifier using the canonicalization patterns of all operations
+/// registered in the context.
+MLIR_CAPI_EXPORTED MlirIncrementalSimplifier
+mlirIncrementalSimplifierCreate(MlirContext context);
+
+/// Destroys the simplifier.
+MLIR_CAPI_EXPORTED void
+mlirIncrementalSimplifierDestroy(MlirIncrementalSimplifier simplifier);
+
+/// Simplifies the specified operations and everything which transitively uses
+/// their results.  Calls the callback on each operation which was created or
+/// modified and still exists, and returns the number of operations erased.
+MLIR_CAPI_EXPORTED intptr_t mlirIncrementalSimplifierRun(
+    MlirIncrementalSimplifier simplifier, intptr_t numOps,
+    MlirOperation const *ops, MlirOperationCallback changedCallback,
+    void *userData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CIRCT_C_TRANSFORMS_H
@@ -0,0 +1,159 @@
+//===- TimingAnalysis.h - Logic depth estimation for RTL --------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This header declares a static timing analysis estimating the arrival times
+// of the values of rtl.module bodies from a delay model of the operations.  It
+// gives fast feedback on the logic depth of a design without synthesizing it.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_ANALYSIS_TIMINGANALYSIS_H
+#define CIRCT_ANALYSIS_TIMINGANALYSIS_H
+
+#include "circt/Support/LLVM.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/SymbolTable.h"
+#include "llvm/ADT/DenseMap.h"
+
+namespace circt {
+
+/// Estimates the delay of the operations which propagate values
+/// combinationally.  The delays are in arbitrary units.
+class DelayModel {
+public:
+  virtual ~DelayModel();
+
+  /// Return the delay from the operands of the operation to its results.
+  virtual unsigned getDelay(Operation *op) = 0;
+};
+
+/// The delay of each kind of two input operation.
+struct DelayWeights {
+  /// The delay of an and, or, xor and of the other bitwise operations.
+  unsigned logic = 1;
+  /// The delay of an add, and of the other arithmetic and comparison
+  /// operations.
+  unsigned arith = 4;
+  /// The delay of a two way mux.
+  unsigned mux = 2;
+};
+
+/// A delay model with one delay per kind of operation.  Variadic operations
+/// are assumed to be balanced trees of two input operations, array reads are
+/// trees of muxes, and operations which only rearrange bits have no delay.
+class WeightedDelayModel : public DelayModel {
+public:
+  explicit WeightedDelayModel(DelayWeights weights = DelayWeights())
+      : weights(weights) {}
+
+  unsigned getDelay(Operation *op) override {
+    return getDelay(op, op->getNumOperands());
+  }
+
+  /// Return the delay the operation would have with the specified number of
+  /// operands.
+  unsigned getDelay(Operation *op, unsigned numOperands) const;
+
+  const DelayWeights &getWeights() const { return weights; }
+
+private:
+  DelayWeights weights;
+};
+
+/// The arrival time of a value.  Paths start at registers and at the outputs
+/// of external modules, and at the input ports of the module.  The paths from
+/// the input ports are kept apart, so that they can be offset by the arrival
+/// times of the inputs of each instance of the module.  A time of -1 means
+/// that no such path reaches the value.
+struct Arrival {
+  /// The arrival time of the latest path starting at a register.
+  int fromRegs = -1;
+  /// The delay of the longest path starting at an input port.
+  int fromInputs = -1;
+
+  /// Return the arrival time when the input ports arrive at time zero, or -1
+  /// if no path reaches the value.
+  int get() const { return std::max(fromRegs, fromInputs); }
+
+  void merge(const Arrival &other) {
+    fromRegs = std::max(fromRegs, other.fromRegs);
+    fromInputs = std::max(fromInputs, other.fromInputs);
+  }
+};
+
+/// The timing of a module, as seen from its instances.
+struct ModuleTiming {
+  /// The arrival time of each output port.
+  SmallVector<Arrival, 4> outputs;
+
+  /// The arrival time of the latest path ending at a register of the module,
+  /// or at a register of a module it instantiates.
+  Arrival registers;
+
+  /// The arrival time of the latest path of the module when its input ports
+  /// arrive at time zero, and the operation where it ends: an rtl.output, a
+  /// register or an instance whose registers end the path.
+  int criticalPath = -1;
+  Operation *criticalEndpoint = nullptr;
+  /// The last value of the critical path in the module.
+  Value criticalValue;
+};
+
+/// Computes the arrival times of the values of every rtl.module in an MLIR
+/// module.  The values computed by comb and rtl operations are available at
+/// the latest arrival time of their operands plus the delay of the operation,
+/// while registers and other operations start new paths.  Reads of wires see
+/// the values connected to them.  Each module is analyzed once, before the
+/// modules instantiating it, and the paths through an instance are computed
+/// from the timing of the instantiated module.  The paths from the inputs to
+/// each output of a module are summarized by their longest delay, which is
+/// applied to the latest input of each instance.  This overestimates the
+/// depth of the paths which do not go through the latest input, but keeps
+/// the analysis linear in the size of the design.
+class TimingAnalysis {
+public:
+  TimingAnalysis(ModuleOp module, DelayModel &delayModel);
+
+  /// Return the timing of the specified rtl.module, or null if it is not an
+  /// analyzed module.
+  const ModuleTiming *getModuleTiming(Operation *module) const;
+
+  /// Return the arrival time of a value of an rtl.module body.
+  Arrival getArrival(Value value) const { return arrivals.lookup(value); }
+
+  /// Return the operations on the critical path of the module, from its start
+  /// to its end.  The path stops at the instances it goes through.
+  SmallVector<Operation *, 8> getCriticalPath(Operation *module) const;
+
+  /// Return the values which the results of the operation depend on
+  /// combinationally.
+  ValueRange getFanIn(Operation *op) const;
+
+private:
+  void analyzeModule(Operation *module);
+  void visitOperation(Operation *op);
+  void collectEndpoints(Operation *module, ModuleTiming &timing);
+
+  DelayModel &delayModel;
+  SymbolTable symbolTable;
+
+  /// The arrival times of the values with a path reaching them.
+  DenseMap<Value, Arrival> arrivals;
+
+  /// The timing of the modules analyzed so far.  The modules being analyzed
+  /// are present with an empty timing, so recursive instances are treated as
+  /// external modules.
+  DenseMap<Operation *, ModuleTiming> moduleTimings;
+
+  /// The values connected to each wire.
+  DenseMap<Operation *, SmallVector<Value, 1>> wireDrivers;
+};
+
+} // namespace circt
+
+#endif // CIRCT_ANALYSIS_TIMINGANALYSIS_H
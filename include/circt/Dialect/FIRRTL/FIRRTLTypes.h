@@ -257,6 +257,9 @@ public:
   llvm::Optional<BundleElement> getElement(StringRef name);
   FIRRTLType getElementType(StringRef name);
 
+  /// Look up an element index by name.  This returns None on failure.
+  llvm::Optional<unsigned> getElementIndex(StringRef name);
+
   /// Return a pair with the 'isPassive' and 'containsAnalog' bits.
   std::pair<bool, bool> getRecursiveTypeProperties();
 
@@ -19,6 +19,15 @@
 namespace circt {
 namespace rtl {
 
+/// Return a signless integer attribute holding the value.  This goes through
+/// the per-thread cache of the RTL dialect if it is loaded, so it should be
+/// preferred over IntegerAttr::get for constants created in bulk.
+IntegerAttr getIntAttr(const APInt &value, MLIRContext *context);
+
+/// Register the command line options of the RTL dialect.  The options apply to
+/// the dialects loaded after the command line is parsed.
+void registerRTLDialectCLOptions();
+
 } // namespace rtl
 } // namespace circt
 
@@ -14,6 +14,7 @@
 #define CIRCT_DIALECT_SV_SVPASSES_H
 
 #include "mlir/Pass/Pass.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include <memory>
 
@@ -27,6 +28,10 @@ namespace circt {
 namespace sv {
 
 std::unique_ptr<mlir::Pass> createRTLCleanupPass();
+std::unique_ptr<mlir::Pass> createRTLStructuralCSEPass();
+std::unique_ptr<mlir::Pass> createRTLBalanceLogicPass();
+std::unique_ptr<mlir::Pass>
+createRTLPrintTimingPass(llvm::raw_ostream &os = llvm::errs());
 std::unique_ptr<mlir::Pass> createRTLStubExternalModulesPass();
 std::unique_ptr<mlir::Pass> createRTLLegalizeNamesPass();
 std::unique_ptr<mlir::Pass> createRTLGeneratorCalloutPass();
@@ -0,0 +1,123 @@
+//===- CycleSimulator.h - Cycle-based RTL simulator -------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines cycle-based simulators for synchronous designs made of
+// rtl.module, comb and seq.compreg operations.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_DIALECT_SEQ_SIMULATOR_CYCLESIMULATOR_H
+#define CIRCT_DIALECT_SEQ_SIMULATOR_CYCLESIMULATOR_H
+
+#include "circt/Support/LLVM.h"
+#include "mlir/IR/BuiltinOps.h"
+
+namespace circt {
+namespace seq {
+namespace sim {
+
+struct Program;
+
+struct PortInfo {
+  StringAttr name;
+  unsigned width;
+};
+
+/// The parts shared by the simulators.  The design is flattened into a single
+/// netlist below the top-level module, its combinational logic is sorted in
+/// the order of its data dependencies, and every value is kept in 64-bit
+/// words.  Evaluating the design is then a single pass over the sorted
+/// netlist.
+///
+/// All registers are updated together once per cycle, as if on the rising edge
+/// of a single clock, and start out as zero.  Their clock has to be an input
+/// port of the top-level module.
+class SimulatorBase {
+public:
+  ~SimulatorBase();
+
+  /// Return the input and output ports of the top-level module.
+  ArrayRef<PortInfo> getInputs() const { return inputs; }
+  ArrayRef<PortInfo> getOutputs() const { return outputs; }
+
+  /// Return the index of the port with the specified name, if any.
+  Optional<unsigned> lookupInput(StringRef name) const;
+  Optional<unsigned> lookupOutput(StringRef name) const;
+
+  /// Advance the simulation by the specified number of clock cycles.
+  void step(uint64_t numCycles = 1);
+
+  /// Return the number of clock cycles simulated so far.
+  uint64_t getCycle() const { return cycle; }
+
+protected:
+  SimulatorBase();
+
+  /// Compile the module named \p top in \p module.  If \p laneWords is zero,
+  /// each value is packed into as few words as possible.  Otherwise, the
+  /// values are bit-sliced over `64 * laneWords` independent lanes.
+  LogicalResult build(ModuleOp module, StringRef top, unsigned laneWords);
+
+  /// Propagate the inputs and registers through the combinational logic.
+  void evaluate();
+
+  std::unique_ptr<Program> program;
+  SmallVector<PortInfo, 4> inputs, outputs;
+  uint64_t cycle = 0;
+
+  /// True if the inputs or registers changed since the last evaluation.
+  bool needsEvaluation = true;
+};
+
+/// A simulator evaluating a single stimulus.  Values are packed in words, with
+/// a fast path for the values which fit in one word.
+class CycleSimulator : public SimulatorBase {
+public:
+  /// Build a simulator for the module named \p top in \p module.  Returns null
+  /// and emits an error if the design cannot be simulated.
+  static std::unique_ptr<CycleSimulator> create(ModuleOp module, StringRef top);
+
+  /// Set the value of the specified input port.  The value is truncated or
+  /// zero extended to the width of the port.
+  void setInput(unsigned index, const APInt &value);
+
+  /// Return the value of the specified output port.
+  APInt getOutput(unsigned index);
+};
+
+/// A simulator evaluating many independent stimuli at once.  Each bit of a
+/// value is stored in its own words, holding that bit for every lane, so the
+/// logic is evaluated bitwise over all lanes together.  This is much faster
+/// than repeated simulation for designs dominated by narrow control signals,
+/// but multiplication, division and modulus are not supported.
+class BitParallelSimulator : public SimulatorBase {
+public:
+  /// Build a simulator for the module named \p top in \p module, evaluating
+  /// \p numLanes stimuli at once.  The number of lanes must be a multiple of
+  /// 64.  Returns null and emits an error if the design cannot be simulated.
+  static std::unique_ptr<BitParallelSimulator>
+  create(ModuleOp module, StringRef top, unsigned numLanes = 64);
+
+  unsigned getNumLanes() const { return numLanes; }
+
+  /// Set the value of the specified input port in the specified lane.  The
+  /// value is truncated or zero extended to the width of the port.
+  void setInput(unsigned index, unsigned lane, const APInt &value);
+
+  /// Return the value of the specified output port in the specified lane.
+  APInt getOutput(unsigned index, unsigned lane);
+
+private:
+  unsigned numLanes = 0;
+};
+
+} // namespace sim
+} // namespace seq
+} // namespace circt
+
+#endif // CIRCT_DIALECT_SEQ_SIMULATOR_CYCLESIMULATOR_H
@@ -21,6 +21,7 @@
 #include "circt/Dialect/SV/SVPasses.h"
 #include "circt/Dialect/Seq/SeqDialect.h"
 #include "circt/Transforms/Passes.h"
+#include "circt/Translation/Passes.h"
 
 namespace circt {
 
@@ -28,6 +29,9 @@ inline void registerAllPasses() {
   // Conversion Passes
   registerConversionPasses();
 
+  // Translation Passes
+  registerTranslationPasses();
+
   // Standard Passes
   esi::registerESIPasses();
   firrtl::registerPasses();
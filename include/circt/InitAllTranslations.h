@@ -15,6 +15,7 @@
 #include "circt/Dialect/FIRRTL/FIRParser.h"
 #include "circt/Dialect/LLHD/Translation/TranslateToVerilog.h"
 #include "circt/Dialect/MSFT/ExportTcl.h"
+#include "circt/Translation/BinaryIR.h"
 #include "circt/Translation/ExportVerilog.h"
 
 #ifndef CIRCT_INITALLTRANSLATIONS_H
@@ -27,6 +28,7 @@ namespace circt {
 // automatically.
 inline void registerAllTranslations() {
   static bool initOnce = []() {
+    registerBinaryIRTranslation();
     registerToVerilogTranslation();
     esi::registerESITranslations();
     firrtl::registerFromFIRRTLTranslation();
@@ -61,6 +61,11 @@ struct LoweringOptions {
   /// This is the target width of lines in an emitted verilog source file in
   /// columns.
   unsigned emittedLineLength = 90;
+
+  /// If true, ExportVerilog replaces the location comments on emitted
+  /// statements with short IDs like `// @3`, and writes the locations the IDs
+  /// refer to into a separate source map table.
+  bool emitSourceMapIDs = false;
 };
 
 /// Register commandline options for the verilog emitter.
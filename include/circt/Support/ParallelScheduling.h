@@ -0,0 +1,58 @@
+//===- ParallelScheduling.h - Size-aware parallel loops ---------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Helpers for processing a list of operations, typically the modules of a
+// circuit, on the thread pool.  Designs often have a few giant modules among
+// thousands of tiny ones, so the work is handed out largest-first to keep one
+// big module from serializing the tail of the loop.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_SUPPORT_PARALLELSCHEDULING_H
+#define CIRCT_SUPPORT_PARALLELSCHEDULING_H
+
+#include "circt/Support/LLVM.h"
+#include <vector>
+
+namespace circt {
+
+/// Estimate the cost of processing the specified operation as the number of
+/// operations nested within it, including itself.
+size_t estimateOperationCost(Operation *op);
+
+/// Estimate the cost of processing each of the specified operations, for
+/// callers which schedule the same operations several times.  The costs are
+/// only used to order the work on the thread pool, so if multithreading is
+/// disabled in \p context, the operations are not walked and all costs are 0.
+std::vector<size_t> estimateOperationCosts(MLIRContext *context,
+                                           ArrayRef<Operation *> ops);
+
+/// Invoke \p fn with the index of each of the specified operations.  If
+/// multithreading is enabled in \p context, the calls are made on the thread
+/// pool, in order of decreasing estimated cost.  Diagnostics emitted by the
+/// calls are reported in the order of \p ops, as if they were made serially.
+///
+/// The time taken by each call is printed with `-print-parallel-schedule`, or
+/// with `-debug-only=parallel-schedule`, to help find imbalances.
+void parallelForEachLargestFirst(MLIRContext *context,
+                                 ArrayRef<Operation *> ops,
+                                 function_ref<void(size_t index)> fn);
+
+/// Same as above, with the costs of the operations estimated beforehand.
+void parallelForEachLargestFirst(MLIRContext *context,
+                                 ArrayRef<Operation *> ops,
+                                 ArrayRef<size_t> costs,
+                                 function_ref<void(size_t index)> fn);
+
+/// Register the command line options which control the reporting of parallel
+/// schedules.
+void registerParallelSchedulingCLOptions();
+
+} // namespace circt
+
+#endif // CIRCT_SUPPORT_PARALLELSCHEDULING_H
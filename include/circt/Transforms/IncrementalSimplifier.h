@@ -0,0 +1,63 @@
+//===- IncrementalSimplifier.h - Change-driven simplification ---*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This header declares a simplifier which re-canonicalizes only the logic
+// affected by a set of changes, for clients which edit the IR in small steps
+// and want it kept simplified as they go.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_TRANSFORMS_INCREMENTALSIMPLIFIER_H
+#define CIRCT_TRANSFORMS_INCREMENTALSIMPLIFIER_H
+
+#include "circt/Support/LLVM.h"
+#include "mlir/Rewrite/FrozenRewritePatternSet.h"
+
+namespace circt {
+
+/// The changes made by an incremental simplification.
+struct SimplifyResult {
+  /// The operations which were created or modified, and still exist, in the
+  /// order they were first changed.
+  SmallVector<Operation *, 8> changedOps;
+
+  /// The number of operations which were erased, including the operations
+  /// nested in them.
+  size_t numErased = 0;
+};
+
+/// Folds and canonicalizes the fan-out cone of a set of changed operations,
+/// with the same folders, patterns and driver as the simple canonicalizer.
+/// The patterns are built once, so the simplifier is cheap to run after
+/// every edit.
+class IncrementalSimplifier {
+public:
+  /// Build a simplifier using the canonicalization patterns of all operations
+  /// registered in the context.
+  explicit IncrementalSimplifier(MLIRContext *context);
+
+  /// Build a simplifier using the specified patterns.
+  IncrementalSimplifier(MLIRContext *context,
+                        mlir::FrozenRewritePatternSet patterns);
+
+  /// Simplify the specified operations and everything which transitively
+  /// uses their results.  The operations should be the ones created or
+  /// modified by an edit; operations which lost uses may be passed too, so
+  /// that they are erased if they are now dead.  Other operations are only
+  /// revisited when a change reaches them.
+  SimplifyResult simplify(ArrayRef<Operation *> changedOps,
+                          int maxIterations = 10);
+
+private:
+  MLIRContext *context;
+  mlir::FrozenRewritePatternSet patterns;
+};
+
+} // namespace circt
+
+#endif // CIRCT_TRANSFORMS_INCREMENTALSIMPLIFIER_H
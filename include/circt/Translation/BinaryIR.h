@@ -0,0 +1,50 @@
+//===- BinaryIR.h - Binary IR reader and writer -----------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Defines the interface to the compact binary IR format, which passes IR
+// between tools without printing and re-parsing it as text.
+//
+// A file holds a table of strings, a table of types, a table of attributes, a
+// table of locations, and the operation stream.  The types and attributes are
+// stored in their textual form, so that every dialect is supported, but each
+// distinct type and attribute is only parsed once.  Everything else is stored
+// as variable length integers referring to the tables.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_TRANSLATION_BINARYIR_H
+#define CIRCT_TRANSLATION_BINARYIR_H
+
+#include "mlir/IR/BuiltinOps.h"
+
+namespace llvm {
+class MemoryBufferRef;
+class raw_ostream;
+class StringRef;
+} // namespace llvm
+
+namespace circt {
+
+/// Write an operation, usually a builtin.module, in the binary IR format.
+void exportBinaryIR(mlir::Operation *op, llvm::raw_ostream &os);
+
+/// Return true if the buffer holds IR in the binary IR format.
+bool isBinaryIR(llvm::StringRef buffer);
+
+/// Read a builtin.module in the binary IR format, and verify it.  Errors are
+/// reported through the diagnostic handlers of the context, and result in a
+/// null module.  The dialects of the operations are loaded on demand.
+mlir::OwningModuleRef importBinaryIR(llvm::MemoryBufferRef buffer,
+                                     mlir::MLIRContext *context);
+
+/// Register the translations between the textual and the binary IR formats.
+void registerBinaryIRTranslation();
+
+} // namespace circt
+
+#endif // CIRCT_TRANSLATION_BINARYIR_H
@@ -13,6 +13,7 @@
 #ifndef CIRCT_TRANSLATION_EXPORTVERILOG_H
 #define CIRCT_TRANSLATION_EXPORTVERILOG_H
 
+#include "llvm/ADT/StringSet.h"
 #include <functional>
 
 namespace llvm {
@@ -23,20 +24,49 @@ class StringRef;
 namespace mlir {
 struct LogicalResult;
 class ModuleOp;
+class OpPassManager;
 } // namespace mlir
 
 namespace circt {
 
-/// Export a module containing RTL, and SV dialect code. Requires that the SV
-/// dialect is loaded in to the context.
-mlir::LogicalResult exportVerilog(mlir::ModuleOp module, llvm::raw_ostream &os);
+/// Export a module containing RTL, and SV dialect code.  The rtl.module
+/// operations are first rewritten into the form required by the emitter,
+/// unless the PrepareForEmission pass (see createPrepareForEmissionPass) has
+/// already done so as part of the pipeline of the caller.
+///
+/// If the `sourceMapIDs` lowering option is set, the source map table is
+/// written to \p sourceMapOS, or appended to \p os if no stream is given.
+mlir::LogicalResult exportVerilog(mlir::ModuleOp module, llvm::raw_ostream &os,
+                                  llvm::raw_ostream *sourceMapOS = nullptr);
 
 /// Export a module containing RTL, and SV dialect code, as one file per SV
-/// module. Requires that the SV dialect is loaded in to the context.
+/// module.  The rtl.module operations are prepared as for exportVerilog.
+///
+/// Files are created in the directory indicated by \p dirname.  If the
+/// `sourceMapIDs` lowering option is set, the source map table for all files
+/// is written to `sourcemap.txt` in the same directory.  Files whose contents
+/// did not change are not rewritten.
+///
+/// The rtl.module.extern operations named in \p reusedModules stand for
+/// modules whose files were emitted by an earlier run.  Their files are listed
+/// in `filelist.f`, but left alone.
+mlir::LogicalResult exportSplitVerilog(
+    mlir::ModuleOp module, llvm::StringRef dirname,
+    const llvm::StringSet<> *reusedModules = nullptr);
+
+/// Add passes to \p pm which emit the design into \p os one module at a time,
+/// as part of the pass pipeline, rather than after it.  The PrepareForEmission
+/// pass runs on each rtl.module right before it is emitted, in a nested
+/// pipeline.  Once emitted, the body of a module is freed.  The text of a
+/// module is written out as soon as the text of all the operations before it
+/// has been, so the output is the same as from exportVerilog.
 ///
-/// Files are created in the directory indicated by \p dirname.
-mlir::LogicalResult exportSplitVerilog(mlir::ModuleOp module,
-                                       llvm::StringRef dirname);
+/// The pipeline must run on the design once it is final, i.e. after any pass
+/// which renames symbols or ports.  It leaves an rtl.module.extern declaration
+/// behind in place of each emitted rtl.module.
+void buildStreamingExportVerilogPipeline(mlir::OpPassManager &pm,
+                                         llvm::raw_ostream &os,
+                                         llvm::raw_ostream *sourceMapOS);
 
 /// Register a translation for exporting RTL, Comb and SV to SystemVerilog.
 void registerToVerilogTranslation();
@@ -0,0 +1,31 @@
+//===- Passes.h - Translation Pass Construction and Registration *- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the declarations to register translation passes.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_TRANSLATION_PASSES_H
+#define CIRCT_TRANSLATION_PASSES_H
+
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassRegistry.h"
+
+#include <memory>
+
+namespace circt {
+
+std::unique_ptr<mlir::Pass> createPrepareForEmissionPass();
+
+// Generate the code for registering translation passes.
+#define GEN_PASS_REGISTRATION
+#include "circt/Translation/Passes.h.inc"
+
+} // namespace circt
+
+#endif // CIRCT_TRANSLATION_PASSES_H
@@ -0,0 +1,33 @@
+# REQUIRES: bindings_python
+# RUN: %PYTHON% %s | FileCheck %s
+
+import circt
+from circt import sim
+
+from mlir.ir import *
+
+with Context() as ctx, Location.unknown():
+  circt.register_dialects(ctx)
+
+  m = Module.parse("""
+rtl.module @Accumulator(%clk: i1, %rst: i1, %in: i72) -> (%sum: i72) {
+  %c0_i72 = rtl.constant 0 : i72
+  %next = comb.add %sum, %in : i72
+  %sum = seq.compreg %next, %clk, %rst, %c0_i72 : i72
+  rtl.output %sum : i72
+}
+""")
+
+  simulator = sim.CycleSimulator(m, "Accumulator")
+  # CHECK: ['clk', 'rst', 'in'] ['sum']
+  print(simulator.inputs, simulator.outputs)
+
+  simulator.set_input("in", 1 << 70)
+  simulator.step(3)
+  # CHECK: 3 3541774862152233910272
+  print(simulator.cycle, simulator.get_output("sum"))
+
+  simulator.set_input("rst", 1)
+  simulator.step()
+  # CHECK: 0
+  print(simulator.get_output("sum"))
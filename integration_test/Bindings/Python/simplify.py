@@ -0,0 +1,35 @@
+# REQUIRES: bindings_python
+# RUN: %PYTHON% %s | FileCheck %s
+
+import circt
+from circt import transforms
+
+from mlir.ir import *
+
+with Context() as ctx, Location.unknown():
+  circt.register_dialects(ctx)
+
+  m = Module.parse("""
+rtl.module @top(%a: i8, %b: i8) -> (%x: i8, %y: i8) {
+  %c-1_i8 = rtl.constant -1 : i8
+  %0 = comb.and %a, %c-1_i8 : i8
+  %1 = comb.or %0, %b : i8
+  %2 = comb.and %b, %c-1_i8 : i8
+  rtl.output %1, %2 : i8, i8
+}
+""")
+
+  top = m.body.operations[0]
+  ops = top.regions[0].blocks[0].operations
+  simplifier = transforms.IncrementalSimplifier(ctx)
+
+  # Only the fan-out cone of the first comb.and is simplified.
+  changed, num_erased = simplifier.simplify([ops[1].operation])
+  # CHECK: 1 1
+  print(len(changed), num_erased)
+  # CHECK: comb.or
+  print(changed[0])
+
+  # CHECK: comb.or %a, %b : i8
+  # CHECK: comb.and %b, %c-1_i8 : i8
+  print(m)
@@ -0,0 +1,314 @@
+//===- TimingAnalysis.cpp - Logic depth estimation for RTL ----------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the static timing analysis of rtl.module bodies.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Analysis/TimingAnalysis.h"
+#include "circt/Dialect/Comb/CombOps.h"
+#include "circt/Dialect/RTL/RTLOps.h"
+#include "circt/Dialect/SV/SVOps.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/MathExtras.h"
+
+using namespace circt;
+using namespace comb;
+
+//===----------------------------------------------------------------------===//
+// Delay models
+//===----------------------------------------------------------------------===//
+
+DelayModel::~DelayModel() = default;
+
+unsigned WeightedDelayModel::getDelay(Operation *op,
+                                      unsigned numOperands) const {
+  unsigned levels = llvm::Log2_32_Ceil(numOperands);
+  return TypeSwitch<Operation *, unsigned>(op)
+      .Case<AndOp, OrOp, XorOp>([&](auto) { return weights.logic * levels; })
+      .Case<AddOp, MulOp>([&](auto) { return weights.arith * levels; })
+      .Case<SubOp, DivUOp, DivSOp, ModUOp, ModSOp, ShlOp, ShrUOp, ShrSOp,
+            ICmpOp>([&](auto) { return weights.arith; })
+      .Case<MuxOp>([&](auto) { return weights.mux; })
+      .Case<rtl::ArrayGetOp>([&](rtl::ArrayGetOp get) {
+        auto size = get.input().getType().cast<rtl::ArrayType>().getSize();
+        return weights.mux * unsigned(llvm::Log2_64_Ceil(size));
+      })
+      .Case<ConcatOp, ExtractOp, SExtOp>([&](auto) { return 0U; })
+      .Default([&](Operation *other) {
+        return isa<CombDialect>(other->getDialect()) ? weights.logic : 0U;
+      });
+}
+
+//===----------------------------------------------------------------------===//
+// TimingAnalysis
+//===----------------------------------------------------------------------===//
+
+/// Return true if the results of the operation are computed combinationally
+/// from its operands.
+static bool isCombinational(Operation *op) {
+  if (isa<rtl::InstanceOp, rtl::OutputOp>(op) || op->getNumRegions() != 0)
+    return false;
+  return isa_and_nonnull<CombDialect, rtl::RTLDialect>(op->getDialect());
+}
+
+/// Return true if the operation reads a wire or an inout port, whose value is
+/// driven combinationally, rather than a register.
+static bool isTransparentRead(Operation *op) {
+  auto read = dyn_cast<sv::ReadInOutOp>(op);
+  return read && (read.input().isa<BlockArgument>() ||
+                  read.input().getDefiningOp<sv::WireOp>());
+}
+
+/// Return the arrival time of the values computed from \p fanIn by an
+/// operation with the specified delay.
+static Arrival addDelay(Arrival fanIn, unsigned delay) {
+  if (fanIn.fromRegs >= 0)
+    fanIn.fromRegs += delay;
+  if (fanIn.fromInputs >= 0)
+    fanIn.fromInputs += delay;
+  return fanIn;
+}
+
+/// Return the arrival time of the end of a path through an instance, where
+/// \p port is the arrival time of the end of the path in the instantiated
+/// module, and \p inputs the latest of the inputs of the instance.
+static Arrival throughInstance(const Arrival &port, const Arrival &inputs) {
+  Arrival result;
+  result.fromRegs = port.fromRegs;
+  if (port.fromInputs < 0)
+    return result;
+  if (inputs.fromRegs >= 0)
+    result.fromRegs =
+        std::max(result.fromRegs, inputs.fromRegs + port.fromInputs);
+  if (inputs.fromInputs >= 0)
+    result.fromInputs = inputs.fromInputs + port.fromInputs;
+  return result;
+}
+
+TimingAnalysis::TimingAnalysis(ModuleOp module, DelayModel &delayModel)
+    : delayModel(delayModel), symbolTable(module) {
+  for (auto rtlModule : module.getOps<rtl::RTLModuleOp>())
+    if (!moduleTimings.count(rtlModule))
+      analyzeModule(rtlModule);
+}
+
+const ModuleTiming *TimingAnalysis::getModuleTiming(Operation *module) const {
+  auto it = moduleTimings.find(module);
+  return it == moduleTimings.end() ? nullptr : &it->second;
+}
+
+ValueRange TimingAnalysis::getFanIn(Operation *op) const {
+  if (auto read = dyn_cast<sv::ReadInOutOp>(op)) {
+    if (auto wire = read.input().getDefiningOp<sv::WireOp>()) {
+      auto it = wireDrivers.find(wire);
+      if (it == wireDrivers.end())
+        return {};
+      return ArrayRef<Value>(it->second);
+    }
+    if (read.input().isa<BlockArgument>())
+      return op->getOperands();
+    return {};
+  }
+  if (isCombinational(op) || isa<rtl::InstanceOp>(op))
+    return op->getOperands();
+  return {};
+}
+
+/// Operations in graph regions may be used before they are defined, so they
+/// are visited in post order of their fan-in within the module, including the
+/// operations nested in procedural regions.  This way the arrival times of the
+/// fan-in of every operation are known when it is visited, and every operation
+/// is visited once.  Operations on a combinational cycle see the operations of
+/// the cycle which have not been visited yet as unreachable.
+void TimingAnalysis::analyzeModule(Operation *module) {
+  // Mark the module as being analyzed.
+  moduleTimings[module];
+
+  // Analyze the instantiated modules first, and find the drivers of wires.
+  auto &block = cast<rtl::RTLModuleOp>(module).getBody().front();
+  block.walk([&](Operation *op) {
+    if (auto instance = dyn_cast<rtl::InstanceOp>(op)) {
+      auto *child = symbolTable.lookup(instance.moduleName());
+      if (isa_and_nonnull<rtl::RTLModuleOp>(child) &&
+          !moduleTimings.count(child))
+        analyzeModule(child);
+    } else if (auto connect = dyn_cast<sv::ConnectOp>(op)) {
+      if (auto wire = connect.dest().getDefiningOp<sv::WireOp>())
+        wireDrivers[wire].push_back(connect.src());
+    }
+  });
+
+  for (auto arg : block.getArguments())
+    arrivals[arg].fromInputs = 0;
+
+  struct StackEntry {
+    Operation *op;
+    ValueRange fanIn;
+    unsigned next;
+  };
+  // The module is isolated from above, so the fan-in of every operation is
+  // defined in the module.
+  DenseSet<Operation *> visited;
+  SmallVector<StackEntry, 16> stack;
+  block.walk([&](Operation *root) {
+    if (!visited.insert(root).second)
+      return;
+    stack.push_back({root, getFanIn(root), 0});
+    while (!stack.empty()) {
+      auto &entry = stack.back();
+      if (entry.next != entry.fanIn.size()) {
+        auto *def = entry.fanIn[entry.next++].getDefiningOp();
+        if (def && visited.insert(def).second)
+          stack.push_back({def, getFanIn(def), 0});
+        continue;
+      }
+      auto *op = entry.op;
+      stack.pop_back();
+      visitOperation(op);
+    }
+  });
+
+  ModuleTiming timing;
+  collectEndpoints(module, timing);
+  moduleTimings[module] = std::move(timing);
+}
+
+void TimingAnalysis::visitOperation(Operation *op) {
+  if (op->getNumResults() == 0)
+    return;
+
+  Arrival fanIn;
+  for (auto value : getFanIn(op))
+    fanIn.merge(getArrival(value));
+
+  // The results of an instance are reached by the paths to the outputs of the
+  // instantiated module.  The outputs of external modules start new paths.
+  if (auto instance = dyn_cast<rtl::InstanceOp>(op)) {
+    auto *timing =
+        getModuleTiming(symbolTable.lookup(instance.moduleName()));
+    for (auto result : instance.getResults()) {
+      Arrival arrival;
+      if (timing && result.getResultNumber() < timing->outputs.size())
+        arrival = throughInstance(timing->outputs[result.getResultNumber()],
+                                  fanIn);
+      else
+        arrival.fromRegs = 0;
+      if (arrival.get() >= 0)
+        arrivals[result] = arrival;
+    }
+    return;
+  }
+
+  Arrival arrival;
+  if (isCombinational(op))
+    arrival = addDelay(fanIn, delayModel.getDelay(op));
+  else if (isTransparentRead(op))
+    arrival = fanIn;
+  else
+    arrival.fromRegs = 0;
+
+  // Declarations of wires and registers only start paths where they are read.
+  if (arrival.get() < 0)
+    return;
+  for (auto result : op->getResults())
+    if (!result.getType().isa<rtl::InOutType>())
+      arrivals[result] = arrival;
+}
+
+/// Find the ends of the paths of the module: its outputs, the operands of the
+/// operations which start new paths, including the operations nested in
+/// procedural regions, and the registers of the instantiated modules.
+void TimingAnalysis::collectEndpoints(Operation *module, ModuleTiming &timing) {
+  auto addEndpoint = [&](Operation *op, Value value, const Arrival &arrival) {
+    if (arrival.get() <= timing.criticalPath)
+      return;
+    timing.criticalPath = arrival.get();
+    timing.criticalEndpoint = op;
+    timing.criticalValue = value;
+  };
+
+  module->walk([&](Operation *op) {
+    if (op == module)
+      return;
+
+    if (auto output = dyn_cast<rtl::OutputOp>(op)) {
+      for (auto operand : output.getOperands()) {
+        timing.outputs.push_back(getArrival(operand));
+        addEndpoint(op, operand, timing.outputs.back());
+      }
+      return;
+    }
+
+    if (auto instance = dyn_cast<rtl::InstanceOp>(op)) {
+      auto *child = getModuleTiming(symbolTable.lookup(instance.moduleName()));
+      if (child) {
+        Arrival inputs;
+        Value latest;
+        for (auto input : instance.inputs()) {
+          auto arrival = getArrival(input);
+          inputs.merge(arrival);
+          if (!latest || arrival.get() > getArrival(latest).get())
+            latest = input;
+        }
+        auto arrival = throughInstance(child->registers, inputs);
+        timing.registers.merge(arrival);
+        addEndpoint(op, latest, arrival);
+        return;
+      }
+    }
+
+    if (isCombinational(op) || isTransparentRead(op))
+      return;
+    if (auto connect = dyn_cast<sv::ConnectOp>(op))
+      if (connect.dest().getDefiningOp<sv::WireOp>())
+        return;
+
+    for (auto operand : op->getOperands()) {
+      auto arrival = getArrival(operand);
+      timing.registers.merge(arrival);
+      addEndpoint(op, operand, arrival);
+    }
+  });
+}
+
+SmallVector<Operation *, 8>
+TimingAnalysis::getCriticalPath(Operation *module) const {
+  SmallVector<Operation *, 8> path;
+  auto *timing = getModuleTiming(module);
+  if (!timing || !timing->criticalEndpoint)
+    return path;
+
+  // Walk back from the end of the path through the latest value of the fan-in
+  // of each operation.  The visited set stops the walk on combinational
+  // cycles.
+  path.push_back(timing->criticalEndpoint);
+  DenseSet<Operation *> visited;
+  auto value = timing->criticalValue;
+  while (auto *op = value ? value.getDefiningOp() : nullptr) {
+    if (!visited.insert(op).second)
+      break;
+    path.push_back(op);
+    if (isa<rtl::InstanceOp>(op))
+      break;
+
+    value = {};
+    int latest = -1;
+    for (auto input : getFanIn(op)) {
+      int arrival = getArrival(input).get();
+      if (arrival > latest) {
+        latest = arrival;
+        value = input;
+      }
+    }
+  }
+
+  std::reverse(path.begin(), path.end());
+  return path;
+}
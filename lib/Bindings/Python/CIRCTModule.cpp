@@ -13,6 +13,7 @@
 #include "circt-c/Dialect/MSFT.h"
 #include "circt-c/Dialect/RTL.h"
 #include "circt-c/Dialect/SV.h"
+#include "circt-c/Dialect/Seq.h"
 #include "circt-c/ExportVerilog.h"
 #include "mlir-c/Bindings/Python/Interop.h"
 #include "mlir-c/Registration.h"
@@ -57,6 +58,10 @@ PYBIND11_MODULE(_circt, m) {
         MlirDialectHandle sv = mlirGetDialectHandle__sv__();
         mlirDialectHandleRegisterDialect(sv, context);
         mlirDialectHandleLoadDialect(sv, context);
+
+        MlirDialectHandle seq = mlirGetDialectHandle__seq__();
+        mlirDialectHandleRegisterDialect(seq, context);
+        mlirDialectHandleLoadDialect(seq, context);
       },
       "Register CIRCT dialects on a PyMlirContext.");
 
@@ -70,4 +75,8 @@ PYBIND11_MODULE(_circt, m) {
   circt::python::populateDialectESISubmodule(esi);
   py::module msft = m.def_submodule("msft", "MSFT API");
   circt::python::populateDialectMSFTSubmodule(msft);
+  py::module sim = m.def_submodule("sim", "Cycle-based simulation API");
+  circt::python::populateSimSubmodule(sim);
+  py::module transforms = m.def_submodule("transforms", "Transforms API");
+  circt::python::populateTransformsSubmodule(transforms);
 }
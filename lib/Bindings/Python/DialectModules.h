@@ -20,6 +20,8 @@ namespace python {
 
 void populateDialectESISubmodule(pybind11::module &m);
 void populateDialectMSFTSubmodule(pybind11::module &m);
+void populateSimSubmodule(pybind11::module &m);
+void populateTransformsSubmodule(pybind11::module &m);
 
 } // namespace python
 } // namespace circt
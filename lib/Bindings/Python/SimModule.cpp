@@ -0,0 +1,99 @@
+//===- SimModule.cpp - Cycle simulator pybind module ----------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "DialectModules.h"
+
+#include "circt/Dialect/Seq/Simulator/CycleSimulator.h"
+#include "circt/Support/LLVM.h"
+
+#include "mlir/CAPI/IR.h"
+#include "mlir/CAPI/Support.h"
+
+#include "PybindUtils.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+namespace py = pybind11;
+
+using namespace circt;
+using namespace circt::seq::sim;
+
+//===----------------------------------------------------------------------===//
+// Functions that translate from something Pybind11 understands to MLIR C++.
+//===----------------------------------------------------------------------===//
+
+static std::unique_ptr<CycleSimulator> createSimulator(MlirModule mod,
+                                                       std::string top) {
+  auto simulator = CycleSimulator::create(unwrap(mod), top);
+  if (!simulator)
+    throw py::value_error("cannot simulate module '" + top + "'");
+  return simulator;
+}
+
+static unsigned lookupPort(CycleSimulator &simulator, const std::string &name,
+                           bool isInput) {
+  auto index = isInput ? simulator.lookupInput(name)
+                       : simulator.lookupOutput(name);
+  if (!index)
+    throw py::key_error("unknown " + std::string(isInput ? "input" : "output") +
+                        " port '" + name + "'");
+  return *index;
+}
+
+/// Python integers are arbitrarily wide, so values are passed through their
+/// hexadecimal string representation.
+static void setInput(CycleSimulator &simulator, const std::string &name,
+                     py::int_ value) {
+  auto index = lookupPort(simulator, name, /*isInput=*/true);
+  if (value < py::int_(0))
+    throw py::value_error("port values must not be negative");
+  std::string hex =
+      py::str(py::module::import("builtins").attr("format")(value, "x"));
+  simulator.setInput(index, APInt(4 * hex.size(), hex, 16));
+}
+
+static py::int_ getOutput(CycleSimulator &simulator, const std::string &name) {
+  auto value = simulator.getOutput(lookupPort(simulator, name, false));
+  return py::int_(py::module::import("builtins")
+                      .attr("int")(value.toString(16, /*Signed=*/false), 16));
+}
+
+/// Populate the sim python module.
+void circt::python::populateSimSubmodule(py::module &m) {
+  m.doc() = "Cycle-based simulator Python native extension";
+
+  py::class_<CycleSimulator>(m, "CycleSimulator")
+      .def(py::init(&createSimulator),
+           "Build a simulator for the named top-level module.",
+           py::arg("module"), py::arg("top"))
+      .def("set_input", &setInput, "Set the value of an input port.",
+           py::arg("name"), py::arg("value"))
+      .def("get_output", &getOutput, "Return the value of an output port.",
+           py::arg("name"))
+      .def(
+          "step",
+          [](CycleSimulator &simulator, uint64_t cycles) {
+            py::gil_scoped_release release;
+            simulator.step(cycles);
+          },
+          "Advance the simulation by a number of clock cycles.",
+          py::arg("cycles") = 1)
+      .def_property_readonly("cycle", &CycleSimulator::getCycle)
+      .def_property_readonly("inputs",
+                             [](CycleSimulator &simulator) {
+                               std::vector<std::string> names;
+                               for (auto &port : simulator.getInputs())
+                                 names.push_back(port.name.getValue().str());
+                               return names;
+                             })
+      .def_property_readonly("outputs", [](CycleSimulator &simulator) {
+        std::vector<std::string> names;
+        for (auto &port : simulator.getOutputs())
+          names.push_back(port.name.getValue().str());
+        return names;
+      });
+}
@@ -0,0 +1,66 @@
+//===- TransformsModule.cpp - Transforms pybind module --------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "DialectModules.h"
+
+#include "circt-c/Transforms.h"
+
+#include "PybindUtils.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+namespace py = pybind11;
+
+namespace {
+/// Owns an incremental simplifier built through the C API.
+class PyIncrementalSimplifier {
+public:
+  PyIncrementalSimplifier(MlirContext context)
+      : simplifier(mlirIncrementalSimplifierCreate(context)) {}
+  ~PyIncrementalSimplifier() { mlirIncrementalSimplifierDestroy(simplifier); }
+  PyIncrementalSimplifier(const PyIncrementalSimplifier &) = delete;
+  void operator=(const PyIncrementalSimplifier &) = delete;
+
+  /// Simplify the fan-out cone of the operations, and return the operations
+  /// which were created or modified along with the number of operations
+  /// erased.
+  py::tuple simplify(const std::vector<MlirOperation> &ops) {
+    std::vector<MlirOperation> changedOps;
+    intptr_t numErased = mlirIncrementalSimplifierRun(
+        simplifier, ops.size(), ops.data(),
+        [](MlirOperation op, void *userData) {
+          static_cast<std::vector<MlirOperation> *>(userData)->push_back(op);
+        },
+        &changedOps);
+
+    py::list changed;
+    for (auto op : changedOps)
+      changed.append(py::cast(op));
+    return py::make_tuple(changed, numErased);
+  }
+
+private:
+  MlirIncrementalSimplifier simplifier;
+};
+} // end anonymous namespace
+
+/// Populate the transforms python module.
+void circt::python::populateTransformsSubmodule(py::module &m) {
+  m.doc() = "CIRCT transforms Python native extension";
+
+  py::class_<PyIncrementalSimplifier>(m, "IncrementalSimplifier")
+      .def(py::init<MlirContext>(),
+           "Build a simplifier using the canonicalization patterns of all "
+           "operations registered in the context.",
+           py::arg("context"))
+      .def("simplify", &PyIncrementalSimplifier::simplify,
+           "Fold and canonicalize the operations and their transitive users. "
+           "Returns the operations which were created or modified, and the "
+           "number of operations erased.  Python objects referring to erased "
+           "operations must not be used afterwards.",
+           py::arg("ops"));
+}
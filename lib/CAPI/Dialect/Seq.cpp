@@ -0,0 +1,11 @@
+//===- Seq.cpp - C Interface for the Seq Dialect --------------------------===//
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt-c/Dialect/Seq.h"
+#include "circt/Dialect/Seq/SeqDialect.h"
+#include "mlir/CAPI/IR.h"
+#include "mlir/CAPI/Registration.h"
+#include "mlir/CAPI/Support.h"
+
+MLIR_DEFINE_CAPI_DIALECT_REGISTRATION(Sequential, seq, circt::seq::SeqDialect)
@@ -0,0 +1,38 @@
+//===- Transforms.cpp - C Interface for CIRCT transforms ------------------===//
+//
+//  Implements a C Interface for the incremental simplifier.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt-c/Transforms.h"
+
+#include "circt/Transforms/IncrementalSimplifier.h"
+#include "mlir/CAPI/IR.h"
+#include "mlir/CAPI/Wrap.h"
+
+using namespace circt;
+
+DEFINE_C_API_PTR_METHODS(MlirIncrementalSimplifier, IncrementalSimplifier)
+
+MlirIncrementalSimplifier mlirIncrementalSimplifierCreate(MlirContext context) {
+  return wrap(new IncrementalSimplifier(unwrap(context)));
+}
+
+void mlirIncrementalSimplifierDestroy(MlirIncrementalSimplifier simplifier) {
+  delete unwrap(simplifier);
+}
+
+intptr_t mlirIncrementalSimplifierRun(MlirIncrementalSimplifier simplifier,
+                                      intptr_t numOps, MlirOperation const *ops,
+                                      MlirOperationCallback changedCallback,
+                                      void *userData) {
+  SmallVector<Operation *, 8> changedOps;
+  changedOps.reserve(numOps);
+  for (intptr_t i = 0; i != numOps; ++i)
+    changedOps.push_back(unwrap(ops[i]));
+
+  auto result = unwrap(simplifier)->simplify(changedOps);
+  for (auto *op : result.changedOps)
+    changedCallback(wrap(op), userData);
+  return result.numErased;
+}
@@ -19,6 +19,7 @@
 #include "circt/Dialect/RTL/RTLTypes.h"
 #include "circt/Dialect/SV/SVOps.h"
 #include "circt/Support/ImplicitLocOpBuilder.h"
+#include "circt/Support/ParallelScheduling.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/Pass/Pass.h"
 #include "llvm/ADT/StringSet.h"
@@ -212,6 +213,10 @@ struct CircuitLoweringState {
       used_RANDOMIZE_MEM_INIT{false};
   std::atomic<bool> used_RANDOMIZE_GARBAGE_ASSIGN{false};
 
+  /// The number of operations created and erased while lowering module
+  /// bodies, reported through the pass statistics.
+  std::atomic<size_t> numCreatedOps{0}, numErasedOps{0};
+
   CircuitLoweringState(CircuitOp circuitOp) : circuitOp(circuitOp) {}
 
   Operation *getNewModule(Operation *oldModule) {
@@ -321,15 +326,14 @@ void FIRRTLModuleLowering::runOnOperation() {
 
   // Now that we've lowered all of the modules, move the bodies over and update
   // any instances that refer to the old modules.
-  if (getContext().isMultithreadingEnabled()) {
-    mlir::ParallelDiagnosticHandler diagHandler(&getContext());
-    llvm::parallelForEachN(0, modulesToProcess.size(), [&](auto index) {
-      lowerModuleBody(modulesToProcess[index], state);
-    });
-  } else {
-    for (auto module : modulesToProcess)
-      lowerModuleBody(module, state);
-  }
+  SmallVector<Operation *, 32> moduleOps;
+  for (auto module : modulesToProcess)
+    moduleOps.push_back(module);
+  parallelForEachLargestFirst(&getContext(), moduleOps, [&](size_t index) {
+    lowerModuleBody(modulesToProcess[index], state);
+  });
+  numCreatedOps += state.numCreatedOps;
+  numErasedOps += state.numErasedOps;
 
   // Finally delete all the old modules.
   for (auto oldNew : state.oldToNewModuleMap)
@@ -841,7 +845,7 @@ struct FIRRTLLowering : public FIRRTLVisitor<FIRRTLLowering, LogicalResult> {
 
   FIRRTLLowering(rtl::RTLModuleOp module, CircuitLoweringState &circuitState)
       : theModule(module), circuitState(circuitState),
-        builder(module.getLoc(), module.getContext()) {}
+        builder(module.getLoc(), module.getContext(), &createdOpCounter) {}
 
   void run();
 
@@ -853,7 +857,9 @@ struct FIRRTLLowering : public FIRRTLVisitor<FIRRTLLowering, LogicalResult> {
                                bool isSigned = false) {
     return getOrCreateIntConstant(APInt(numBits, val, isSigned));
   }
+  Value &getConstantMapEntry(const APInt &value);
   Value getPossiblyInoutLoweredValue(Value value);
+  Value getDirectlyConnectedValue(InstanceOp instance, Value input);
   Value getLoweredValue(Value value);
   Value getLoweredAndExtendedValue(Value value, Type destType);
   Value getLoweredAndExtOrTruncValue(Value value, Type destType);
@@ -1024,6 +1030,14 @@ private:
   /// Global state.
   CircuitLoweringState &circuitState;
 
+  /// Counts the operations inserted by the builders of the lowering, so that
+  /// the number of created operations can be reported without walking the
+  /// module.
+  struct CreatedOpCounter : public OpBuilder::Listener {
+    void notifyOperationInserted(Operation *op) override { ++numCreatedOps; }
+    size_t numCreatedOps = 0;
+  } createdOpCounter;
+
   /// This builder is set to the right location for each visit call.
   ImplicitLocOpBuilder builder;
 
@@ -1033,8 +1047,19 @@ private:
   DenseMap<Value, Value> valueMapping;
 
   /// This keeps track of constants that we have created so we can reuse them.
-  /// This is populated by the getOrCreateIntConstant method.
+  /// This is populated by the getOrCreateIntConstant method.  Constants which
+  /// fit in 64 bits are looked up by width and value, which avoids uniquing an
+  /// attribute in the (shared) context for every use of a constant.
   DenseMap<Attribute, Value> rtlConstantMap;
+  DenseMap<std::pair<unsigned, uint64_t>, Value> smallConstantMap;
+
+  /// Reads of inout values at the top level of the module are continuous, so
+  /// a single read of each value is shared by all of its top level users.
+  DenseMap<Value, Value> moduleLevelReads;
+
+  /// Connects to instance inputs which were folded directly in to the operands
+  /// of the lowered instance.  These need no further lowering.
+  SmallPtrSet<Operation *, 8> directlyLoweredConnects;
 
   // We auto-unique graph-level blocks to reduce the amount of generated
   // code and ensure that side effects are properly ordered in FIRRTL.
@@ -1054,6 +1079,9 @@ private:
   /// This is true if we've emitted `INIT_RANDOM_PROLOG_ into an initial
   /// block in this module already.
   bool randomizePrologEmitted;
+
+  /// The number of operations erased while lowering this module.
+  size_t numErasedOps = 0;
 };
 } // end anonymous namespace
 
@@ -1101,13 +1129,18 @@ void FIRRTLLowering::run() {
   while (!opsToRemove.empty()) {
     assert(opsToRemove.back()->use_empty() &&
            "Should remove ops in reverse order of visitation");
-    opsToRemove.pop_back_val()->erase();
+    auto *op = opsToRemove.pop_back_val();
+    op->walk([&](Operation *) { ++numErasedOps; });
+    op->erase();
   }
 
   // Now that the IR is in a stable form, try to eliminate temporary wires
   // inserted by MemOp insertions.
   for (auto wire : tmpWiresToOptimize)
     optimizeTemporaryWire(wire);
+
+  circuitState.numCreatedOps += createdOpCounter.numCreatedOps;
+  circuitState.numErasedOps += numErasedOps;
 }
 
 // Try to optimize out temporary wires introduced during lowering.
@@ -1149,6 +1182,7 @@ void FIRRTLLowering::optimizeTemporaryWire(sv::WireOp wire) {
   // And remove the write and wire itself.
   write.erase();
   wire.erase();
+  numErasedOps += reads.size() + 2;
 }
 
 //===----------------------------------------------------------------------===//
@@ -1158,18 +1192,25 @@ void FIRRTLLowering::optimizeTemporaryWire(sv::WireOp wire) {
 /// Check to see if we've already lowered the specified constant.  If so, return
 /// it.  Otherwise create it and put it in the entry block for reuse.
 Value FIRRTLLowering::getOrCreateIntConstant(const APInt &value) {
-  auto attr = builder.getIntegerAttr(
-      builder.getIntegerType(value.getBitWidth()), value);
-
-  auto &entry = rtlConstantMap[attr];
+  auto &entry = getConstantMapEntry(value);
   if (entry)
     return entry;
 
-  OpBuilder entryBuilder(&theModule.getBodyBlock()->front());
-  entry = entryBuilder.create<rtl::ConstantOp>(builder.getLoc(), attr);
+  OpBuilder entryBuilder(&theModule.getBodyBlock()->front(),
+                         &createdOpCounter);
+  entry = entryBuilder.create<rtl::ConstantOp>(builder.getLoc(), value);
   return entry;
 }
 
+/// Return the entry in the constant maps for the specified value.  This is
+/// null if the constant hasn't been created yet.
+Value &FIRRTLLowering::getConstantMapEntry(const APInt &value) {
+  if (value.getBitWidth() <= 64)
+    return smallConstantMap[{value.getBitWidth(), value.getZExtValue()}];
+  return rtlConstantMap[builder.getIntegerAttr(
+      builder.getIntegerType(value.getBitWidth()), value)];
+}
+
 /// Zero bit operands end up looking like failures from getLoweredValue.  This
 /// helper function invokes the closure specified if the operand was actually
 /// zero bit, or returns failure() if it was some other kind of failure.
@@ -1204,10 +1245,18 @@ Value FIRRTLLowering::getLoweredValue(Value value) {
 
   // If we got an inout value, implicitly read it.  FIRRTL allows direct use
   // of wires and other things that lower to inout type.
-  if (result.getType().isa<rtl::InOutType>())
+  if (!result.getType().isa<rtl::InOutType>())
+    return result;
+
+  // Reads within procedural regions depend on their position, so each use
+  // gets its own read.
+  if (builder.getInsertionBlock() != theModule.getBodyBlock())
     return builder.createOrFold<sv::ReadInOutOp>(result);
 
-  return result;
+  auto &read = moduleLevelReads[result];
+  if (!read)
+    read = builder.createOrFold<sv::ReadInOutOp>(result);
+  return read;
 }
 
 /// Return the lowered value corresponding to the specified original value and
@@ -1351,7 +1400,7 @@ LogicalResult FIRRTLLowering::setPossiblyFoldedLowering(Value orig,
   // If this is a constant, check to see if we have it in our unique mapping:
   // it could have come from folding an operation.
   if (auto cst = dyn_cast_or_null<rtl::ConstantOp>(result.getDefiningOp())) {
-    auto &entry = rtlConstantMap[cst.valueAttr()];
+    auto &entry = getConstantMapEntry(cst.getValue());
     if (entry == cst) {
       // We're already using an entry in the constant map, nothing to do.
     } else if (entry) {
@@ -1813,6 +1862,30 @@ LogicalResult FIRRTLLowering::visitDecl(MemOp op) {
   return success();
 }
 
+/// If the specified instance input is driven by a single connect in the same
+/// block as the instance, and the source of the connect has already been
+/// lowered, return the lowered source and mark the connect as lowered.
+/// Otherwise return null.
+Value FIRRTLLowering::getDirectlyConnectedValue(InstanceOp instance,
+                                                Value input) {
+  if (!input.hasOneUse())
+    return {};
+  auto connect = dyn_cast<ConnectOp>(*input.getUsers().begin());
+  if (!connect || connect.dest() != input ||
+      connect->getBlock() != instance->getBlock())
+    return {};
+
+  // Only sources which have been lowered are defined before the instance.
+  if (!getPossiblyInoutLoweredValue(connect.src()))
+    return {};
+
+  auto destType = input.getType().cast<FIRRTLType>().getPassiveType();
+  auto value = getLoweredAndExtendedValue(connect.src(), destType);
+  if (value)
+    directlyLoweredConnects.insert(connect);
+  return value;
+}
+
 LogicalResult FIRRTLLowering::visitDecl(InstanceOp oldInstance) {
   auto *oldModule =
       circuitState.circuitOp.lookupSymbol(oldInstance.moduleName());
@@ -1866,6 +1939,15 @@ LogicalResult FIRRTLLowering::visitDecl(InstanceOp oldInstance) {
     auto portResult = oldInstance.getResult(portIndicesByName[port.name]);
     assert(portResult && "invalid IR, couldn't find port");
 
+    // If the input is driven by a single connect from a value which has
+    // already been lowered, use that value directly instead of going through
+    // a temporary wire.
+    if (!port.isInOut())
+      if (auto value = getDirectlyConnectedValue(oldInstance, portResult)) {
+        operands.push_back(value);
+        continue;
+      }
+
     // Create a wire for each input/inout operand, so there is
     // something to connect to.
     Value wire =
@@ -2336,6 +2418,10 @@ LogicalResult FIRRTLLowering::visitStmt(SkipOp op) {
 }
 
 LogicalResult FIRRTLLowering::visitStmt(ConnectOp op) {
+  // Connects to instance inputs may have been lowered with the instance.
+  if (directlyLoweredConnects.erase(op))
+    return success();
+
   auto dest = op.dest();
   // The source can be a smaller integer, extend it as appropriate if so.
   auto destType = dest.getType().cast<FIRRTLType>().getPassiveType();
@@ -19,14 +19,10 @@
 using namespace mlir;
 using namespace circt;
 using namespace comb;
+using rtl::getIntAttr;
 
 using mlir::constFoldBinaryOp;
 
-static Attribute getIntAttr(const APInt &value, MLIRContext *context) {
-  return IntegerAttr::get(IntegerType::get(context, value.getBitWidth()),
-                          value);
-}
-
 namespace {
 struct ConstantIntMatcher {
   APInt &value;
@@ -146,28 +142,24 @@ OpFoldResult ExtractOp::fold(ArrayRef<Attribute> constants) {
 
 // Reduce all operands to a single value by applying the `calculate` function.
 // This will fail if any of the operands are not constant.
-template <class AttrElementT,
-          class ElementValueT = typename AttrElementT::ValueType,
-          class CalculationT =
-              function_ref<ElementValueT(ElementValueT, ElementValueT)>>
-static Attribute constFoldVariadicOp(ArrayRef<Attribute> operands,
-                                     const CalculationT &calculate) {
+static Attribute
+constFoldVariadicOp(ArrayRef<Attribute> operands,
+                    function_ref<void(APInt &, const APInt &)> calculate) {
   if (!operands.size())
     return {};
 
   if (!operands[0])
     return {};
 
-  ElementValueT accum = operands[0].cast<AttrElementT>().getValue();
+  APInt accum = operands[0].cast<IntegerAttr>().getValue();
   for (auto i = operands.begin() + 1, end = operands.end(); i != end; ++i) {
     auto attr = *i;
     if (!attr)
       return {};
 
-    auto typedAttr = attr.cast<AttrElementT>();
-    calculate(accum, typedAttr.getValue());
+    calculate(accum, attr.cast<IntegerAttr>().getValue());
   }
-  return AttrElementT::get(operands[0].getType(), accum);
+  return getIntAttr(accum, operands[0].getContext());
 }
 
 OpFoldResult AndOp::fold(ArrayRef<Attribute> constants) {
@@ -192,8 +184,8 @@ OpFoldResult AndOp::fold(ArrayRef<Attribute> constants) {
     return inputs()[0];
 
   // Constant fold
-  return constFoldVariadicOp<IntegerAttr>(
-      constants, [](APInt &a, const APInt &b) { a &= b; });
+  return constFoldVariadicOp(constants,
+                             [](APInt &a, const APInt &b) { a &= b; });
 }
 
 LogicalResult AndOp::canonicalize(AndOp op, PatternRewriter &rewriter) {
@@ -291,8 +283,8 @@ OpFoldResult OrOp::fold(ArrayRef<Attribute> constants) {
     return inputs()[0];
 
   // Constant fold
-  return constFoldVariadicOp<IntegerAttr>(
-      constants, [](APInt &a, const APInt &b) { a |= b; });
+  return constFoldVariadicOp(constants,
+                             [](APInt &a, const APInt &b) { a |= b; });
 }
 
 LogicalResult OrOp::canonicalize(OrOp op, PatternRewriter &rewriter) {
@@ -342,7 +334,8 @@ OpFoldResult XorOp::fold(ArrayRef<Attribute> constants) {
 
   // xor(x, x) -> 0 -- idempotent
   if (size == 2 && inputs()[0] == inputs()[1])
-    return IntegerAttr::get(getType(), 0);
+    return getIntAttr(APInt(getType().getIntOrFloatBitWidth(), 0),
+                      getContext());
 
   // xor(x, 0) -> x
   if (constants.size() == 2 && constants[1] &&
@@ -350,8 +343,8 @@ OpFoldResult XorOp::fold(ArrayRef<Attribute> constants) {
     return inputs()[0];
 
   // Constant fold
-  return constFoldVariadicOp<IntegerAttr>(
-      constants, [](APInt &a, const APInt &b) { a ^= b; });
+  return constFoldVariadicOp(constants,
+                             [](APInt &a, const APInt &b) { a ^= b; });
 }
 
 LogicalResult XorOp::canonicalize(XorOp op, PatternRewriter &rewriter) {
@@ -427,8 +420,8 @@ OpFoldResult AddOp::fold(ArrayRef<Attribute> constants) {
     return inputs()[0];
 
   // Constant fold
-  return constFoldVariadicOp<IntegerAttr>(
-      constants, [](APInt &a, const APInt &b) { a += b; });
+  return constFoldVariadicOp(constants,
+                             [](APInt &a, const APInt &b) { a += b; });
 }
 
 LogicalResult AddOp::canonicalize(AddOp op, PatternRewriter &rewriter) {
@@ -529,8 +522,8 @@ OpFoldResult MulOp::fold(ArrayRef<Attribute> constants) {
   }
 
   // Constant fold
-  return constFoldVariadicOp<IntegerAttr>(
-      constants, [](APInt &a, const APInt &b) { a *= b; });
+  return constFoldVariadicOp(constants,
+                             [](APInt &a, const APInt &b) { a *= b; });
 }
 
 LogicalResult MulOp::canonicalize(MulOp op, PatternRewriter &rewriter) {
@@ -841,14 +834,14 @@ OpFoldResult ICmpOp::fold(ArrayRef<Attribute> constants) {
   // gte a, a -> true
   if (lhs() == rhs()) {
     auto val = applyCmpPredicateToEqualOperands(predicate());
-    return IntegerAttr::get(getType(), val);
+    return getIntAttr(APInt(1, val), getContext());
   }
 
   // gt 1, 2 -> false
   if (auto lhs = constants[0].dyn_cast_or_null<IntegerAttr>()) {
     if (auto rhs = constants[1].dyn_cast_or_null<IntegerAttr>()) {
       auto val = applyCmpPredicate(predicate(), lhs.getValue(), rhs.getValue());
-      return IntegerAttr::get(getType(), val);
+      return getIntAttr(APInt(1, val), getContext());
     }
   }
   return {};
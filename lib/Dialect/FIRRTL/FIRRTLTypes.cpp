@@ -648,9 +648,16 @@ FIRRTLType BundleType::getPassiveType() {
 
 /// Look up an element by name.  This returns a BundleElement with.
 auto BundleType::getElement(StringRef name) -> Optional<BundleElement> {
-  for (const auto &element : getElements()) {
-    if (element.name.getValue() == name)
-      return element;
+  if (auto index = getElementIndex(name))
+    return getElements()[index.getValue()];
+  return None;
+}
+
+/// Look up an element index by name.
+Optional<unsigned> BundleType::getElementIndex(StringRef name) {
+  for (auto it : llvm::enumerate(getElements())) {
+    if (it.value().name.getValue() == name)
+      return unsigned(it.index());
   }
   return None;
 }
@@ -115,11 +115,12 @@ struct GlobalFIRParserState {
   /// file).  This is null if no annotations were provided.
   const llvm::MemoryBuffer *annotationsBuf;
 
-  /// A mutable reference to the current CircuitTarget.
-  StringRef circuitTarget;
+  /// The current CircuitTarget, e.g., "~Foo".
+  SmallString<32> circuitTarget;
 
-  /// A mutable reference to the current ModuleTarget.
-  StringRef moduleTarget;
+  /// The current ModuleTarget, e.g., "~Foo|Bar".  This storage is reused for
+  /// every module in the circuit to avoid a heap allocation per module.
+  SmallString<64> moduleTarget;
 
   // Cached annotation for DontTouch.
   DictionaryAttr dontTouchAnnotation;
@@ -288,7 +289,7 @@ struct FIRParser {
 
   /// Populate a vector of annotations for a given Target.  If the annotations
   /// parameter is non-empty, then this will be appended to.
-  void getAnnotations(Twine target, ArrayAttr &annotations);
+  void getAnnotations(const Twine &target, ArrayAttr &annotations);
 
   /// Returns true if the annotation list contains the DontTouchAnnotation. This
   /// method is slightly more efficient than other lookup methods, because it
@@ -870,23 +871,28 @@ ParseResult FIRParser::importAnnotationFile(SMLoc loc) {
   return result;
 }
 
-void FIRParser::getAnnotations(Twine target, ArrayAttr &annotations) {
+void FIRParser::getAnnotations(const Twine &target, ArrayAttr &annotations) {
   // Early exit if no annotations exist.  This avoids the cost of
   // constructing strings representing targets if no annotation can
   // possibly exist.
   if (state.annotationMap.begin() == state.annotationMap.end())
     return;
 
+  // Flatten the target into a stack buffer.  Targets that are already a single
+  // string (e.g. the module target) are returned as-is without copying.
+  SmallString<128> targetBuffer;
+  StringRef targetStr = target.toStringRef(targetBuffer);
+
   // Input annotations is empty.  Just do the lookup and return.
   if (!annotations) {
-    annotations = state.annotationMap.lookup(target.str());
+    annotations = state.annotationMap.lookup(targetStr);
     return;
   }
 
   // Input annotations is non-empty.  Exit quickly if the target doesn't exist.
   // Otherwise, construct a new ArrayAttr that includes existing and new
   // annotations.
-  auto newAnnotations = state.annotationMap.lookup(target.str());
+  auto newAnnotations = state.annotationMap.lookup(targetStr);
   if (!newAnnotations)
     return;
 
@@ -969,6 +975,15 @@ public:
 
   /// Return the current modulet target, e.g., "~Foo|Bar".
   StringRef getModuleTarget() { return getState().moduleTarget; }
+
+  /// Set the current module target to "<circuitTarget>|<moduleName>", reusing
+  /// the storage held in the global parser state.
+  void setModuleTarget(StringRef moduleName) {
+    auto &moduleTarget = getState().moduleTarget;
+    moduleTarget = getState().circuitTarget;
+    moduleTarget += '|';
+    moduleTarget += moduleName;
+  }
 };
 } // end anonymous namespace
 
@@ -2767,8 +2782,7 @@ ParseResult FIRModuleParser::parseExtModule(unsigned indent) {
   if (parseId(name, "expected module name"))
     return failure();
 
-  auto moduleTarget = (getState().circuitTarget + "|" + name.getValue()).str();
-  getState().moduleTarget = moduleTarget;
+  setModuleTarget(name.getValue());
 
   if (parseToken(FIRToken::colon, "expected ':' in extmodule definition") ||
       parseOptionalInfo(info) || parsePortList(portListAndLoc, indent))
@@ -2849,7 +2863,7 @@ ParseResult FIRModuleParser::parseExtModule(unsigned indent) {
   }
 
   ArrayAttr annotations;
-  getAnnotations(moduleTarget, annotations);
+  getAnnotations(getModuleTarget(), annotations);
 
   auto fmodule = builder.create<FExtModuleOp>(info.getLoc(), name, portList,
                                               defName, annotations);
@@ -2873,8 +2887,7 @@ ParseResult FIRModuleParser::parseModule(unsigned indent) {
   if (parseId(name, "expected module name"))
     return failure();
 
-  auto moduleTarget = (getState().circuitTarget + "|" + name.getValue()).str();
-  getState().moduleTarget = moduleTarget;
+  setModuleTarget(name.getValue());
 
   if (parseToken(FIRToken::colon, "expected ':' in module definition") ||
       parseOptionalInfo(info) || parsePortList(portListAndLoc, indent))
@@ -2888,7 +2901,7 @@ ParseResult FIRModuleParser::parseModule(unsigned indent) {
   for (auto &elt : portListAndLoc)
     portList.push_back(elt.first);
   ArrayAttr annotations;
-  getAnnotations(moduleTarget, annotations);
+  getAnnotations(getModuleTarget(), annotations);
   auto fmodule =
       builder.create<FModuleOp>(info.getLoc(), name, portList, annotations);
 
@@ -2950,8 +2963,9 @@ ParseResult FIRCircuitParser::parseCircuit() {
       parseOptionalInfo(info))
     return failure();
 
-  auto circuitTarget = "~" + name.getValue().str();
-  getState().circuitTarget = circuitTarget;
+  auto &circuitTarget = getState().circuitTarget;
+  circuitTarget = "~";
+  circuitTarget += name.getValue();
 
   // Deal with any inline annotations, if they exist.  These are processed first
   // to place any annotations from an annotation file *after* the inline
@@ -0,0 +1,341 @@
+//===- Dedup.cpp - FIRRTL module deduplication ------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements structural deduplication of FIRRTL modules.  Modules
+// which only differ in their name, the names of the operations inside of them,
+// and their locations, are merged in to a single module and all instances are
+// updated to refer to it.
+//
+//===----------------------------------------------------------------------===//
+
+#include "./PassDetails.h"
+#include "circt/Dialect/FIRRTL/FIRRTLOps.h"
+#include "circt/Dialect/FIRRTL/Passes.h"
+#include "circt/Support/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Parallel.h"
+
+using namespace circt;
+using namespace firrtl;
+
+/// Return true if the named attribute is ignored when comparing two operations.
+/// The names of modules and operations may differ between merged modules, and
+/// the annotations of merged operations are combined.
+static bool isIgnoredAttr(Identifier name) {
+  return name == "name" || name == "annotations" ||
+         name == SymbolTable::getSymbolAttrName();
+}
+
+/// Merge the annotations of \p from in to the annotations of \p into.
+static void mergeAnnotations(Operation *into, Operation *from) {
+  auto fromAnnos = from->getAttrOfType<ArrayAttr>("annotations");
+  if (!fromAnnos || fromAnnos.empty())
+    return;
+
+  SmallVector<Attribute, 4> annotations;
+  if (auto intoAnnos = into->getAttrOfType<ArrayAttr>("annotations"))
+    annotations.append(intoAnnos.begin(), intoAnnos.end());
+
+  bool changed = false;
+  for (auto anno : fromAnnos) {
+    if (llvm::is_contained(annotations, anno))
+      continue;
+    annotations.push_back(anno);
+    changed = true;
+  }
+
+  if (changed)
+    into->setAttr("annotations",
+                  ArrayAttr::get(into->getContext(), annotations));
+}
+
+//===----------------------------------------------------------------------===//
+// Structural Equivalence
+//===----------------------------------------------------------------------===//
+
+/// A list of pairs of corresponding operations in two equivalent modules.
+using OpPairList = SmallVectorImpl<std::pair<Operation *, Operation *>>;
+
+namespace {
+/// This computes structural hashes of modules and compares modules for
+/// structural equivalence.  Instances are compared by the module they will
+/// refer to once the modules deduplicated so far have been merged, so that
+/// modules become equivalent when their children do.
+struct StructuralEquivalence {
+  /// Map from the name of each merged module to the module it was merged in
+  /// to.
+  DenseMap<Attribute, FlatSymbolRefAttr> replacements;
+
+  /// Compute a hash of the module which is the same for equivalent modules.
+  llvm::hash_code hashModule(FModuleOp module) const;
+
+  /// Return true if the two modules are equivalent.  If they are, the pairs of
+  /// corresponding operations in the module bodies are added to \p opPairs.
+  bool isEquivalent(FModuleOp lhs, FModuleOp rhs, OpPairList &opPairs);
+
+private:
+  using AttrList = SmallVector<std::pair<Identifier, Attribute>, 4>;
+
+  /// Collect the attributes of an operation which take part in the
+  /// comparison, with instance targets replaced by their merged module.
+  void getComparedAttrs(Operation *op, AttrList &attrs) const;
+
+  llvm::hash_code hashBlock(Block &block,
+                            DenseMap<Value, unsigned> &valueNumbers) const;
+  bool isEquivalent(Block &lhs, Block &rhs, OpPairList &opPairs);
+  bool isEquivalent(Operation *lhs, Operation *rhs, OpPairList &opPairs);
+
+  /// Map from the values of the left hand module to the values of the right
+  /// hand module, used while comparing two modules.
+  DenseMap<Value, Value> valueMap;
+};
+} // end anonymous namespace
+
+void StructuralEquivalence::getComparedAttrs(Operation *op,
+                                             AttrList &attrs) const {
+  for (auto attr : op->getAttrs()) {
+    if (isIgnoredAttr(attr.first))
+      continue;
+    Attribute value = attr.second;
+    if (isa<InstanceOp>(op) && attr.first == "moduleName")
+      if (auto replacement = replacements.lookup(value))
+        value = replacement;
+    attrs.push_back({attr.first, value});
+  }
+}
+
+llvm::hash_code StructuralEquivalence::hashModule(FModuleOp module) const {
+  AttrList attrs;
+  getComparedAttrs(module, attrs);
+  llvm::hash_code hash = llvm::hash_combine_range(attrs.begin(), attrs.end());
+
+  // Values are identified by the order in which they are defined.
+  DenseMap<Value, unsigned> valueNumbers;
+  for (auto arg : module.getArguments())
+    valueNumbers.insert({arg, valueNumbers.size()});
+
+  return llvm::hash_combine(hash,
+                            hashBlock(*module.getBodyBlock(), valueNumbers));
+}
+
+llvm::hash_code StructuralEquivalence::hashBlock(
+    Block &block, DenseMap<Value, unsigned> &valueNumbers) const {
+  llvm::hash_code hash(0);
+  AttrList attrs;
+  for (auto &op : block) {
+    attrs.clear();
+    getComparedAttrs(&op, attrs);
+    hash = llvm::hash_combine(
+        hash, op.getName(), op.getResultTypes(),
+        llvm::hash_combine_range(attrs.begin(), attrs.end()));
+
+    for (auto operand : op.getOperands())
+      hash = llvm::hash_combine(hash, valueNumbers.lookup(operand));
+
+    // Hash the nested regions, delimiting each block so that the placement of
+    // operations in the regions is significant.
+    for (auto &region : op.getRegions()) {
+      hash = llvm::hash_combine(hash, region.getBlocks().size());
+      for (auto &nestedBlock : region)
+        hash = llvm::hash_combine(hash, hashBlock(nestedBlock, valueNumbers));
+    }
+
+    for (auto result : op.getResults())
+      valueNumbers.insert({result, valueNumbers.size()});
+  }
+  return hash;
+}
+
+bool StructuralEquivalence::isEquivalent(FModuleOp lhs, FModuleOp rhs,
+                                         OpPairList &opPairs) {
+  AttrList lhsAttrs, rhsAttrs;
+  getComparedAttrs(lhs, lhsAttrs);
+  getComparedAttrs(rhs, rhsAttrs);
+  if (lhsAttrs != rhsAttrs)
+    return false;
+
+  valueMap.clear();
+  for (auto args : llvm::zip(lhs.getArguments(), rhs.getArguments()))
+    valueMap.insert({std::get<0>(args), std::get<1>(args)});
+
+  return isEquivalent(*lhs.getBodyBlock(), *rhs.getBodyBlock(), opPairs);
+}
+
+bool StructuralEquivalence::isEquivalent(Block &lhs, Block &rhs,
+                                         OpPairList &opPairs) {
+  auto lhsIt = lhs.begin(), lhsEnd = lhs.end();
+  auto rhsIt = rhs.begin(), rhsEnd = rhs.end();
+  for (; lhsIt != lhsEnd && rhsIt != rhsEnd; ++lhsIt, ++rhsIt)
+    if (!isEquivalent(&*lhsIt, &*rhsIt, opPairs))
+      return false;
+  return lhsIt == lhsEnd && rhsIt == rhsEnd;
+}
+
+bool StructuralEquivalence::isEquivalent(Operation *lhs, Operation *rhs,
+                                         OpPairList &opPairs) {
+  if (lhs->getName() != rhs->getName() ||
+      lhs->getNumOperands() != rhs->getNumOperands() ||
+      lhs->getNumRegions() != rhs->getNumRegions() ||
+      lhs->getResultTypes() != rhs->getResultTypes())
+    return false;
+
+  AttrList lhsAttrs, rhsAttrs;
+  getComparedAttrs(lhs, lhsAttrs);
+  getComparedAttrs(rhs, rhsAttrs);
+  if (lhsAttrs != rhsAttrs)
+    return false;
+
+  for (auto operands : llvm::zip(lhs->getOperands(), rhs->getOperands()))
+    if (valueMap.lookup(std::get<0>(operands)) != std::get<1>(operands))
+      return false;
+
+  for (auto regions : llvm::zip(lhs->getRegions(), rhs->getRegions())) {
+    auto &lhsRegion = std::get<0>(regions);
+    auto &rhsRegion = std::get<1>(regions);
+    if (lhsRegion.getBlocks().size() != rhsRegion.getBlocks().size())
+      return false;
+    for (auto blocks : llvm::zip(lhsRegion, rhsRegion))
+      if (!isEquivalent(std::get<0>(blocks), std::get<1>(blocks), opPairs))
+        return false;
+  }
+
+  for (auto results : llvm::zip(lhs->getResults(), rhs->getResults()))
+    valueMap.insert({std::get<0>(results), std::get<1>(results)});
+  opPairs.push_back({lhs, rhs});
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Pass Infrastructure
+//===----------------------------------------------------------------------===//
+
+namespace {
+class DedupPass : public DedupBase<DedupPass> {
+  void runOnOperation() override;
+
+  /// Return the depth of the instance hierarchy below the specified module.
+  /// External modules and modules without instances are at level 0.
+  unsigned getLevel(Operation *module);
+
+  /// All modules and external modules in the circuit, by name.
+  llvm::StringMap<Operation *> modulesByName;
+
+  /// The memoized levels of the modules.
+  DenseMap<Operation *, unsigned> levels;
+};
+} // end anonymous namespace
+
+unsigned DedupPass::getLevel(Operation *module) {
+  auto it = levels.find(module);
+  if (it != levels.end())
+    return it->second;
+  // Guard against recursion through invalid, cyclic instance hierarchies.
+  levels[module] = 0;
+
+  unsigned level = 0;
+  if (auto fmodule = dyn_cast<FModuleOp>(module)) {
+    fmodule.walk([&](InstanceOp instance) {
+      if (auto *child = modulesByName.lookup(instance.moduleName()))
+        level = std::max(level, getLevel(child) + 1);
+    });
+  }
+  levels[module] = level;
+  return level;
+}
+
+void DedupPass::runOnOperation() {
+  auto circuit = getOperation();
+  modulesByName.clear();
+  levels.clear();
+
+  for (auto &op : *circuit.getBody())
+    if (isa<FModuleOp, FExtModuleOp>(op))
+      modulesByName[SymbolTable::getSymbolName(&op)] = &op;
+
+  // Group the modules by their level in the instance hierarchy.  Equivalent
+  // modules have equivalent children, so are always on the same level, and
+  // processing the levels bottom up means that the children of all modules on
+  // a level have already been deduplicated.  The main module is never merged.
+  SmallVector<SmallVector<FModuleOp, 0>, 8> modulesByLevel;
+  for (auto &op : *circuit.getBody()) {
+    auto module = dyn_cast<FModuleOp>(op);
+    if (!module || module.getName() == circuit.name())
+      continue;
+    auto level = getLevel(module);
+    if (modulesByLevel.size() <= level)
+      modulesByLevel.resize(level + 1);
+    modulesByLevel[level].push_back(module);
+  }
+
+  StructuralEquivalence equivalence;
+  DenseMap<size_t, SmallVector<FModuleOp, 1>> candidates;
+  SmallVector<FModuleOp, 0> erasedModules;
+  SmallVector<std::pair<Operation *, Operation *>, 0> opPairs;
+  for (auto &modules : modulesByLevel) {
+    // Hash the modules of this level in parallel.  This only reads the merges
+    // made on the levels below.
+    std::vector<llvm::hash_code> hashes(modules.size());
+    auto hashModule = [&](size_t index) {
+      hashes[index] = equivalence.hashModule(modules[index]);
+    };
+    if (getContext().isMultithreadingEnabled()) {
+      llvm::parallelForEachN(0, modules.size(), hashModule);
+    } else {
+      for (size_t index = 0, e = modules.size(); index != e; ++index)
+        hashModule(index);
+    }
+
+    // Merge each module in to the first equivalent module with the same hash.
+    for (size_t index = 0, e = modules.size(); index != e; ++index) {
+      auto module = modules[index];
+      auto &bucket = candidates[hashes[index]];
+      FModuleOp original;
+      for (auto candidate : bucket) {
+        opPairs.clear();
+        if (equivalence.isEquivalent(candidate, module, opPairs)) {
+          original = candidate;
+          break;
+        }
+      }
+
+      if (!original) {
+        bucket.push_back(module);
+        continue;
+      }
+
+      mergeAnnotations(original, module);
+      for (auto &opPair : opPairs)
+        mergeAnnotations(opPair.first, opPair.second);
+      equivalence.replacements[FlatSymbolRefAttr::get(
+          &getContext(), module.getName())] =
+          FlatSymbolRefAttr::get(&getContext(), original.getName());
+      erasedModules.push_back(module);
+    }
+  }
+
+  if (erasedModules.empty()) {
+    markAllAnalysesPreserved();
+    return;
+  }
+
+  // Update all instances of the merged modules, and delete the modules.
+  auto &replacements = equivalence.replacements;
+  circuit.walk([&](InstanceOp instance) {
+    if (auto replacement = replacements.lookup(instance.moduleNameAttr()))
+      instance.moduleNameAttr(replacement);
+  });
+  for (auto module : erasedModules)
+    module.erase();
+  numErasedModules += erasedModules.size();
+}
+
+std::unique_ptr<mlir::Pass> circt::firrtl::createDedupPass() {
+  return std::make_unique<DedupPass>();
+}
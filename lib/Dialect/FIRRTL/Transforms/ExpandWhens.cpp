@@ -15,6 +15,7 @@
 #include "circt/Dialect/FIRRTL/FIRRTLTypes.h"
 #include "circt/Dialect/FIRRTL/FIRRTLVisitors.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
 
@@ -307,6 +308,12 @@ void ExpandWhensVisitor::visitStmt(WhenOp whenOp) {
   // assigned a previous value.  If the value was declared before the block,
   // then there is an incomplete initialization error.
 
+  // Destinations set in both blocks are resolved while processing the `then`
+  // block, and skipped when processing the `else` block.  They are tracked in a
+  // separate set, as erasing them from the `else` scope would shift the rest of
+  // its entries, which is quadratic for large when blocks.
+  llvm::SmallDenseSet<Value, 8> resolvedElseDests;
+
   // Process all connects in the `then` block.
   for (auto &destAndConnect : thenScope) {
     auto dest = std::get<0>(destAndConnect);
@@ -329,7 +336,7 @@ void ExpandWhensVisitor::visitStmt(WhenOp whenOp) {
           thenConnect, elseConnect);
       setLastConnect(dest, newConnect);
       // Do not process connect in the else scope.
-      elseScope.erase(dest);
+      resolvedElseDests.insert(dest);
       continue;
     }
 
@@ -353,6 +360,8 @@ void ExpandWhensVisitor::visitStmt(WhenOp whenOp) {
   for (auto &destAndConnect : elseScope) {
     auto dest = std::get<0>(destAndConnect);
     auto elseConnect = std::get<1>(destAndConnect);
+    if (resolvedElseDests.count(dest))
+      continue;
 
     // `dest` is set in `then` only.
     auto itAndInserted = scope.insert({dest, elseConnect});
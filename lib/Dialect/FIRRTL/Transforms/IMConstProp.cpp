@@ -8,7 +8,8 @@
 
 #include "./PassDetails.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
-#include "llvm/ADT/TinyPtrVector.h"
+#include "circt/Support/ParallelScheduling.h"
+#include "mlir/IR/SymbolTable.h"
 using namespace circt;
 using namespace firrtl;
 
@@ -96,13 +97,49 @@ private:
 } // end anonymous namespace
 
 namespace {
-struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
-  void runOnOperation() override;
-  void rewriteModuleBody(FModuleOp module);
+struct IMConstPropPass;
+
+/// The solver state of a single module.  The modules are solved in rounds:
+/// within a round, every module with pending work drains its own worklist on
+/// its own thread, and only updates the lattice values of its own ports and
+/// operations.  Updates of the values of other modules, i.e. the input ports
+/// of the modules it instantiates and the results of the instances of its
+/// output ports, are queued and delivered between rounds.  The lattice is
+/// monotonic, so this reaches the same fixed point as a single worklist.
+class ModuleSolver {
+public:
+  ModuleSolver(IMConstPropPass &pass, FModuleOp module)
+      : pass(pass), module(module) {}
+
+  FModuleOp getModule() const { return module; }
+
+  /// Returns true if the module body is known to execute.
+  bool isExecutable() const { return executable; }
+
+  /// Returns true if the module has work left for the next round.
+  bool hasWork() const {
+    return needsScan || !changedLatticeValueWorklist.empty();
+  }
+
+  /// Mark the module body as executable.  It is scanned in the next round.
+  void markExecutable() {
+    if (!executable)
+      executable = needsScan = true;
+  }
 
-  /// Returns true if the given block is executable.
-  bool isBlockExecutable(Block *block) const {
-    return executableBlocks.count(block);
+  /// Process the work of the module for this round.
+  void solve();
+
+  /// Deliver the updates of the values of other modules queued in this round.
+  /// This must not run concurrently with any solver.
+  void deliverUpdates();
+
+  /// Return the constant the value was found to be, or null.
+  Attribute getAttributeIfConstant(Value value) const {
+    auto it = latticeValues.find(value);
+    if (it != latticeValues.end() && it->second.isConstant())
+      return it->second.getConstant();
+    return {};
   }
 
   bool isOverdefined(Value value) const {
@@ -143,8 +180,17 @@ struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
     mergeLatticeValue(result, it->second);
   }
 
-  /// Mark the given block as executable.
-  void markBlockExecutable(Block *block);
+private:
+  /// Queue an update of a value of another module.
+  void sendLatticeValue(ModuleSolver *dest, Value value, LatticeValue source) {
+    if (!source.isUnknown())
+      outgoingValues.push_back({dest, value, source});
+  }
+
+  /// Do an initial scan of the body of the module, processing nullary
+  /// operations like wires, instances, and constants that only get processed
+  /// once.
+  void scanBody();
   void markWire(WireOp wire);
   void markConstant(ConstantOp constant);
   void markInstance(InstanceOp instance);
@@ -153,23 +199,68 @@ struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
   void visitPartialConnect(PartialConnectOp connect);
   void visitOperation(Operation *op);
 
-private:
+  IMConstPropPass &pass;
+  FModuleOp module;
+
   /// This keeps track of the current state of each tracked value.
   DenseMap<Value, LatticeValue> latticeValues;
 
-  /// The set of blocks that are known to execute, or are intrinsically live.
-  SmallPtrSet<Block *, 16> executableBlocks;
-
-  /// A worklist containing blocks that need to be processed.
-  SmallVector<Block *, 64> blockWorklist;
-
   /// A worklist of values whose LatticeValue recently changed, indicating the
   /// users need to be reprocessed.
   SmallVector<Value, 64> changedLatticeValueWorklist;
 
+  /// Whether the module body is known to execute, and whether it still needs
+  /// its initial scan.
+  bool executable = false;
+  bool needsScan = false;
+
+  /// The updates of the values of other modules queued in this round.
+  struct Update {
+    ModuleSolver *dest;
+    Value value;
+    LatticeValue source;
+  };
+  SmallVector<Update, 4> outgoingValues;
+
+  /// The modules found to be executable in this round.
+  SmallVector<ModuleSolver *, 4> outgoingExecutable;
+};
+
+struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
+  void runOnOperation() override;
+
+  /// Replace the values in the module that were found to be constant.  This
+  /// only reads the solved lattice, so it may be run on several modules
+  /// concurrently.
+  void rewriteModuleBody(ModuleSolver &solver);
+
+  /// Return the solver of the module instantiated by the instance, or null if
+  /// it is an extmodule.
+  ModuleSolver *getInstantiatedModule(InstanceOp instance) const {
+    return instantiatedModules.lookup(instance);
+  }
+
+  /// Return the instance results which the output port drives, along with the
+  /// solvers of the modules containing them.
+  ArrayRef<std::pair<ModuleSolver *, Value>>
+  getInstanceResults(BlockArgument port) const {
+    auto it = resultPortToInstanceResultMapping.find(port);
+    if (it == resultPortToInstanceResultMapping.end())
+      return {};
+    return it->second;
+  }
+
+private:
+  /// The solver of each module, in the order of the circuit.
+  std::vector<std::unique_ptr<ModuleSolver>> solvers;
+
+  /// The solver of the module instantiated by each instance.  These and the
+  /// mapping below are computed up front, and are only read while solving.
+  DenseMap<Operation *, ModuleSolver *> instantiatedModules;
+
   /// This keeps track of users the instance results that correspond to output
   /// ports.
-  DenseMap<BlockArgument, llvm::TinyPtrVector<Value>>
+  DenseMap<BlockArgument, SmallVector<std::pair<ModuleSolver *, Value>, 1>>
       resultPortToInstanceResultMapping;
 };
 } // end anonymous namespace
@@ -179,52 +270,130 @@ private:
 void IMConstPropPass::runOnOperation() {
   auto circuit = getOperation();
 
+  // Set up a solver for every module, and resolve the instances.
+  SymbolTable symbolTable(circuit);
+  SmallVector<Operation *, 32> modules;
+  DenseMap<Operation *, ModuleSolver *> moduleSolvers;
+  for (auto &circuitBodyOp : *circuit.getBody()) {
+    if (auto module = dyn_cast<FModuleOp>(circuitBodyOp)) {
+      solvers.push_back(std::make_unique<ModuleSolver>(*this, module));
+      moduleSolvers[module] = solvers.back().get();
+      modules.push_back(module);
+    }
+  }
+  for (auto &solver : solvers) {
+    for (auto instance :
+         solver->getModule().getBodyBlock()->getOps<InstanceOp>()) {
+      auto *child =
+          moduleSolvers.lookup(symbolTable.lookup(instance.moduleName()));
+      instantiatedModules[instance] = child;
+      if (!child)
+        continue;
+
+      // Remember the instance results which each output port drives.
+      for (size_t resultNo = 0, e = instance.getNumResults(); resultNo != e;
+           ++resultNo) {
+        auto instancePortVal = instance.getResult(resultNo);
+        if (instancePortVal.getType().isa<FlipType>() ||
+            !instancePortVal.getType().cast<FIRRTLType>().isGround())
+          continue;
+        auto modulePortVal = child->getModule().getPortArgument(resultNo);
+        resultPortToInstanceResultMapping[modulePortVal].push_back(
+            {solver.get(), instancePortVal});
+      }
+    }
+  }
+
   // If the top level module is an external module, mark the input ports
-  // overdefined.
+  // overdefined.  Otherwise, mark all module ports as being overdefined.
+  auto markEntryPoint = [&](ModuleSolver &solver) {
+    solver.markExecutable();
+    for (auto port : solver.getModule().getBodyBlock()->getArguments())
+      solver.markOverdefined(port);
+  };
   if (auto module = dyn_cast<FModuleOp>(circuit.getMainModule())) {
-    markBlockExecutable(module.getBodyBlock());
-    for (auto port : module.getBodyBlock()->getArguments())
-      markOverdefined(port);
+    markEntryPoint(*moduleSolvers[module]);
   } else {
-    // Otherwise, mark all module ports as being overdefined.
-    for (auto &circuitBodyOp : circuit.getBody()->getOperations()) {
-      if (auto module = dyn_cast<FModuleOp>(circuitBodyOp)) {
-        markBlockExecutable(module.getBodyBlock());
-        for (auto port : module.getBodyBlock()->getArguments())
-          markOverdefined(port);
+    for (auto &solver : solvers)
+      markEntryPoint(*solver);
+  }
+
+  // Solve the modules with pending work in parallel, then deliver the updates
+  // they made to other modules, until nothing changes.  The updates are
+  // delivered in the order of the circuit to keep the pass deterministic.
+  // The modules are estimated once, rather than in every round.
+  auto moduleCosts = estimateOperationCosts(&getContext(), modules);
+  SmallVector<Operation *, 32> activeModules;
+  SmallVector<size_t, 32> activeCosts;
+  SmallVector<ModuleSolver *, 32> activeSolvers;
+  while (true) {
+    activeModules.clear();
+    activeCosts.clear();
+    activeSolvers.clear();
+    for (size_t i = 0, e = solvers.size(); i != e; ++i) {
+      if (solvers[i]->hasWork()) {
+        activeModules.push_back(modules[i]);
+        activeCosts.push_back(moduleCosts[i]);
+        activeSolvers.push_back(solvers[i].get());
       }
     }
+    if (activeSolvers.empty())
+      break;
+
+    parallelForEachLargestFirst(
+        &getContext(), activeModules, activeCosts,
+        [&](size_t index) { activeSolvers[index]->solve(); });
+    for (auto *solver : activeSolvers)
+      solver->deliverUpdates();
   }
 
-  // If a value changed lattice state then reprocess any of its users.
+  // Rewrite any constants in the modules.  The lattice is fully solved at this
+  // point and is only read from here on, and each module body is rewritten
+  // independently, so the modules can be processed in parallel.
+  parallelForEachLargestFirst(
+      &getContext(), modules, moduleCosts,
+      [&](size_t index) { rewriteModuleBody(*solvers[index]); });
+
+  // Clean up our state for next time.
+  solvers.clear();
+  instantiatedModules.clear();
+  resultPortToInstanceResultMapping.clear();
+}
+
+void ModuleSolver::solve() {
+  if (needsScan) {
+    needsScan = false;
+    scanBody();
+  }
+
+  // If a value changed lattice state then reprocess any of its users.  The
+  // lattice values of the ports themselves are not forwarded to the instances:
+  // an output port is only overdefined because the module may be instantiated
+  // outside of the circuit, and the instance results within the circuit only
+  // take the values which the module connects to the port.
+  auto *body = module.getBodyBlock();
   while (!changedLatticeValueWorklist.empty()) {
     Value changedVal = changedLatticeValueWorklist.pop_back_val();
+    if (!executable)
+      continue;
     for (Operation *user : changedVal.getUsers()) {
-      if (isBlockExecutable(user->getBlock()))
+      if (user->getBlock() == body)
         visitOperation(user);
     }
   }
-
-  // Rewrite any constants in the modules.
-  // TODO: parallelize.
-  for (auto &circuitBodyOp : *circuit.getBody())
-    if (auto module = dyn_cast<FModuleOp>(circuitBodyOp))
-      rewriteModuleBody(module);
-
-  // Clean up our state for next time.
-  latticeValues.clear();
-  executableBlocks.clear();
-  resultPortToInstanceResultMapping.clear();
 }
 
-/// Mark a block executable if it isn't already.  This does an initial scan of
-/// the block, processing nullary operations like wires, instances, and
-/// constants that only get processed once.
-void IMConstPropPass::markBlockExecutable(Block *block) {
-  if (!executableBlocks.insert(block).second)
-    return; // Already executable.
+void ModuleSolver::deliverUpdates() {
+  for (auto *dest : outgoingExecutable)
+    dest->markExecutable();
+  for (auto &update : outgoingValues)
+    update.dest->mergeLatticeValue(update.value, update.source);
+  outgoingExecutable.clear();
+  outgoingValues.clear();
+}
 
-  for (auto &op : *block) {
+void ModuleSolver::scanBody() {
+  for (auto &op : *module.getBodyBlock()) {
     // We only handle nullary firrtl nodes in the prepass.  Other nodes will get
     // handled as part of top-down worklist processing.
     if (op.getNumOperands() != 0)
@@ -245,7 +414,7 @@ void IMConstPropPass::markBlockExecutable(Block *block) {
   }
 }
 
-void IMConstPropPass::markWire(WireOp wire) {
+void ModuleSolver::markWire(WireOp wire) {
   // If the wire has a non-ground type, then it is too complex for us to handle,
   // mark the wire as overdefined.
   // TODO: Eventually add a field-sensitive model.
@@ -256,19 +425,20 @@ void IMConstPropPass::markWire(WireOp wire) {
   // state.
 }
 
-void IMConstPropPass::markConstant(ConstantOp constant) {
+void ModuleSolver::markConstant(ConstantOp constant) {
   mergeLatticeValue(constant, LatticeValue(constant.valueAttr()));
 }
 
 /// Instances have no operands, so they are visited exactly once when their
-/// enclosing block is marked live.  This sets up the def-use edges for ports.
-void IMConstPropPass::markInstance(InstanceOp instance) {
+/// enclosing block is marked live.  The def-use edges for the ports are set up
+/// before solving.
+void ModuleSolver::markInstance(InstanceOp instance) {
   // Get the module being reference or a null pointer if this is an extmodule.
-  auto module = dyn_cast<FModuleOp>(instance.getReferencedModule());
+  auto *child = pass.getInstantiatedModule(instance);
 
   // If this is an extmodule, just remember that any results and inouts are
   // overdefined.
-  if (!module) {
+  if (!child) {
     for (size_t resultNo = 0, e = instance.getNumResults(); resultNo != e;
          ++resultNo) {
       auto portVal = instance.getResult(resultNo);
@@ -283,10 +453,8 @@ void IMConstPropPass::markInstance(InstanceOp instance) {
     return;
   }
 
-  markBlockExecutable(module.getBodyBlock());
+  outgoingExecutable.push_back(child);
 
-  // Ok, it is a normal internal module reference.  Populate
-  // resultPortToInstanceResultMapping, and forward any already-computed values.
   for (size_t resultNo = 0, e = instance.getNumResults(); resultNo != e;
        ++resultNo) {
     auto instancePortVal = instance.getResult(resultNo);
@@ -301,19 +469,16 @@ void IMConstPropPass::markInstance(InstanceOp instance) {
       continue;
     }
 
-    // Otherwise we have a result from the instance.  We need to forward results
-    // from the body to this instance result's SSA value, so remember it.
-    BlockArgument modulePortVal = module.getPortArgument(resultNo);
-    resultPortToInstanceResultMapping[modulePortVal].push_back(instancePortVal);
-
-    // If there is already a value known for modulePortVal make sure to forward
-    // it here.
-    mergeLatticeValue(instancePortVal, modulePortVal);
+    // The module may already have forwarded a value to this result before
+    // this module was known to execute.  Revisit its users now.
+    auto it = latticeValues.find(instancePortVal);
+    if (it != latticeValues.end() && !it->second.isUnknown())
+      changedLatticeValueWorklist.push_back(instancePortVal);
   }
 }
 
 // We merge the value from the RHS into the value of the LHS.
-void IMConstPropPass::visitConnect(ConnectOp connect) {
+void ModuleSolver::visitConnect(ConnectOp connect) {
   // TODO: Generalize to subaccesses etc when we have a field sensitive model.
   if (!connect.dest().getType().cast<FIRRTLType>().getPassiveType().isGround())
     return;
@@ -323,8 +488,12 @@ void IMConstPropPass::visitConnect(ConnectOp connect) {
   // Driving result ports propagates the value to each instance using the
   // module.
   if (auto blockArg = connect.dest().dyn_cast<BlockArgument>()) {
-    for (auto userOfResultPort : resultPortToInstanceResultMapping[blockArg])
-      mergeLatticeValue(userOfResultPort, connect.src());
+    auto it = latticeValues.find(connect.src());
+    if (it == latticeValues.end())
+      return;
+    for (auto &instanceResult : pass.getInstanceResults(blockArg))
+      sendLatticeValue(instanceResult.first, instanceResult.second,
+                       it->second);
     return;
   }
 
@@ -338,19 +507,20 @@ void IMConstPropPass::visitConnect(ConnectOp connect) {
   // Driving an instance argument port drives the corresponding argument of the
   // referenced module.
   if (auto instance = dyn_cast<InstanceOp>(dest.getOwner())) {
-    auto module = dyn_cast<FModuleOp>(instance.getReferencedModule());
-    if (!module)
+    auto *child = pass.getInstantiatedModule(instance);
+    auto it = latticeValues.find(connect.src());
+    if (!child || it == latticeValues.end())
       return;
 
     BlockArgument modulePortVal =
-        module.getPortArgument(dest.getResultNumber());
-    return mergeLatticeValue(modulePortVal, connect.src());
+        child->getModule().getPortArgument(dest.getResultNumber());
+    return sendLatticeValue(child, modulePortVal, it->second);
   }
 
   connect.emitError("connect unhandled by IMConstProp");
 }
 
-void IMConstPropPass::visitPartialConnect(PartialConnectOp partialConnect) {
+void ModuleSolver::visitPartialConnect(PartialConnectOp partialConnect) {
   partialConnect.emitError("IMConstProp cannot handle partial connect");
 }
 
@@ -360,7 +530,7 @@ void IMConstPropPass::visitPartialConnect(PartialConnectOp partialConnect) {
 ///
 /// This should update the lattice value state for any result values.
 ///
-void IMConstPropPass::visitOperation(Operation *op) {
+void ModuleSolver::visitOperation(Operation *op) {
   // If this is a operation with special handling, handle it specially.
   if (auto connectOp = dyn_cast<ConnectOp>(op))
     return visitConnect(connectOp);
@@ -431,10 +601,11 @@ void IMConstPropPass::visitOperation(Operation *op) {
   }
 }
 
-void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
+void IMConstPropPass::rewriteModuleBody(ModuleSolver &solver) {
+  auto module = solver.getModule();
   auto *body = module.getBodyBlock();
   // If a module is unreachable, then nuke its body.
-  if (!executableBlocks.count(body)) {
+  if (!solver.isExecutable()) {
     while (!body->empty())
       body->back().erase();
     return;
@@ -451,11 +622,8 @@ void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
     value.replaceAllUsesWith(cst->getResult(0));
   };
 
-  auto getAttributeIfConstant = [&](Value value) -> Attribute {
-    auto it = latticeValues.find(value);
-    if (it != latticeValues.end() && it->second.isConstant())
-      return it->second.getConstant();
-    return {};
+  auto getAttributeIfConstant = [&](Value value) {
+    return solver.getAttributeIfConstant(value);
   };
 
   // Constant propagate any ports that are always constant.
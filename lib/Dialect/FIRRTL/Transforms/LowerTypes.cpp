@@ -17,11 +17,13 @@
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/Support/ImplicitLocOpBuilder.h"
 #include "circt/Support/LLVM.h"
+#include "circt/Support/ParallelScheduling.h"
 #include "mlir/IR/FunctionSupport.h"
 #include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSwitch.h"
-#include "llvm/Support/Parallel.h"
 #include <algorithm>
+#include <mutex>
 
 using namespace circt;
 using namespace firrtl;
@@ -91,6 +93,88 @@ static FIRRTLType getCanonicalAggregateType(Type originalType) {
       .Default([](auto) { return nullptr; });
 }
 
+//===----------------------------------------------------------------------===//
+// Flattened Type Cache
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// The flattened form of a type.  A value of an aggregate type is lowered to
+/// one value per ground field, and those values are identified by the index of
+/// the field in this list.
+struct FlatTypeInfo {
+  /// The ground fields of the type, in order.
+  SmallVector<FlatBundleFieldEntry, 8> fields;
+
+  /// For a bundle type, the index of the first field of each element.
+  SmallVector<unsigned, 4> elementOffsets;
+
+  /// The index of each field, keyed by its suffix without the leading field
+  /// separator.
+  llvm::StringMap<unsigned> fieldIndices;
+
+  /// Return the index of the field with the specified suffix, given without
+  /// the leading field separator.
+  unsigned getFieldIndex(StringRef suffix) const {
+    auto it = fieldIndices.find(suffix);
+    assert(it != fieldIndices.end() && "unknown field of flattened type");
+    return it->second;
+  }
+};
+
+/// A thread-safe cache of flattened types.  FIRRTL types are uniqued, so every
+/// type only needs to be flattened once, no matter how many modules, ports and
+/// subfield accesses refer to it.
+class FlatTypeCache {
+public:
+  const FlatTypeInfo &get(FIRRTLType type);
+
+private:
+  std::mutex mutex;
+  DenseMap<Type, std::unique_ptr<FlatTypeInfo>> cache;
+};
+} // end anonymous namespace
+
+const FlatTypeInfo &FlatTypeCache::get(FIRRTLType type) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(type);
+    if (it != cache.end())
+      return *it->second;
+  }
+
+  // Flatten the type without holding the lock.  Bundles are broken down one
+  // element at a time to record where the fields of each element start.
+  auto info = std::make_unique<FlatTypeInfo>();
+  FIRRTLType elementType = type;
+  bool isFlipped = false;
+  if (auto flip = type.dyn_cast<FlipType>()) {
+    elementType = flip.getElementType();
+    isFlipped = true;
+  }
+  if (auto bundle = elementType.dyn_cast<BundleType>()) {
+    for (auto &elt : bundle.getElements()) {
+      info->elementOffsets.push_back(info->fields.size());
+      flattenType(elt.type, ("_" + elt.name.getValue()).str(), isFlipped,
+                  info->fields);
+    }
+  } else {
+    flattenType(elementType, "", isFlipped, info->fields);
+  }
+  for (auto it : llvm::enumerate(info->fields)) {
+    StringRef suffix = it.value().suffix;
+    if (!suffix.empty())
+      info->fieldIndices.try_emplace(suffix.drop_front(1), it.index());
+  }
+
+  // Another thread may have flattened the same type in the meantime, in which
+  // case its result is kept.
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &entry = cache[type];
+  if (!entry)
+    entry = std::move(info);
+  return *entry;
+}
+
 //===----------------------------------------------------------------------===//
 // Module Type Lowering
 //===----------------------------------------------------------------------===//
@@ -98,8 +182,9 @@ static FIRRTLType getCanonicalAggregateType(Type originalType) {
 namespace {
 class TypeLoweringVisitor : public FIRRTLVisitor<TypeLoweringVisitor> {
 public:
-  TypeLoweringVisitor(MLIRContext *context) : context(context) {}
-  using ValueIdentifier = std::pair<Value, Identifier>;
+  TypeLoweringVisitor(MLIRContext *context, FlatTypeCache &flatTypes)
+      : context(context), flatTypes(flatTypes) {}
+  using ValueField = std::pair<Value, unsigned>;
   using FIRRTLVisitor<TypeLoweringVisitor>::visitDecl;
   using FIRRTLVisitor<TypeLoweringVisitor>::visitExpr;
   using FIRRTLVisitor<TypeLoweringVisitor>::visitStmt;
@@ -123,6 +208,10 @@ public:
   void visitStmt(WhenOp op);
 
 private:
+  // Lower the result of a subfield or subindex op to a range of the flattened
+  // fields of its input.
+  void lowerFieldRange(Operation *op, Value input, unsigned offset);
+
   // Lowering module block arguments.
   void lowerArg(FModuleOp module, BlockArgument arg, FIRRTLType type);
 
@@ -130,13 +219,19 @@ private:
   Value addArg(FModuleOp module, Type type, unsigned oldArgNumber,
                StringRef nameSuffix = "");
 
-  void setBundleLowering(Value oldValue, StringRef flatField, Value newValue);
-  Value getBundleLowering(Value oldValue, StringRef flatField);
+  const FlatTypeInfo &getFlatType(FIRRTLType type);
+  void setBundleLowering(Value oldValue, unsigned fieldIndex, Value newValue);
+  Value getBundleLowering(Value oldValue, unsigned fieldIndex);
   void getAllBundleLowerings(Value oldValue,
                              SmallVectorImpl<std::pair<Value, bool>> &results);
 
   MLIRContext *context;
 
+  // The flattened types shared by all modules, and the ones this module has
+  // already looked up, which can be accessed without locking.
+  FlatTypeCache &flatTypes;
+  DenseMap<Type, const FlatTypeInfo *> localFlatTypes;
+
   // The builder is set and maintained in the main loop.
   ImplicitLocOpBuilder *builder;
 
@@ -144,8 +239,9 @@ private:
   SmallVector<unsigned, 8> argsToRemove;
   SmallVector<Operation *, 16> opsToRemove;
 
-  // State to keep a mapping from (Value, Identifier) pairs to flattened values.
-  DenseMap<ValueIdentifier, Value> loweredBundleValues;
+  // State to keep a mapping from (Value, field index) pairs to flattened
+  // values.
+  DenseMap<ValueField, Value> loweredBundleValues;
 
   // State to track the new attributes for the module.
   SmallVector<NamedAttribute, 8> newModuleAttrs;
@@ -226,10 +322,10 @@ void TypeLoweringVisitor::lowerArg(FModuleOp module, BlockArgument arg,
   unsigned argNumber = arg.getArgNumber();
 
   // Flatten any bundle types.
-  SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
-  flattenType(type, "", false, fieldTypes);
+  auto &fieldTypes = getFlatType(type).fields;
 
-  for (auto field : fieldTypes) {
+  for (size_t i = 0, e = fieldTypes.size(); i != e; ++i) {
+    auto &field = fieldTypes[i];
 
     // Create new block arguments.
     auto type = field.getPortType();
@@ -237,11 +333,8 @@ void TypeLoweringVisitor::lowerArg(FModuleOp module, BlockArgument arg,
 
     // If this field was flattened from a bundle.
     if (!field.suffix.empty()) {
-      // Remove field separator prefix for consitency with the rest of the pass.
-      auto fieldName = StringRef(field.suffix).drop_front(1);
-
-      // Map the flattened suffix for the original bundle to the new value.
-      setBundleLowering(arg, fieldName, newValue);
+      // Map the flattened field of the original bundle to the new value.
+      setBundleLowering(arg, i, newValue);
     } else {
       // Lower any other arguments by copying them to keep the relative order.
       arg.replaceAllUsesWith(newValue);
@@ -262,15 +355,14 @@ void TypeLoweringVisitor::visitDecl(FExtModuleOp extModule) {
   SmallVector<Attribute> portNames;
   for (auto &port : extModule.getPorts()) {
     // Flatten the port type.
-    SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
-    flattenType(port.type, port.getName(), false, fieldTypes);
+    auto &fieldTypes = getFlatType(port.type).fields;
 
     // For each field, add record its name and type.
-    for (auto field : fieldTypes) {
+    for (auto &field : fieldTypes) {
       Attribute pName;
       inputTypes.push_back(field.getPortType());
       if (port.name)
-        pName = builder.getStringAttr(field.suffix);
+        pName = builder.getStringAttr(port.getName().str() + field.suffix);
       else
         pName = builder.getStringAttr("");
       portNames.push_back(pName);
@@ -298,13 +390,13 @@ void TypeLoweringVisitor::visitDecl(InstanceOp op) {
   SmallVector<size_t, 8> numFieldsPerResult;
   for (size_t i = 0, e = op.getNumResults(); i != e; ++i) {
     // Flatten any nested bundle types the usual way.
-    SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
-    flattenType(op.getType(i).cast<FIRRTLType>(), op.getPortNameStr(i),
-                /*isFlip*/ false, fieldTypes);
+    auto &fieldTypes = getFlatType(op.getType(i).cast<FIRRTLType>()).fields;
+    auto portName = op.getPortNameStr(i);
 
-    for (auto field : fieldTypes) {
+    for (auto &field : fieldTypes) {
       // Store the flat type for the new bundle type.
-      resultNames.push_back(builder->getStringAttr(field.suffix));
+      resultNames.push_back(
+          builder->getStringAttr(portName.str() + field.suffix));
       resultTypes.push_back(field.getPortType());
     }
     numFieldsPerResult.push_back(fieldTypes.size());
@@ -327,13 +419,8 @@ void TypeLoweringVisitor::visitDecl(InstanceOp op) {
 
     // Otherwise lower bundles.
     for (size_t j = 0, e = numFieldsPerResult[i]; j != e; ++j) {
-      auto newPortName = resultNames[nextResult].getValue();
-      // Drop the original port name and the underscore.
-      newPortName = newPortName.drop_front(origPortName.size() + 1);
-
-      // Map the flattened suffix for the original bundle to the new value.
-      setBundleLowering(op.getResult(i), newPortName,
-                        newInstance.getResult(nextResult));
+      // Map the flattened field of the original bundle to the new value.
+      setBundleLowering(op.getResult(i), j, newInstance.getResult(nextResult));
       ++nextResult;
     }
   }
@@ -348,8 +435,14 @@ void TypeLoweringVisitor::visitDecl(MemOp op) {
   auto type = op.getDataType();
   auto depth = op.depth();
 
-  SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
-  flattenType(type, "", false, fieldTypes);
+  auto &fieldTypes = getFlatType(type).fields;
+
+  // Return the index of a flattened field of the j-th port of the original
+  // memory.
+  auto getPortFieldIndex = [&](size_t j, StringRef suffix) {
+    auto portType = getCanonicalAggregateType(op.getResult(j).getType());
+    return getFlatType(portType).getFieldIndex(suffix);
+  };
 
   // Mutable store of the types of the ports of a new memory. This is
   // cleared and re-used.
@@ -370,7 +463,7 @@ void TypeLoweringVisitor::visitDecl(MemOp op) {
   llvm::StringMap<Value> newWires;
 
   // Loop over the leaf aggregates.
-  for (auto field : fieldTypes) {
+  for (auto &field : fieldTypes) {
 
     // Determine the new port type for this memory. New ports are
     // constructed by checking the kind of the memory.
@@ -474,14 +567,16 @@ void TypeLoweringVisitor::visitDecl(MemOp op) {
 
           if (!(oldKind == MemOp::PortKind::ReadWrite &&
                 kind == MemOp::PortKind::Write))
-            setBundleLowering(op.getResult(j), oldName, wire);
+            setBundleLowering(op.getResult(j), getPortFieldIndex(j, oldName),
+                              wire);
 
           // Handle "en" specially if this used to be a readwrite port.
           if (oldKind == MemOp::PortKind::ReadWrite && oldName == "en") {
             auto wmode =
                 getWire(theType, op.getPortName(j).getValue().str() + "_wmode");
             if (!skip)
-              setBundleLowering(op.getResult(j), "wmode", wmode);
+              setBundleLowering(op.getResult(j),
+                                getPortFieldIndex(j, "wmode"), wmode);
             Value gate;
             if (kind == MemOp::PortKind::Read)
               gate = builder->create<NotPrimOp>(wmode.getType(), wmode);
@@ -502,9 +597,11 @@ void TypeLoweringVisitor::visitDecl(MemOp op) {
         // creation is needed.
         FIRRTLType theType = elt.type.getPassiveType();
 
-        setBundleLowering(op.getResult(j), (oldName + field.suffix).str(),
-                          builder->create<SubfieldOp>(
-                              theType, newMem.getResult(i), elt.name));
+        setBundleLowering(
+            op.getResult(j),
+            getPortFieldIndex(j, (oldName + field.suffix).str()),
+            builder->create<SubfieldOp>(theType, newMem.getResult(i),
+                                        elt.name));
       }
 
       // Don't increment the index of the old memory if this is the
@@ -530,18 +627,18 @@ void TypeLoweringVisitor::visitDecl(WireOp op) {
   if (!resultType)
     return;
 
-  SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
-  flattenType(resultType, "", false, fieldTypes);
+  auto &fieldTypes = getFlatType(resultType).fields;
 
   // Loop over the leaf aggregates.
   auto name = op.name().str();
-  for (auto field : fieldTypes) {
+  for (size_t i = 0, e = fieldTypes.size(); i != e; ++i) {
+    auto &field = fieldTypes[i];
     std::string loweredName = "";
     if (!name.empty())
       loweredName = name + field.suffix;
     auto wire = builder->create<WireOp>(
         field.type, builder->getStringAttr(loweredName), op.annotations());
-    setBundleLowering(result, StringRef(field.suffix).drop_front(1), wire);
+    setBundleLowering(result, i, wire);
   }
 
   // Remember to remove the original op.
@@ -560,16 +657,16 @@ void TypeLoweringVisitor::visitDecl(RegOp op) {
   if (!resultType)
     return;
 
-  SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
-  flattenType(resultType, "", false, fieldTypes);
+  auto &fieldTypes = getFlatType(resultType).fields;
 
   // Loop over the leaf aggregates.
   auto name = op.name().str();
-  for (auto field : fieldTypes) {
+  for (size_t i = 0, e = fieldTypes.size(); i != e; ++i) {
+    auto &field = fieldTypes[i];
     std::string loweredName = "";
     if (!name.empty())
       loweredName = name + field.suffix;
-    setBundleLowering(result, StringRef(field.suffix).drop_front(1),
+    setBundleLowering(result, i,
                       builder->create<RegOp>(field.getPortType(), op.clockVal(),
                                              loweredName, op.annotations()));
   }
@@ -590,18 +687,17 @@ void TypeLoweringVisitor::visitDecl(RegResetOp op) {
   if (!resultType)
     return;
 
-  SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
-  flattenType(resultType, "", false, fieldTypes);
+  auto &fieldTypes = getFlatType(resultType).fields;
 
   // Loop over the leaf aggregates.
   auto name = op.name().str();
-  for (auto field : fieldTypes) {
+  for (size_t i = 0, e = fieldTypes.size(); i != e; ++i) {
+    auto &field = fieldTypes[i];
     std::string loweredName = "";
     if (!name.empty())
       loweredName = name + field.suffix;
-    auto suffix = StringRef(field.suffix).drop_front(1);
-    auto resetValLowered = getBundleLowering(op.resetValue(), suffix);
-    setBundleLowering(result, suffix,
+    auto resetValLowered = getBundleLowering(op.resetValue(), i);
+    setBundleLowering(result, i,
                       builder->create<RegResetOp>(
                           field.getPortType(), op.clockVal(), op.resetSignal(),
                           resetValLowered, loweredName, op.annotations()));
@@ -617,43 +713,24 @@ void TypeLoweringVisitor::visitDecl(RegResetOp op) {
 //   c) the input value is from an instance
 //   d) the input value is from a duplex op, such as a wire or register
 //
-// This is accomplished by storing value and suffix mappings that point to the
-// flattened value. If the subfield op is accessing the leaf field of a bundle,
-// it replaces all uses with the flattened value. Otherwise, it flattens the
-// rest of the bundle and adds the flattened values to the mapping for each
-// partial suffix.
+// This is accomplished by storing value and field index mappings that point to
+// the flattened value. The fields of a bundle element form a contiguous range
+// of the flattened fields of the bundle. If the subfield op is accessing the
+// leaf field of a bundle, it replaces all uses with the flattened value.
+// Otherwise, it adds the flattened values of the element's range to the
+// mapping for the result.
 void TypeLoweringVisitor::visitExpr(SubfieldOp op) {
   Value input = op.input();
-  StringRef fieldname = op.fieldname();
-  FIRRTLType resultType = op.getType();
-
-  // Flatten any nested bundle types the usual way.
-  SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
-  flattenType(resultType, fieldname, false, fieldTypes);
-
-  for (auto field : fieldTypes) {
-    // Look up the mapping for this suffix.
-    auto newValue = getBundleLowering(input, field.suffix);
-
-    // The prefix is the field name and possibly field separator.
-    auto prefixSize = fieldname.size();
-    if (field.suffix.size() > fieldname.size())
-      prefixSize += 1;
-
-    // Get the remaining field suffix by removing the prefix.
-    auto partialSuffix = StringRef(field.suffix).drop_front(prefixSize);
-
-    // If we are at the leaf of a bundle.
-    if (partialSuffix.empty())
-      // Replace the result with the flattened value.
-      op.replaceAllUsesWith(newValue);
-    else
-      // Map the partial suffix for the result value to the flattened value.
-      setBundleLowering(op, partialSuffix, newValue);
-  }
+  auto bundleType =
+      getCanonicalAggregateType(input.getType()).cast<BundleType>();
+  auto &inputInfo = getFlatType(bundleType);
 
-  // Remember to remove the original op.
-  opsToRemove.push_back(op);
+  // Find the first flattened field of the accessed element.  The verifier
+  // ensures that the element exists.
+  auto index = bundleType.getElementIndex(op.fieldname());
+  assert(index.hasValue() && "subfield of unknown bundle element");
+
+  lowerFieldRange(op, input, inputInfo.elementOffsets[index.getValue()]);
 }
 
 // Gracefully die on subaccess operations
@@ -662,49 +739,42 @@ void TypeLoweringVisitor::visitExpr(SubaccessOp op) {
 
   // We need to do enough transformation to not segfault
   // Lower operation to an access of item 0
-  Value input = op.input();
-  std::string fieldname = "0";
-  FIRRTLType resultType = op.getType();
-
-  SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
-  flattenType(resultType, fieldname, false, fieldTypes);
-
-  op.replaceAllUsesWith(getBundleLowering(input, fieldTypes[0].suffix));
+  op.replaceAllUsesWith(getBundleLowering(op.input(), 0));
   opsToRemove.push_back(op);
 }
 
-// This is currently the same lowering as SubfieldOp, but using a fieldname
-// derived from the fixed index.
-//
-// TODO: Unify this and SubfieldOp handling.
+// This is the same lowering as SubfieldOp, but all elements of a vector have
+// the same number of flattened fields, so the range is derived from the index.
 void TypeLoweringVisitor::visitExpr(SubindexOp op) {
   Value input = op.input();
-  std::string fieldname = std::to_string(op.index());
-  FIRRTLType resultType = op.getType();
-
-  // Flatten any nested bundle types the usual way.
-  SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
-  flattenType(resultType, fieldname, false, fieldTypes);
-
-  for (auto field : fieldTypes) {
-    // Look up the mapping for this suffix.
-    auto newValue = getBundleLowering(input, field.suffix);
-
-    // The prefix is the field name and possibly field separator.
-    auto prefixSize = fieldname.size();
-    if (field.suffix.size() > fieldname.size())
-      prefixSize += 1;
-
-    // Get the remaining field suffix by removing the prefix.
-    auto partialSuffix = StringRef(field.suffix).drop_front(prefixSize);
-
-    // If we are at the leaf of a bundle.
-    if (partialSuffix.empty())
-      // Replace the result with the flattened value.
-      op.replaceAllUsesWith(newValue);
-    else
-      // Map the partial suffix for the result value to the flattened value.
-      setBundleLowering(op, partialSuffix, newValue);
+  auto vectorType =
+      getCanonicalAggregateType(input.getType()).cast<FVectorType>();
+  // The verifier ensures that the index is in range, so the vector is not
+  // empty.
+  auto numElements = vectorType.getNumElements();
+  assert(op.index() < numElements && "subindex out of range");
+  auto numFields = getFlatType(vectorType).fields.size();
+  unsigned fieldsPerElement = numFields / numElements;
+
+  lowerFieldRange(op, input, op.index() * fieldsPerElement);
+}
+
+// Lower the result of a subfield or subindex op, whose flattened fields are the
+// ones of the input starting at the specified index.
+void TypeLoweringVisitor::lowerFieldRange(Operation *op, Value input,
+                                          unsigned offset) {
+  Value result = op->getResult(0);
+  FIRRTLType resultType = result.getType().cast<FIRRTLType>();
+
+  // If we are at the leaf of a bundle, replace the result with the flattened
+  // value.
+  if (!getCanonicalAggregateType(resultType)) {
+    result.replaceAllUsesWith(getBundleLowering(input, offset));
+  } else {
+    // Map each field of the result value to the flattened value.
+    auto numFields = getFlatType(resultType).fields.size();
+    for (size_t i = 0; i != numFields; ++i)
+      setBundleLowering(result, i, getBundleLowering(input, offset + i));
   }
 
   // Remember to remove the original op.
@@ -777,13 +847,13 @@ void TypeLoweringVisitor::visitExpr(InvalidValuePrimOp op) {
   if (!resultType)
     return;
 
-  SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
-  flattenType(resultType, "", false, fieldTypes);
+  auto &fieldTypes = getFlatType(resultType).fields;
 
   // Loop over the leaf aggregates.
-  for (auto field : fieldTypes) {
-    setBundleLowering(result, StringRef(field.suffix).drop_front(1),
-                      builder->create<InvalidValuePrimOp>(field.getPortType()));
+  for (size_t i = 0, e = fieldTypes.size(); i != e; ++i) {
+    setBundleLowering(
+        result, i,
+        builder->create<InvalidValuePrimOp>(fieldTypes[i].getPortType()));
   }
 
   // Remember to remove the original op.
@@ -837,24 +907,30 @@ Value TypeLoweringVisitor::addArg(FModuleOp module, Type type,
   return newValue;
 }
 
+// Return the flattened form of the specified type.
+const FlatTypeInfo &TypeLoweringVisitor::getFlatType(FIRRTLType type) {
+  auto &info = localFlatTypes[type];
+  if (!info)
+    info = &flatTypes.get(type);
+  return *info;
+}
+
 // Store the mapping from a bundle typed value to a mapping from its field
-// names to flat values.
-void TypeLoweringVisitor::setBundleLowering(Value oldValue, StringRef flatField,
+// indices to flat values.
+void TypeLoweringVisitor::setBundleLowering(Value oldValue, unsigned fieldIndex,
                                             Value newValue) {
-  auto flatFieldId = builder->getIdentifier(flatField);
-  auto &entry = loweredBundleValues[ValueIdentifier(oldValue, flatFieldId)];
+  auto &entry = loweredBundleValues[ValueField(oldValue, fieldIndex)];
   if (entry == newValue)
     return;
   assert(!entry && "bundle lowering has already been set");
   entry = newValue;
 }
 
-// For a mapped bundle typed value and a flat subfield name, retrieve and
-// return the flat value if it exists.
+// For a mapped bundle typed value and a flat field index, retrieve and return
+// the flat value if it exists.
 Value TypeLoweringVisitor::getBundleLowering(Value oldValue,
-                                             StringRef flatField) {
-  auto flatFieldId = builder->getIdentifier(flatField);
-  auto &entry = loweredBundleValues[ValueIdentifier(oldValue, flatFieldId)];
+                                             unsigned fieldIndex) {
+  auto &entry = loweredBundleValues[ValueField(oldValue, fieldIndex)];
   assert(entry && "bundle lowering was not set");
   return entry;
 }
@@ -863,22 +939,16 @@ Value TypeLoweringVisitor::getBundleLowering(Value oldValue,
 // each field.
 void TypeLoweringVisitor::getAllBundleLowerings(
     Value value, SmallVectorImpl<std::pair<Value, bool>> &results) {
+  auto aggregateType = getCanonicalAggregateType(value.getType());
+  if (!aggregateType)
+    return;
 
-  TypeSwitch<FIRRTLType>(getCanonicalAggregateType(value.getType()))
-      .Case<BundleType, FVectorType>([&](auto aggregateType) {
-        // Flatten the original value's bundle type.
-        SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
-        flattenType(aggregateType, "", false, fieldTypes);
-
-        for (auto element : fieldTypes) {
-          // Remove the field separator prefix.
-          auto name = StringRef(element.suffix).drop_front(1);
+  // Flatten the original value's aggregate type.
+  auto &fieldTypes = getFlatType(aggregateType).fields;
 
-          // Store the resulting lowering for this flat value.
-          results.push_back({getBundleLowering(value, name), element.isOutput});
-        }
-      })
-      .Default([&](auto) {});
+  // Store the resulting lowering for each flat value.
+  for (size_t i = 0, e = fieldTypes.size(); i != e; ++i)
+    results.push_back({getBundleLowering(value, i), fieldTypes[i].isOutput});
 }
 
 //===----------------------------------------------------------------------===//
@@ -888,48 +958,24 @@ void TypeLoweringVisitor::getAllBundleLowerings(
 namespace {
 struct LowerTypesPass : public LowerFIRRTLTypesBase<LowerTypesPass> {
   void runOnOperation() override;
-
-private:
-  void runAsync();
-  void runSync();
 };
 } // end anonymous namespace
 
-void LowerTypesPass::runAsync() {
-  // Collect the operations to iterate in a vector. We can't use parallelFor
-  // with the regular op list, since it requires a RandomAccessIterator. This
-  // also lets us use parallelForEachN, which means we don't have to
-  // llvm::enumerate the ops with their index. TODO(mlir): There should really
-  // be a way to do this without collecting the operations first.
+// This is the main entrypoint for the lowering pass.
+void LowerTypesPass::runOnOperation() {
+  // Collect the modules to lower.  Each module is lowered independently, with
+  // the largest modules handed to the thread pool first.
   auto &body = getOperation().getBody()->getOperations();
-  std::vector<Operation *> ops;
+  SmallVector<Operation *, 32> ops;
   llvm::for_each(body, [&](Operation &op) { ops.push_back(&op); });
 
-  mlir::ParallelDiagnosticHandler diagHandler(&getContext());
-  llvm::parallelForEachN(0, ops.size(), [&](auto index) {
-    // Notify the handler the op index and then perform lowering.
-    diagHandler.setOrderIDForThread(index);
-    TypeLoweringVisitor(&getContext()).lowerModule(ops[index]);
-    diagHandler.eraseOrderIDForThread();
+  // The flattened types are shared between all modules of the circuit.
+  FlatTypeCache flatTypes;
+  parallelForEachLargestFirst(&getContext(), ops, [&](size_t index) {
+    TypeLoweringVisitor(&getContext(), flatTypes).lowerModule(ops[index]);
   });
 }
 
-void LowerTypesPass::runSync() {
-  auto circuit = getOperation();
-  for (auto &op : circuit.getBody()->getOperations()) {
-    TypeLoweringVisitor(&getContext()).lowerModule(&op);
-  }
-}
-
-// This is the main entrypoint for the lowering pass.
-void LowerTypesPass::runOnOperation() {
-  if (getContext().isMultithreadingEnabled()) {
-    runAsync();
-  } else {
-    runSync();
-  }
-}
-
 /// This is the pass constructor.
 std::unique_ptr<mlir::Pass> circt::firrtl::createLowerFIRRTLTypesPass() {
   return std::make_unique<LowerTypesPass>();
@@ -16,10 +16,34 @@
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/DialectImplementation.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
+#include <atomic>
 
 using namespace circt;
 using namespace rtl;
 
+/// The integer attribute cache ID of the next dialect instance.  Zero marks
+/// the empty cache entries.
+static std::atomic<unsigned> nextIntegerAttrCacheID(1);
+
+namespace {
+/// Command line options of the RTL dialect.  Used to dynamically register the
+/// options in the tools which want them.
+struct RTLDialectCLOptions {
+  llvm::cl::opt<bool> disableIntegerAttrCache{
+      "rtl-disable-integer-attr-cache",
+      llvm::cl::desc("Create the integer attributes of RTL constants through "
+                     "the context only, to measure the effect of the cache"),
+      llvm::cl::init(false), llvm::cl::Hidden};
+};
+} // namespace
+
+/// The staticly initialized command line options.
+static llvm::ManagedStatic<RTLDialectCLOptions> clOptions;
+
+void rtl::registerRTLDialectCLOptions() { *clOptions; }
+
 //===----------------------------------------------------------------------===//
 // Dialect specification.
 //===----------------------------------------------------------------------===//
@@ -65,6 +89,61 @@ void RTLDialect::initialize() {
 
   // Register interface implementations.
   addInterfaces<RTLOpAsmDialectInterface>();
+
+  integerAttrCacheID = nextIntegerAttrCacheID++;
+  integerAttrCacheEnabled =
+      !clOptions.isConstructed() || !clOptions->disableIntegerAttrCache;
+}
+
+//===----------------------------------------------------------------------===//
+// Integer attribute cache.
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// An entry of the per-thread cache of narrow integer attributes.  The entry
+/// is plain old data so that the cache needs no thread-local constructor, and
+/// holds the attribute as an opaque pointer.
+struct CachedIntegerAttr {
+  const void *attr;
+  uint64_t value;
+  unsigned width;
+  unsigned cacheID;
+};
+} // end anonymous namespace
+
+/// The cache is direct mapped, so a lookup is a single probe and the cache
+/// never grows.  Entries belonging to other contexts never match, because
+/// each dialect instance has its own cache ID.
+static constexpr unsigned integerAttrCacheBits = 9;
+static thread_local CachedIntegerAttr
+    integerAttrCache[1U << integerAttrCacheBits];
+
+IntegerAttr RTLDialect::getIntegerAttr(const APInt &value) {
+  unsigned width = value.getBitWidth();
+  auto getUncached = [&] {
+    return IntegerAttr::get(IntegerType::get(getContext(), width), value);
+  };
+  if (width > 64 || !integerAttrCacheEnabled)
+    return getUncached();
+
+  // Fibonacci hashing of the value, mixed with the width.
+  uint64_t bits = value.getZExtValue();
+  uint64_t hash = (bits ^ (uint64_t(width) << 57)) * 0x9e3779b97f4a7c15ULL;
+  auto &entry = integerAttrCache[hash >> (64 - integerAttrCacheBits)];
+  if (entry.cacheID == integerAttrCacheID && entry.width == width &&
+      entry.value == bits)
+    return Attribute::getFromOpaquePointer(entry.attr).cast<IntegerAttr>();
+
+  auto attr = getUncached();
+  entry = {attr.getAsOpaquePointer(), bits, width, integerAttrCacheID};
+  return attr;
+}
+
+IntegerAttr rtl::getIntAttr(const APInt &value, MLIRContext *context) {
+  if (auto *dialect = context->getLoadedDialect<RTLDialect>())
+    return dialect->getIntegerAttr(value);
+  return IntegerAttr::get(IntegerType::get(context, value.getBitWidth()),
+                          value);
 }
 
 // Registered hook to materialize a single constant operation from a given
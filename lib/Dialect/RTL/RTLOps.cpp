@@ -66,9 +66,8 @@ static LogicalResult verifyConstantOp(ConstantOp constant) {
 void ConstantOp::build(OpBuilder &builder, OperationState &result,
                        const APInt &value) {
 
-  auto type = IntegerType::get(builder.getContext(), value.getBitWidth());
-  auto attr = builder.getIntegerAttr(type, value);
-  return build(builder, result, type, attr);
+  auto attr = getIntAttr(value, builder.getContext());
+  return build(builder, result, attr.getType(), attr);
 }
 
 /// Build a ConstantOp from an APInt, infering the result type from the
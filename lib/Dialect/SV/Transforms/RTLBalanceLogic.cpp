@@ -0,0 +1,382 @@
+//===- RTLBalanceLogic.cpp - Logic depth balancing pass -------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass rebuilds chains of associative and commutative comb operations,
+// and chains of priority muxes, as trees which minimize the depth of the logic
+// in rtl.module bodies.  The depth of every value is estimated from a delay per
+// kind of operation, and each chain is rebuilt around the depths of its
+// inputs, so that the inputs which arrive last go through the fewest
+// operations.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SVPassDetail.h"
+#include "circt/Analysis/TimingAnalysis.h"
+#include "circt/Dialect/Comb/CombOps.h"
+#include "circt/Dialect/SV/SVPasses.h"
+#include "circt/Support/ParallelScheduling.h"
+#include "mlir/IR/Builders.h"
+
+#include <queue>
+
+using namespace circt;
+using namespace comb;
+
+namespace {
+/// A value along with the time at which it is available.
+struct TimedValue {
+  Value value;
+  unsigned arrival;
+  /// The position of the value among the ones being combined, which breaks
+  /// ties between values available at the same time.
+  unsigned order;
+
+  bool operator>(const TimedValue &other) const {
+    return std::tie(arrival, order) > std::tie(other.arrival, other.order);
+  }
+};
+
+/// Balances the logic of a single module.  This may run concurrently for
+/// different modules, so it only touches the block it is given.
+class LogicBalancer {
+public:
+  explicit LogicBalancer(const WeightedDelayModel &delayModel)
+      : delayModel(delayModel), weights(delayModel.getWeights()) {}
+
+  /// Return the critical path depth of the block.  If \p rebalance is true,
+  /// the chains of the block are rebuilt first, and the depth is the one of
+  /// the rebuilt logic.
+  unsigned run(Block &block, bool rebalance);
+
+  /// The number of chains which were rebuilt.
+  size_t numChainsBalanced = 0;
+
+private:
+  unsigned getArrival(Value value) const { return arrivals.lookup(value); }
+
+  /// Return true if the only user of the operation continues its chain, so the
+  /// operation is rebuilt along with that user.
+  bool isChainInternal(Operation *op);
+
+  /// Compute the arrival time of the result of the operation, after
+  /// rebuilding the chain it ends if \p rebalance is true.
+  unsigned visitOperation(Operation *op, bool rebalance);
+
+  unsigned balanceChain(Operation *root, unsigned arrival);
+  unsigned balanceMuxChain(MuxOp root, unsigned arrival);
+
+  TimedValue combineEarliestFirst(ArrayRef<TimedValue> values,
+                                  OperationName name, unsigned delay,
+                                  Location loc, OpBuilder *builder);
+  TimedValue buildMuxTree(ArrayRef<TimedValue> conds,
+                          ArrayRef<TimedValue> values,
+                          Optional<TimedValue> elseValue, Location loc,
+                          OpBuilder *builder);
+  TimedValue createOp(OperationName name, Location loc,
+                      ArrayRef<TimedValue> operands, unsigned delay,
+                      OpBuilder *builder);
+  void replaceChain(Operation *root, Value result,
+                    ArrayRef<Operation *> chainOps);
+
+  const WeightedDelayModel &delayModel;
+  const DelayWeights &weights;
+
+  /// The arrival time of every comb result computed so far.  Values missing
+  /// from the map are available at time zero.
+  DenseMap<Value, unsigned> arrivals;
+  DenseSet<Operation *> visited;
+
+  /// The operations of the rebuilt chains, which are erased at the end of the
+  /// walk so that the visited operations stay valid.  Every operation comes
+  /// before the operations defining its operands.
+  SmallVector<Operation *, 0> opsToErase;
+};
+} // end anonymous namespace
+
+bool LogicBalancer::isChainInternal(Operation *op) {
+  if (!op->hasOneUse())
+    return false;
+  auto *user = *op->user_begin();
+  if (user->getBlock() != op->getBlock() || user->getName() != op->getName())
+    return false;
+  if (auto mux = dyn_cast<MuxOp>(user))
+    return mux.falseValue() == op->getResult(0);
+  return isa<AddOp, AndOp, OrOp, XorOp>(op);
+}
+
+/// Operations in graph regions may be used before they are defined, so they
+/// are visited in post order of their operands within the block.  This way the
+/// inputs of a chain have their final arrival times when the chain is rebuilt.
+/// Operations on a combinational cycle see the operations of the cycle which
+/// have not been visited yet as available at time zero.
+unsigned LogicBalancer::run(Block &block, bool rebalance) {
+  arrivals.clear();
+  visited.clear();
+
+  unsigned criticalPath = 0;
+  SmallVector<std::pair<Operation *, unsigned>, 16> stack;
+  for (auto &root : block) {
+    if (!visited.insert(&root).second)
+      continue;
+    stack.push_back({&root, 0});
+    while (!stack.empty()) {
+      auto &entry = stack.back();
+      auto *op = entry.first;
+      if (entry.second != op->getNumOperands()) {
+        auto *def = op->getOperand(entry.second++).getDefiningOp();
+        if (def && def->getBlock() == &block && visited.insert(def).second)
+          stack.push_back({def, 0});
+        continue;
+      }
+      stack.pop_back();
+
+      // The operations inside a chain are replaced along with it, so only the
+      // end of the chain counts towards the critical path.
+      unsigned arrival = visitOperation(op, rebalance);
+      if (!isChainInternal(op))
+        criticalPath = std::max(criticalPath, arrival);
+    }
+  }
+
+  for (auto *op : opsToErase)
+    op->erase();
+  opsToErase.clear();
+  return criticalPath;
+}
+
+unsigned LogicBalancer::visitOperation(Operation *op, bool rebalance) {
+  if (!isa_and_nonnull<CombDialect>(op->getDialect()) || op->getNumResults() != 1)
+    return 0;
+
+  unsigned arrival = 0;
+  for (auto operand : op->getOperands())
+    arrival = std::max(arrival, getArrival(operand));
+  arrival += delayModel.getDelay(op, op->getNumOperands());
+  arrivals[op->getResult(0)] = arrival;
+
+  if (!rebalance || isChainInternal(op))
+    return arrival;
+  if (auto mux = dyn_cast<MuxOp>(op))
+    return balanceMuxChain(mux, arrival);
+  if (isa<AddOp, AndOp, OrOp, XorOp>(op))
+    return balanceChain(op, arrival);
+  return arrival;
+}
+
+/// Return the result of an operation with the specified operands, which is
+/// available \p delay after its last operand.  The operation is created with
+/// \p builder, or only its arrival time is computed if \p builder is null.
+TimedValue LogicBalancer::createOp(OperationName name, Location loc,
+                                   ArrayRef<TimedValue> operands,
+                                   unsigned delay, OpBuilder *builder) {
+  TimedValue result{Value(), 0, 0};
+  for (auto &operand : operands)
+    result.arrival = std::max(result.arrival, operand.arrival);
+  result.arrival += delay;
+  if (!builder)
+    return result;
+
+  OperationState state(loc, name);
+  for (auto &operand : operands)
+    state.addOperands(operand.value);
+  state.addTypes(operands.back().value.getType());
+  auto *op = builder->createOperation(state);
+  visited.insert(op);
+  result.value = op->getResult(0);
+  arrivals[result.value] = result.arrival;
+  return result;
+}
+
+/// Combine the values with two input operations named \p name, always
+/// combining the two values available first.  This minimizes the arrival time
+/// of the result, since all the operations have the same delay.
+TimedValue LogicBalancer::combineEarliestFirst(ArrayRef<TimedValue> values,
+                                               OperationName name,
+                                               unsigned delay, Location loc,
+                                               OpBuilder *builder) {
+  std::priority_queue<TimedValue, SmallVector<TimedValue, 8>,
+                      std::greater<TimedValue>>
+      queue(std::greater<TimedValue>(),
+            SmallVector<TimedValue, 8>(values.begin(), values.end()));
+  unsigned order = values.size();
+  while (queue.size() > 1) {
+    auto lhs = queue.top();
+    queue.pop();
+    auto rhs = queue.top();
+    queue.pop();
+
+    auto result = createOp(name, loc, {lhs, rhs}, delay, builder);
+    result.order = order++;
+    queue.push(result);
+  }
+  return queue.top();
+}
+
+/// Rebuild a chain of adds, ands, ors or xors whose intermediate results have
+/// no other use as a tree which minimizes its arrival time.
+unsigned LogicBalancer::balanceChain(Operation *root, unsigned arrival) {
+  // Collect the operations of the chain, and its inputs from left to right.
+  SmallVector<Operation *, 8> chainOps{root};
+  SmallVector<TimedValue, 8> inputs;
+  SmallVector<Value, 8> worklist(llvm::reverse(root->getOperands()));
+  while (!worklist.empty()) {
+    auto value = worklist.pop_back_val();
+    auto *def = value.getDefiningOp();
+    if (def && isChainInternal(def)) {
+      chainOps.push_back(def);
+      for (auto operand : llvm::reverse(def->getOperands()))
+        worklist.push_back(operand);
+      continue;
+    }
+    inputs.push_back({value, getArrival(value), unsigned(inputs.size())});
+  }
+
+  // Only rebuild the chain if that makes its result available earlier.
+  unsigned delay = delayModel.getDelay(root, 2);
+  if (inputs.size() <= 2 ||
+      combineEarliestFirst(inputs, root->getName(), delay, root->getLoc(),
+                           nullptr)
+              .arrival >= arrival)
+    return arrival;
+
+  OpBuilder builder(root);
+  auto result = combineEarliestFirst(inputs, root->getName(), delay,
+                                     root->getLoc(), &builder);
+  replaceChain(root, result.value, chainOps);
+  return result.arrival;
+}
+
+/// Replace the chain ending with \p root by the root of the rebuilt tree.
+/// The rebuilt ops have no attributes of their own, so the attributes of the
+/// root, such as its name hint, carry over to the new root which computes the
+/// same value.
+void LogicBalancer::replaceChain(Operation *root, Value result,
+                                 ArrayRef<Operation *> chainOps) {
+  result.getDefiningOp()->setAttrs(root->getAttrDictionary());
+  root->getResult(0).replaceAllUsesWith(result);
+  opsToErase.append(chainOps.begin(), chainOps.end());
+  ++numChainsBalanced;
+}
+
+/// Select the value of the first condition which holds among \p conds, or
+/// \p elseValue if none does.  Without an else value, one of the conditions
+/// is known to hold.  The first half of the conditions is checked at once with
+/// the or of these conditions, so the number of muxes on any path grows with
+/// the logarithm of the number of conditions.
+TimedValue LogicBalancer::buildMuxTree(ArrayRef<TimedValue> conds,
+                                       ArrayRef<TimedValue> values,
+                                       Optional<TimedValue> elseValue,
+                                       Location loc, OpBuilder *builder) {
+  auto *context = loc.getContext();
+  OperationName muxName(MuxOp::getOperationName(), context);
+  if (conds.size() == 1) {
+    if (!elseValue)
+      return values[0];
+    return createOp(muxName, loc, {conds[0], values[0], *elseValue},
+                    weights.mux, builder);
+  }
+
+  size_t half = conds.size() / 2;
+  auto trueValue = buildMuxTree(conds.take_front(half),
+                                values.take_front(half), None, loc, builder);
+  auto falseValue = buildMuxTree(conds.drop_front(half),
+                                 values.drop_front(half), elseValue, loc,
+                                 builder);
+  auto cond = combineEarliestFirst(
+      conds.take_front(half), OperationName(OrOp::getOperationName(), context),
+      weights.logic, loc, builder);
+  return createOp(muxName, loc, {cond, trueValue, falseValue}, weights.mux,
+                  builder);
+}
+
+/// Rebuild a chain of muxes, each of which selects the next one when its
+/// condition does not hold, as a tree of muxes selected by ors of the
+/// conditions.
+unsigned LogicBalancer::balanceMuxChain(MuxOp root, unsigned arrival) {
+  SmallVector<Operation *, 8> chainOps;
+  SmallVector<TimedValue, 8> conds, values;
+  auto mux = root;
+  while (true) {
+    chainOps.push_back(mux);
+    unsigned order = conds.size();
+    conds.push_back({mux.cond(), getArrival(mux.cond()), order});
+    values.push_back({mux.trueValue(), getArrival(mux.trueValue()), order});
+    auto next = mux.falseValue().getDefiningOp<MuxOp>();
+    if (!next || !isChainInternal(next))
+      break;
+    mux = next;
+  }
+  TimedValue elseValue{mux.falseValue(), getArrival(mux.falseValue()), 0};
+
+  // Only rebuild the chain if that makes its result available earlier.
+  if (conds.size() < 2 ||
+      buildMuxTree(conds, values, elseValue, root.getLoc(), nullptr).arrival >=
+          arrival)
+    return arrival;
+
+  OpBuilder builder(root);
+  auto result =
+      buildMuxTree(conds, values, elseValue, root.getLoc(), &builder);
+  replaceChain(root, result.value, chainOps);
+  return result.arrival;
+}
+
+//===----------------------------------------------------------------------===//
+// RTLBalanceLogicPass
+//===----------------------------------------------------------------------===//
+
+namespace {
+struct RTLBalanceLogicPass
+    : public sv::RTLBalanceLogicBase<RTLBalanceLogicPass> {
+  void runOnOperation() override;
+};
+
+/// The outcome of balancing a module.
+struct ModuleResult {
+  unsigned depthBefore = 0, depthAfter = 0;
+  size_t numChainsBalanced = 0;
+};
+} // end anonymous namespace
+
+void RTLBalanceLogicPass::runOnOperation() {
+  SmallVector<Operation *, 16> modules;
+  for (auto module : getOperation().getOps<rtl::RTLModuleOp>())
+    modules.push_back(module);
+
+  // The modules are balanced independently, so they can be processed in
+  // parallel.
+  DelayWeights weights;
+  weights.logic = logicDelay;
+  weights.arith = arithDelay;
+  weights.mux = muxDelay;
+  WeightedDelayModel delayModel(weights);
+  SmallVector<ModuleResult, 16> results(modules.size());
+  parallelForEachLargestFirst(&getContext(), modules, [&](size_t index) {
+    auto &block = cast<rtl::RTLModuleOp>(modules[index]).getBody().front();
+    LogicBalancer balancer(delayModel);
+    auto &result = results[index];
+    result.depthBefore = balancer.run(block, /*rebalance=*/false);
+    result.depthAfter = balancer.run(block, /*rebalance=*/true);
+    result.numChainsBalanced = balancer.numChainsBalanced;
+  });
+
+  size_t numBalanced = 0;
+  for (auto &result : results) {
+    criticalPathBefore.updateMax(result.depthBefore);
+    criticalPathAfter.updateMax(result.depthAfter);
+    numBalanced += result.numChainsBalanced;
+  }
+  numChainsBalanced += numBalanced;
+
+  if (!numBalanced)
+    markAllAnalysesPreserved();
+}
+
+std::unique_ptr<Pass> circt::sv::createRTLBalanceLogicPass() {
+  return std::make_unique<RTLBalanceLogicPass>();
+}
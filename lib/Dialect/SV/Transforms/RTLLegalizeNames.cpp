@@ -14,6 +14,7 @@
 #include "SVPassDetail.h"
 #include "circt/Dialect/SV/SVOps.h"
 #include "circt/Dialect/SV/SVPasses.h"
+#include "circt/Support/ParallelScheduling.h"
 
 using namespace circt;
 using namespace sv;
@@ -63,8 +64,9 @@ struct RTLLegalizeNamesPass
 private:
   bool anythingChanged;
 
-  void runOnModule(rtl::RTLModuleOp module);
-  void runOnInterface(sv::InterfaceOp intf, mlir::SymbolUserMap &symbolUsers);
+  bool runOnModule(rtl::RTLModuleOp module);
+  void runOnInterface(sv::InterfaceOp intf,
+                      function_ref<mlir::SymbolUserMap &()> getSymbolUsers);
 };
 } // end anonymous namespace
 
@@ -72,7 +74,15 @@ void RTLLegalizeNamesPass::runOnOperation() {
   anythingChanged = false;
   ModuleOp root = getOperation();
   mlir::SymbolTableCollection symbolTable;
-  mlir::SymbolUserMap symbolUsers(symbolTable, root);
+
+  // The symbol user map walks the whole design, so only build it once a symbol
+  // actually needs to be renamed.
+  std::unique_ptr<mlir::SymbolUserMap> symbolUserMap;
+  auto getSymbolUsers = [&]() -> mlir::SymbolUserMap & {
+    if (!symbolUserMap)
+      symbolUserMap = std::make_unique<mlir::SymbolUserMap>(symbolTable, root);
+    return *symbolUserMap;
+  };
 
   // Analyze the legal names for top-level operations in the MLIR module.
   NameCollisionResolver nameResolver;
@@ -100,17 +110,19 @@ void RTLLegalizeNamesPass::runOnOperation() {
     if (newName.empty())
       continue;
 
-    symbolUsers.replaceAllUsesWith(&op, newName);
+    getSymbolUsers().replaceAllUsesWith(&op, newName);
     SymbolTable::setSymbolName(&op, newName);
     anythingChanged = true;
   }
 
-  // Rename individual operations.
+  // Rename individual operations.  Interfaces are renamed through the symbol
+  // user map, which spans the whole design, so they are handled serially.
+  SmallVector<Operation *, 32> modules;
   for (auto &op : *root.getBody()) {
-    if (auto module = dyn_cast<RTLModuleOp>(op)) {
-      runOnModule(module);
+    if (isa<RTLModuleOp>(op)) {
+      modules.push_back(&op);
     } else if (auto intf = dyn_cast<InterfaceOp>(op)) {
-      runOnInterface(intf, symbolUsers);
+      runOnInterface(intf, getSymbolUsers);
     } else if (auto extMod = dyn_cast<RTLModuleExternOp>(op)) {
       auto name = extMod.getVerilogModuleName();
       if (!sv::isNameValid(name)) {
@@ -119,14 +131,27 @@ void RTLLegalizeNamesPass::runOnOperation() {
     }
   }
 
+  // The names inside of a module are only resolved against each other, so the
+  // modules can be renamed in parallel.
+  SmallVector<char, 32> modulesChanged(modules.size());
+  parallelForEachLargestFirst(&getContext(), modules, [&](size_t index) {
+    modulesChanged[index] = runOnModule(cast<RTLModuleOp>(modules[index]));
+  });
+  if (llvm::is_contained(modulesChanged, 1))
+    anythingChanged = true;
+
   // If we did not change anything in the graph mark all analysis as
   // preserved.
   if (!anythingChanged)
     markAllAnalysesPreserved();
 }
 
-void RTLLegalizeNamesPass::runOnModule(rtl::RTLModuleOp module) {
+/// Rename the ports, instances, regs, and wires of the specified module, and
+/// return true if anything changed.  This may run concurrently for different
+/// modules, so it must not touch anything outside of the module.
+bool RTLLegalizeNamesPass::runOnModule(rtl::RTLModuleOp module) {
   NameCollisionResolver nameResolver;
+  bool changed = false;
 
   bool changedArgNames = false, changedOutputNames = false;
   SmallVector<Attribute> argNames, outputNames;
@@ -148,11 +173,11 @@ void RTLLegalizeNamesPass::runOnModule(rtl::RTLModuleOp module) {
 
   if (changedArgNames) {
     setModuleArgumentNames(module, argNames);
-    anythingChanged = true;
+    changed = true;
   }
   if (changedOutputNames) {
     setModuleResultNames(module, outputNames);
-    anythingChanged = true;
+    changed = true;
   }
 
   // Rename the instances, regs, and wires.
@@ -161,21 +186,24 @@ void RTLLegalizeNamesPass::runOnModule(rtl::RTLModuleOp module) {
       auto newName = nameResolver.getLegalName(instanceOp.getNameAttr());
       if (!newName.empty()) {
         instanceOp.setName(newName);
-        anythingChanged = true;
+        changed = true;
       }
     } else if (isa<RegOp>(op) || isa<WireOp>(op)) {
       auto oldName = op.getAttrOfType<StringAttr>("name");
       auto newName = nameResolver.getLegalName(oldName);
       if (!newName.empty()) {
         op.setAttr("name", StringAttr::get(op.getContext(), newName));
-        anythingChanged = true;
+        changed = true;
       }
     }
   }
+
+  return changed;
 }
 
-void RTLLegalizeNamesPass::runOnInterface(InterfaceOp interface,
-                                          mlir::SymbolUserMap &symbolUsers) {
+void RTLLegalizeNamesPass::runOnInterface(
+    InterfaceOp interface,
+    function_ref<mlir::SymbolUserMap &()> getSymbolUsers) {
   NameCollisionResolver localNames;
   auto symbolAttrName = SymbolTable::getSymbolAttrName();
 
@@ -188,7 +216,7 @@ void RTLLegalizeNamesPass::runOnInterface(InterfaceOp interface,
     auto newName = localNames.getLegalName(oldName);
     if (newName.empty())
       continue;
-    symbolUsers.replaceAllUsesWith(&op, newName);
+    getSymbolUsers().replaceAllUsesWith(&op, newName);
     SymbolTable::setSymbolName(&op, newName);
     anythingChanged = true;
   }
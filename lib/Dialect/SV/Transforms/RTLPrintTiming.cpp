@@ -0,0 +1,78 @@
+//===- RTLPrintTiming.cpp - Print the critical paths of rtl.modules -------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass prints the critical path of each rtl.module, as estimated by the
+// timing analysis, and annotates the operations with their arrival times.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SVPassDetail.h"
+#include "circt/Analysis/TimingAnalysis.h"
+#include "circt/Dialect/SV/SVPasses.h"
+#include "mlir/IR/Builders.h"
+
+using namespace circt;
+
+namespace {
+struct RTLPrintTimingPass : public sv::RTLPrintTimingBase<RTLPrintTimingPass> {
+  explicit RTLPrintTimingPass(raw_ostream &os) : os(os) {}
+  void runOnOperation() override;
+
+private:
+  raw_ostream &os;
+};
+} // end anonymous namespace
+
+/// Return the latest arrival time of the results of the operation.
+static int getArrival(const TimingAnalysis &timing, Operation *op) {
+  int arrival = -1;
+  for (auto result : op->getResults())
+    arrival = std::max(arrival, timing.getArrival(result).get());
+  return arrival;
+}
+
+void RTLPrintTimingPass::runOnOperation() {
+  DelayWeights weights;
+  weights.logic = logicDelay;
+  weights.arith = arithDelay;
+  weights.mux = muxDelay;
+  WeightedDelayModel delayModel(weights);
+  TimingAnalysis timing(getOperation(), delayModel);
+
+  OpBuilder builder(&getContext());
+  auto arrivalID = builder.getIdentifier("timing.arrival");
+  for (auto module : getOperation().getOps<rtl::RTLModuleOp>()) {
+    auto *moduleTiming = timing.getModuleTiming(module);
+    os << "@" << SymbolTable::getSymbolName(module) << ": ";
+    if (moduleTiming->criticalPath < 0) {
+      os << "no timing paths\n";
+    } else {
+      auto path = timing.getCriticalPath(module);
+      os << "critical path " << moduleTiming->criticalPath << ", ending at "
+         << path.back()->getName() << "\n";
+      for (auto *op : ArrayRef<Operation *>(path).drop_back())
+        os << "  " << getArrival(timing, op) << " " << op->getName() << " "
+           << op->getLoc() << "\n";
+    }
+
+    if (!annotate)
+      continue;
+    module.getBodyBlock()->walk([&](Operation *op) {
+      int arrival = getArrival(timing, op);
+      if (arrival >= 0)
+        op->setAttr(arrivalID, builder.getI64IntegerAttr(arrival));
+    });
+  }
+
+  if (!annotate)
+    markAllAnalysesPreserved();
+}
+
+std::unique_ptr<Pass> circt::sv::createRTLPrintTimingPass(raw_ostream &os) {
+  return std::make_unique<RTLPrintTimingPass>(os);
+}
@@ -0,0 +1,232 @@
+//===- RTLStructuralCSE.cpp - RTL Structural CSE Pass ---------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass eliminates structurally equivalent side effect free operations in
+// rtl.module bodies.  Unlike the generic CSE pass, it processes graph regions
+// in the order of their data dependencies rather than in the order of their
+// operations, so it also finds redundancy in operations used before they are
+// defined, and it considers the operands of commutative operations in any
+// order.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SVPassDetail.h"
+#include "circt/Dialect/SV/SVPasses.h"
+#include "mlir/IR/RegionKindInterface.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/ScopedHashTable.h"
+
+using namespace circt;
+
+//===----------------------------------------------------------------------===//
+// Helper utilities
+//===----------------------------------------------------------------------===//
+
+/// Return true if the specified operation can be eliminated in favor of an
+/// equivalent operation.
+static bool isCSECandidate(Operation *op) {
+  return op->getNumResults() != 0 && op->getNumRegions() == 0 &&
+         op->getNumSuccessors() == 0 &&
+         !op->hasTrait<OpTrait::IsTerminator>() &&
+         MemoryEffectOpInterface::hasNoEffect(op);
+}
+
+/// Return true if the operations in the region may use values before they are
+/// defined.
+static bool isGraphRegion(Region &region) {
+  auto kindInterface = dyn_cast<RegionKindInterface>(region.getParentOp());
+  return kindInterface &&
+         kindInterface.getRegionKind(region.getRegionNumber()) ==
+             RegionKind::Graph;
+}
+
+namespace {
+/// An operation along with its structural hash.  The hash is computed once,
+/// after the operands of the operation have been replaced by their
+/// equivalents, so lookups never rehash the operation.
+struct HashedOp {
+  Operation *op;
+  unsigned hash;
+};
+
+struct HashedOpInfo {
+  static HashedOp getEmptyKey() {
+    return {llvm::DenseMapInfo<Operation *>::getEmptyKey(), 0};
+  }
+  static HashedOp getTombstoneKey() {
+    return {llvm::DenseMapInfo<Operation *>::getTombstoneKey(), 0};
+  }
+  static unsigned getHashValue(const HashedOp &key) { return key.hash; }
+  static bool isEqual(const HashedOp &lhs, const HashedOp &rhs);
+};
+} // end anonymous namespace
+
+/// Collect the operands of the operation in a canonical order.  The operands
+/// of commutative operations are sorted, so that they match regardless of the
+/// order they are written in.
+static void getCanonicalOperands(Operation *op,
+                                 SmallVectorImpl<Value> &operands) {
+  operands.assign(op->operand_begin(), op->operand_end());
+  if (op->hasTrait<OpTrait::IsCommutative>())
+    llvm::sort(operands, [](Value lhs, Value rhs) {
+      return lhs.getAsOpaquePointer() < rhs.getAsOpaquePointer();
+    });
+}
+
+static unsigned computeHash(Operation *op) {
+  SmallVector<Value, 4> operands;
+  getCanonicalOperands(op, operands);
+  return llvm::hash_combine(
+      op->getName(), op->getAttrDictionary(),
+      llvm::hash_combine_range(op->result_type_begin(), op->result_type_end()),
+      llvm::hash_combine_range(operands.begin(), operands.end()));
+}
+
+bool HashedOpInfo::isEqual(const HashedOp &lhs, const HashedOp &rhs) {
+  if (lhs.op == rhs.op)
+    return true;
+  if (lhs.hash != rhs.hash || lhs.op == getEmptyKey().op ||
+      lhs.op == getTombstoneKey().op || rhs.op == getEmptyKey().op ||
+      rhs.op == getTombstoneKey().op)
+    return false;
+
+  auto *lhsOp = lhs.op, *rhsOp = rhs.op;
+  if (lhsOp->getName() != rhsOp->getName() ||
+      lhsOp->getAttrDictionary() != rhsOp->getAttrDictionary() ||
+      lhsOp->getResultTypes() != rhsOp->getResultTypes() ||
+      lhsOp->getNumOperands() != rhsOp->getNumOperands())
+    return false;
+
+  // The operands have already been replaced by their equivalents, so they
+  // only need to be compared for identity.
+  if (!lhsOp->hasTrait<OpTrait::IsCommutative>())
+    return lhsOp->getOperands() == rhsOp->getOperands();
+  SmallVector<Value, 4> lhsOperands, rhsOperands;
+  getCanonicalOperands(lhsOp, lhsOperands);
+  getCanonicalOperands(rhsOp, rhsOperands);
+  return lhsOperands == rhsOperands;
+}
+
+//===----------------------------------------------------------------------===//
+// RTLStructuralCSEPass
+//===----------------------------------------------------------------------===//
+
+namespace {
+struct RTLStructuralCSEPass
+    : public sv::RTLStructuralCSEBase<RTLStructuralCSEPass> {
+  void runOnOperation() override;
+
+private:
+  using ScopedTable = llvm::ScopedHashTable<HashedOp, Operation *,
+                                            HashedOpInfo>;
+  using Scope = llvm::ScopedHashTableScope<HashedOp, Operation *,
+                                           HashedOpInfo>;
+
+  void simplifyRegion(Region &region);
+  void simplifyGraphBlock(Block &block);
+  void simplifyOrderedBlock(Block &block);
+
+  /// Replace the operation with an equivalent one in scope, or make it
+  /// available to the operations which follow.
+  void simplifyOperation(Operation *op);
+
+  /// The operations which are available in the current scope.
+  ScopedTable knownOps;
+
+  /// The operations which were replaced, and are erased at the end of the
+  /// pass.  Erasing them later keeps the block iterators valid.
+  SmallVector<Operation *, 0> opsToErase;
+};
+} // end anonymous namespace
+
+void RTLStructuralCSEPass::runOnOperation() {
+  simplifyRegion(getOperation().getBody());
+
+  if (opsToErase.empty()) {
+    markAllAnalysesPreserved();
+    return;
+  }
+
+  numCSE += opsToErase.size();
+  for (auto *op : opsToErase)
+    op->erase();
+  opsToErase.clear();
+}
+
+void RTLStructuralCSEPass::simplifyOperation(Operation *op) {
+  if (!isCSECandidate(op))
+    return;
+
+  HashedOp key{op, computeHash(op)};
+  if (auto *existing = knownOps.lookup(key)) {
+    op->replaceAllUsesWith(existing);
+    opsToErase.push_back(op);
+    return;
+  }
+  knownOps.insert(key, op);
+}
+
+void RTLStructuralCSEPass::simplifyRegion(Region &region) {
+  if (!llvm::hasSingleElement(region))
+    return;
+
+  Scope scope(knownOps);
+  if (isGraphRegion(region))
+    simplifyGraphBlock(region.front());
+  else
+    simplifyOrderedBlock(region.front());
+}
+
+/// Operations in graph regions may be used before they are defined, so they
+/// are visited in post order of their operands within the block.  This way the
+/// operands of every operation have been replaced by their equivalents before
+/// the operation itself is hashed.  Operations on a cycle are visited in block
+/// order once the cycle is found.
+void RTLStructuralCSEPass::simplifyGraphBlock(Block &block) {
+  DenseSet<Operation *> visited;
+  SmallVector<std::pair<Operation *, unsigned>, 16> stack;
+  for (auto &root : block) {
+    if (!visited.insert(&root).second)
+      continue;
+    stack.push_back({&root, 0});
+    while (!stack.empty()) {
+      auto &entry = stack.back();
+      auto *op = entry.first;
+      if (entry.second != op->getNumOperands()) {
+        auto *def = op->getOperand(entry.second++).getDefiningOp();
+        if (def && def->getBlock() == &block && visited.insert(def).second)
+          stack.push_back({def, 0});
+        continue;
+      }
+      stack.pop_back();
+      simplifyOperation(op);
+    }
+  }
+
+  // Nested regions can use any of the operations in the block, so they are
+  // visited once the whole block is available.
+  for (auto &op : block)
+    for (auto &region : op.getRegions())
+      simplifyRegion(region);
+}
+
+/// Operations in ordered regions only use values defined before them, so they
+/// are visited in order.  Nested regions are visited as they are reached, so
+/// that they only see the operations which dominate them.
+void RTLStructuralCSEPass::simplifyOrderedBlock(Block &block) {
+  for (auto &op : block) {
+    for (auto &region : op.getRegions())
+      simplifyRegion(region);
+    simplifyOperation(&op);
+  }
+}
+
+std::unique_ptr<Pass> circt::sv::createRTLStructuralCSEPass() {
+  return std::make_unique<RTLStructuralCSEPass>();
+}
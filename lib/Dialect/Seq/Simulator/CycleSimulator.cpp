@@ -0,0 +1,1115 @@
+//===- CycleSimulator.cpp - Cycle-based RTL simulator ---------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the cycle-based simulators.  The design is compiled
+// into a Program: a flat array of 64-bit words holding every value in the
+// design, and a list of nodes, one per combinational operation, sorted so that
+// every node comes after the nodes computing its operands.  In bit-parallel
+// mode, each bit of a value has its own words, holding that bit for all lanes.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/Seq/Simulator/CycleSimulator.h"
+#include "circt/Dialect/Comb/CombOps.h"
+#include "circt/Dialect/RTL/RTLOps.h"
+#include "circt/Dialect/Seq/SeqOps.h"
+#include "mlir/IR/SymbolTable.h"
+#include "llvm/ADT/TypeSwitch.h"
+
+using namespace circt;
+using namespace seq;
+using namespace sim;
+
+//===----------------------------------------------------------------------===//
+// Program
+//===----------------------------------------------------------------------===//
+
+namespace {
+enum class Opcode : uint8_t {
+  Copy,
+  Add,
+  Sub,
+  Mul,
+  DivU,
+  DivS,
+  ModU,
+  ModS,
+  Shl,
+  ShrU,
+  ShrS,
+  And,
+  Or,
+  Xor,
+  ICmp,
+  Parity,
+  SExt,
+  Concat,
+  Extract,
+  Mux
+};
+
+/// A value in the program, identified by the offset of its first word.
+struct Slot {
+  unsigned offset;
+  unsigned width;
+};
+
+/// A combinational operation.
+struct Node {
+  Opcode opcode;
+  /// True if the result and all the operands fit in a single word.
+  bool isNarrow;
+  /// The low bit of extracts, or the predicate of comparisons.
+  unsigned immediate;
+  Slot result;
+  SmallVector<Slot, 2> operands;
+};
+
+struct Register {
+  Slot state, input;
+  /// The synchronous reset and the value it selects, if any.
+  Optional<Slot> reset, resetValue;
+  /// The offset of the next state of the register in the latch buffer.
+  unsigned nextOffset;
+};
+} // end anonymous namespace
+
+/// Return the number of words used to store a value of the specified width.
+static unsigned getNumWords(unsigned width) {
+  return width <= 64 ? 1 : (width + 63) / 64;
+}
+
+static uint64_t getMask(unsigned width) {
+  return width >= 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+}
+
+static int64_t signExtend(uint64_t value, unsigned width) {
+  if (width == 0)
+    return 0;
+  unsigned shift = 64 - width;
+  return int64_t(value << shift) >> shift;
+}
+
+namespace circt {
+namespace seq {
+namespace sim {
+struct Program {
+  /// The number of words holding each bit of a value in bit-parallel mode, or
+  /// zero if values are packed into words.
+  unsigned laneWords = 0;
+
+  /// The storage for every value in the design.
+  SmallVector<uint64_t, 0> words;
+  /// The combinational logic, in the order it is evaluated.
+  std::vector<Node> nodes;
+  std::vector<Register> registers;
+  /// The next state of the registers, computed before any of them is updated.
+  SmallVector<uint64_t, 0> latches;
+  SmallVector<Slot, 4> inputs, outputs;
+  /// Temporary storage for the shifts in bit-parallel mode.
+  SmallVector<uint64_t, 0> scratch, scratchNext;
+
+  /// Return the number of words used to store a value of the specified width.
+  unsigned getSize(unsigned width) const {
+    return laneWords ? std::max(width, 1U) * laneWords : getNumWords(width);
+  }
+
+  /// Return the words holding the specified bit of a value in bit-parallel
+  /// mode.
+  uint64_t *getBit(Slot slot, unsigned bit) {
+    return &words[slot.offset + bit * laneWords];
+  }
+
+  APInt read(Slot slot) const {
+    if (slot.width == 0)
+      return APInt(1, 0);
+    return APInt(slot.width, ArrayRef<uint64_t>(&words[slot.offset],
+                                                getNumWords(slot.width)));
+  }
+
+  void write(Slot slot, const APInt &value) {
+    if (slot.width == 0)
+      return;
+    std::copy_n(value.getRawData(), getNumWords(slot.width),
+                &words[slot.offset]);
+  }
+
+  /// Write a constant into the storage of a value, in either mode.
+  void writeConstant(Slot slot, const APInt &value);
+
+  void evaluate();
+  void evaluateNarrow(const Node &node);
+  void evaluateWide(const Node &node);
+  void evaluateBitParallel(const Node &node);
+
+  /// Compute the carry out of `lhs + ~rhs + 1`, which is set in the lanes
+  /// where `lhs >= rhs`.
+  void computeNotLess(Slot lhs, Slot rhs, bool isSigned, uint64_t *result);
+
+  /// Update all of the registers with their next state.
+  void latchRegisters();
+};
+} // namespace sim
+} // namespace seq
+} // namespace circt
+
+void Program::evaluateNarrow(const Node &node) {
+  uint64_t *w = words.data();
+  auto operand = [&](unsigned index) {
+    return w[node.operands[index].offset];
+  };
+  unsigned width = node.result.width;
+  uint64_t result = 0;
+
+  switch (node.opcode) {
+  case Opcode::Copy:
+    result = operand(0);
+    break;
+  case Opcode::Add:
+    result = operand(0);
+    for (unsigned i = 1, e = node.operands.size(); i != e; ++i)
+      result += operand(i);
+    break;
+  case Opcode::Sub:
+    result = operand(0) - operand(1);
+    break;
+  case Opcode::Mul:
+    result = operand(0);
+    for (unsigned i = 1, e = node.operands.size(); i != e; ++i)
+      result *= operand(i);
+    break;
+  case Opcode::DivU:
+    if (auto rhs = operand(1))
+      result = operand(0) / rhs;
+    break;
+  case Opcode::DivS:
+    if (auto rhs = signExtend(operand(1), width)) {
+      auto lhs = signExtend(operand(0), width);
+      // Avoid the overflow of INT64_MIN / -1, which wraps around.
+      result = rhs == -1 ? -uint64_t(lhs) : uint64_t(lhs / rhs);
+    }
+    break;
+  case Opcode::ModU:
+    if (auto rhs = operand(1))
+      result = operand(0) % rhs;
+    break;
+  case Opcode::ModS:
+    if (auto rhs = signExtend(operand(1), width))
+      if (rhs != -1)
+        result = uint64_t(signExtend(operand(0), width) % rhs);
+    break;
+  case Opcode::Shl:
+    if (operand(1) < width)
+      result = operand(0) << operand(1);
+    break;
+  case Opcode::ShrU:
+    if (operand(1) < width)
+      result = operand(0) >> operand(1);
+    break;
+  case Opcode::ShrS:
+    result = uint64_t(signExtend(operand(0), width) >>
+                      std::min<uint64_t>(operand(1), 63));
+    break;
+  case Opcode::And:
+    result = operand(0);
+    for (unsigned i = 1, e = node.operands.size(); i != e; ++i)
+      result &= operand(i);
+    break;
+  case Opcode::Or:
+    result = operand(0);
+    for (unsigned i = 1, e = node.operands.size(); i != e; ++i)
+      result |= operand(i);
+    break;
+  case Opcode::Xor:
+    result = operand(0);
+    for (unsigned i = 1, e = node.operands.size(); i != e; ++i)
+      result ^= operand(i);
+    break;
+  case Opcode::ICmp: {
+    auto lhs = operand(0), rhs = operand(1);
+    auto operandWidth = node.operands[0].width;
+    auto slhs = signExtend(lhs, operandWidth);
+    auto srhs = signExtend(rhs, operandWidth);
+    switch (comb::ICmpPredicate(node.immediate)) {
+    case comb::ICmpPredicate::eq:
+      result = lhs == rhs;
+      break;
+    case comb::ICmpPredicate::ne:
+      result = lhs != rhs;
+      break;
+    case comb::ICmpPredicate::slt:
+      result = slhs < srhs;
+      break;
+    case comb::ICmpPredicate::sle:
+      result = slhs <= srhs;
+      break;
+    case comb::ICmpPredicate::sgt:
+      result = slhs > srhs;
+      break;
+    case comb::ICmpPredicate::sge:
+      result = slhs >= srhs;
+      break;
+    case comb::ICmpPredicate::ult:
+      result = lhs < rhs;
+      break;
+    case comb::ICmpPredicate::ule:
+      result = lhs <= rhs;
+      break;
+    case comb::ICmpPredicate::ugt:
+      result = lhs > rhs;
+      break;
+    case comb::ICmpPredicate::uge:
+      result = lhs >= rhs;
+      break;
+    }
+    break;
+  }
+  case Opcode::Parity:
+    result = llvm::countPopulation(operand(0)) & 1;
+    break;
+  case Opcode::SExt:
+    result = uint64_t(signExtend(operand(0), node.operands[0].width));
+    break;
+  case Opcode::Concat:
+    // The first operand holds the most significant bits.
+    for (unsigned i = 0, e = node.operands.size(); i != e; ++i) {
+      auto operandWidth = node.operands[i].width;
+      result = operandWidth >= 64 ? operand(i)
+                                  : (result << operandWidth) | operand(i);
+    }
+    break;
+  case Opcode::Extract:
+    if (node.immediate < 64)
+      result = operand(0) >> node.immediate;
+    break;
+  case Opcode::Mux:
+    result = operand(0) ? operand(1) : operand(2);
+    break;
+  }
+
+  w[node.result.offset] = result & getMask(width);
+}
+
+void Program::evaluateWide(const Node &node) {
+  unsigned width = node.result.width;
+  if (width == 0)
+    return;
+
+  auto operand = [&](unsigned index) { return read(node.operands[index]); };
+  APInt result(width, 0);
+
+  switch (node.opcode) {
+  case Opcode::Copy:
+    result = operand(0);
+    break;
+  case Opcode::Add:
+    result = operand(0);
+    for (unsigned i = 1, e = node.operands.size(); i != e; ++i)
+      result += operand(i);
+    break;
+  case Opcode::Sub:
+    result = operand(0) - operand(1);
+    break;
+  case Opcode::Mul:
+    result = operand(0);
+    for (unsigned i = 1, e = node.operands.size(); i != e; ++i)
+      result *= operand(i);
+    break;
+  case Opcode::DivU: {
+    auto rhs = operand(1);
+    if (!rhs.isNullValue())
+      result = operand(0).udiv(rhs);
+    break;
+  }
+  case Opcode::DivS: {
+    auto rhs = operand(1);
+    if (!rhs.isNullValue())
+      result = operand(0).sdiv(rhs);
+    break;
+  }
+  case Opcode::ModU: {
+    auto rhs = operand(1);
+    if (!rhs.isNullValue())
+      result = operand(0).urem(rhs);
+    break;
+  }
+  case Opcode::ModS: {
+    auto rhs = operand(1);
+    if (!rhs.isNullValue())
+      result = operand(0).srem(rhs);
+    break;
+  }
+  case Opcode::Shl: {
+    auto amount = operand(1);
+    if (amount.ult(width))
+      result = operand(0).shl(amount.getZExtValue());
+    break;
+  }
+  case Opcode::ShrU: {
+    auto amount = operand(1);
+    if (amount.ult(width))
+      result = operand(0).lshr(amount.getZExtValue());
+    break;
+  }
+  case Opcode::ShrS: {
+    auto amount = operand(1);
+    result = operand(0).ashr(amount.ult(width) ? amount.getZExtValue()
+                                               : width - 1);
+    break;
+  }
+  case Opcode::And:
+    result = operand(0);
+    for (unsigned i = 1, e = node.operands.size(); i != e; ++i)
+      result &= operand(i);
+    break;
+  case Opcode::Or:
+    result = operand(0);
+    for (unsigned i = 1, e = node.operands.size(); i != e; ++i)
+      result |= operand(i);
+    break;
+  case Opcode::Xor:
+    result = operand(0);
+    for (unsigned i = 1, e = node.operands.size(); i != e; ++i)
+      result ^= operand(i);
+    break;
+  case Opcode::ICmp: {
+    auto lhs = operand(0), rhs = operand(1);
+    bool value = false;
+    switch (comb::ICmpPredicate(node.immediate)) {
+    case comb::ICmpPredicate::eq:
+      value = lhs.eq(rhs);
+      break;
+    case comb::ICmpPredicate::ne:
+      value = lhs.ne(rhs);
+      break;
+    case comb::ICmpPredicate::slt:
+      value = lhs.slt(rhs);
+      break;
+    case comb::ICmpPredicate::sle:
+      value = lhs.sle(rhs);
+      break;
+    case comb::ICmpPredicate::sgt:
+      value = lhs.sgt(rhs);
+      break;
+    case comb::ICmpPredicate::sge:
+      value = lhs.sge(rhs);
+      break;
+    case comb::ICmpPredicate::ult:
+      value = lhs.ult(rhs);
+      break;
+    case comb::ICmpPredicate::ule:
+      value = lhs.ule(rhs);
+      break;
+    case comb::ICmpPredicate::ugt:
+      value = lhs.ugt(rhs);
+      break;
+    case comb::ICmpPredicate::uge:
+      value = lhs.uge(rhs);
+      break;
+    }
+    result = APInt(width, value);
+    break;
+  }
+  case Opcode::Parity:
+    result = APInt(width, operand(0).countPopulation() & 1);
+    break;
+  case Opcode::SExt:
+    result = operand(0).sext(width);
+    break;
+  case Opcode::Concat: {
+    // The first operand holds the most significant bits.
+    unsigned position = width;
+    for (unsigned i = 0, e = node.operands.size(); i != e; ++i) {
+      auto operandWidth = node.operands[i].width;
+      if (operandWidth == 0)
+        continue;
+      position -= operandWidth;
+      result.insertBits(operand(i), position);
+    }
+    break;
+  }
+  case Opcode::Extract:
+    result = operand(0).extractBits(width, node.immediate);
+    break;
+  case Opcode::Mux:
+    result = operand(0).getBoolValue() ? operand(1) : operand(2);
+    break;
+  }
+
+  write(node.result, result);
+}
+
+void Program::computeNotLess(Slot lhs, Slot rhs, bool isSigned,
+                             uint64_t *result) {
+  unsigned width = lhs.width;
+  std::fill_n(result, laneWords, ~uint64_t(0));
+  for (unsigned bit = 0; bit != width; ++bit) {
+    auto *a = getBit(lhs, bit), *b = getBit(rhs, bit);
+    // Comparing signed values is comparing them with their sign bit flipped.
+    bool flip = isSigned && bit == width - 1;
+    for (unsigned k = 0; k != laneWords; ++k) {
+      uint64_t x = flip ? ~a[k] : a[k], y = flip ? b[k] : ~b[k];
+      result[k] = (x & y) | (result[k] & (x ^ y));
+    }
+  }
+}
+
+void Program::evaluateBitParallel(const Node &node) {
+  unsigned width = node.result.width;
+  auto result = [&](unsigned bit) { return getBit(node.result, bit); };
+  auto operand = [&](unsigned index, unsigned bit) {
+    return getBit(node.operands[index], bit);
+  };
+
+  switch (node.opcode) {
+  case Opcode::Copy:
+    std::copy_n(operand(0, 0), getSize(width), result(0));
+    break;
+  case Opcode::Add:
+  case Opcode::Sub: {
+    // Add the operands one at a time with a ripple carry adder, as `a - b` is
+    // `a + ~b + 1`.
+    bool isSub = node.opcode == Opcode::Sub;
+    std::copy_n(operand(0, 0), getSize(width), result(0));
+    for (unsigned i = 1, e = node.operands.size(); i != e; ++i) {
+      for (unsigned k = 0; k != laneWords; ++k) {
+        uint64_t carry = isSub ? ~uint64_t(0) : 0;
+        for (unsigned bit = 0; bit != width; ++bit) {
+          uint64_t a = result(bit)[k];
+          uint64_t b = isSub ? ~operand(i, bit)[k] : operand(i, bit)[k];
+          result(bit)[k] = a ^ b ^ carry;
+          carry = (a & b) | (carry & (a ^ b));
+        }
+      }
+    }
+    break;
+  }
+  case Opcode::Shl:
+  case Opcode::ShrU:
+  case Opcode::ShrS: {
+    // Shift with a barrel shifter, one stage per bit of the amount.
+    auto amount = node.operands[1];
+    scratch.assign(operand(0, 0), operand(0, 0) + getSize(width));
+    scratchNext.resize(scratch.size());
+    SmallVector<uint64_t, 4> overflow(laneWords, 0);
+    for (unsigned stage = 0; stage != amount.width; ++stage) {
+      auto *select = getBit(amount, stage);
+      if (stage >= 32 || (1U << stage) >= width) {
+        for (unsigned k = 0; k != laneWords; ++k)
+          overflow[k] |= select[k];
+        continue;
+      }
+      unsigned distance = 1U << stage;
+      for (unsigned bit = 0; bit != width; ++bit) {
+        // The bit shifted into this one, or -1 if it is shifted in from
+        // outside of the value.
+        int from = node.opcode == Opcode::Shl ? int(bit) - int(distance)
+                                              : int(bit + distance);
+        if (from >= int(width))
+          from = node.opcode == Opcode::ShrS ? int(width) - 1 : -1;
+        for (unsigned k = 0; k != laneWords; ++k) {
+          uint64_t kept = scratch[bit * laneWords + k];
+          uint64_t shifted = from < 0 ? 0 : scratch[from * laneWords + k];
+          scratchNext[bit * laneWords + k] =
+              (select[k] & shifted) | (~select[k] & kept);
+        }
+      }
+      std::swap(scratch, scratchNext);
+    }
+    // Shifting by the width or more leaves only the sign bits, or zeros.
+    for (unsigned bit = 0; bit != width; ++bit) {
+      for (unsigned k = 0; k != laneWords; ++k) {
+        uint64_t fill =
+            node.opcode == Opcode::ShrS ? operand(0, width - 1)[k] : 0;
+        result(bit)[k] = (overflow[k] & fill) |
+                         (~overflow[k] & scratch[bit * laneWords + k]);
+      }
+    }
+    break;
+  }
+  case Opcode::And:
+  case Opcode::Or:
+  case Opcode::Xor:
+    std::copy_n(operand(0, 0), getSize(width), result(0));
+    for (unsigned i = 1, e = node.operands.size(); i != e; ++i) {
+      for (unsigned bit = 0; bit != width; ++bit) {
+        auto *r = result(bit), *x = operand(i, bit);
+        for (unsigned k = 0; k != laneWords; ++k) {
+          if (node.opcode == Opcode::And)
+            r[k] &= x[k];
+          else if (node.opcode == Opcode::Or)
+            r[k] |= x[k];
+          else
+            r[k] ^= x[k];
+        }
+      }
+    }
+    break;
+  case Opcode::ICmp: {
+    auto lhs = node.operands[0], rhs = node.operands[1];
+    auto predicate = comb::ICmpPredicate(node.immediate);
+    auto *r = result(0);
+    switch (predicate) {
+    case comb::ICmpPredicate::eq:
+    case comb::ICmpPredicate::ne:
+      std::fill_n(r, laneWords, ~uint64_t(0));
+      for (unsigned bit = 0; bit != lhs.width; ++bit)
+        for (unsigned k = 0; k != laneWords; ++k)
+          r[k] &= ~(getBit(lhs, bit)[k] ^ getBit(rhs, bit)[k]);
+      if (predicate == comb::ICmpPredicate::ne)
+        for (unsigned k = 0; k != laneWords; ++k)
+          r[k] = ~r[k];
+      break;
+    case comb::ICmpPredicate::uge:
+      computeNotLess(lhs, rhs, false, r);
+      break;
+    case comb::ICmpPredicate::sge:
+      computeNotLess(lhs, rhs, true, r);
+      break;
+    case comb::ICmpPredicate::ule:
+      computeNotLess(rhs, lhs, false, r);
+      break;
+    case comb::ICmpPredicate::sle:
+      computeNotLess(rhs, lhs, true, r);
+      break;
+    case comb::ICmpPredicate::ult:
+    case comb::ICmpPredicate::slt:
+    case comb::ICmpPredicate::ugt:
+    case comb::ICmpPredicate::sgt: {
+      bool isSigned = predicate == comb::ICmpPredicate::slt ||
+                      predicate == comb::ICmpPredicate::sgt;
+      if (predicate == comb::ICmpPredicate::ult ||
+          predicate == comb::ICmpPredicate::slt)
+        computeNotLess(lhs, rhs, isSigned, r);
+      else
+        computeNotLess(rhs, lhs, isSigned, r);
+      for (unsigned k = 0; k != laneWords; ++k)
+        r[k] = ~r[k];
+      break;
+    }
+    }
+    break;
+  }
+  case Opcode::Parity: {
+    auto *r = result(0);
+    std::fill_n(r, laneWords, 0);
+    for (unsigned bit = 0, e = node.operands[0].width; bit != e; ++bit)
+      for (unsigned k = 0; k != laneWords; ++k)
+        r[k] ^= operand(0, bit)[k];
+    break;
+  }
+  case Opcode::SExt: {
+    unsigned inputWidth = node.operands[0].width;
+    for (unsigned bit = 0; bit != width; ++bit) {
+      if (inputWidth == 0)
+        std::fill_n(result(bit), laneWords, 0);
+      else
+        std::copy_n(operand(0, std::min(bit, inputWidth - 1)), laneWords,
+                    result(bit));
+    }
+    break;
+  }
+  case Opcode::Concat: {
+    // The first operand holds the most significant bits.
+    unsigned position = width;
+    for (unsigned i = 0, e = node.operands.size(); i != e; ++i) {
+      auto operandWidth = node.operands[i].width;
+      position -= operandWidth;
+      if (operandWidth)
+        std::copy_n(operand(i, 0), operandWidth * laneWords,
+                    result(position));
+    }
+    break;
+  }
+  case Opcode::Extract:
+    if (width)
+      std::copy_n(operand(0, node.immediate), width * laneWords, result(0));
+    break;
+  case Opcode::Mux:
+    for (unsigned bit = 0; bit != width; ++bit) {
+      auto *r = result(bit), *t = operand(1, bit), *f = operand(2, bit);
+      auto *c = operand(0, 0);
+      for (unsigned k = 0; k != laneWords; ++k)
+        r[k] = (c[k] & t[k]) | (~c[k] & f[k]);
+    }
+    break;
+  case Opcode::Mul:
+  case Opcode::DivU:
+  case Opcode::DivS:
+  case Opcode::ModU:
+  case Opcode::ModS:
+    llvm_unreachable("rejected when the program is built");
+  }
+}
+
+void Program::evaluate() {
+  if (laneWords) {
+    for (auto &node : nodes)
+      evaluateBitParallel(node);
+    return;
+  }
+  for (auto &node : nodes) {
+    if (node.isNarrow)
+      evaluateNarrow(node);
+    else
+      evaluateWide(node);
+  }
+}
+
+void Program::writeConstant(Slot slot, const APInt &value) {
+  if (!laneWords)
+    return write(slot, value);
+  for (unsigned bit = 0; bit != slot.width; ++bit)
+    std::fill_n(getBit(slot, bit), laneWords,
+                value[bit] ? ~uint64_t(0) : uint64_t(0));
+}
+
+void Program::latchRegisters() {
+  // Registers may feed each other, so compute all of the next states before
+  // updating any of them.
+  for (auto &reg : registers) {
+    auto size = getSize(reg.state.width);
+    auto *next = &latches[reg.nextOffset];
+    auto *input = &words[reg.input.offset];
+    if (!reg.reset) {
+      std::copy_n(input, size, next);
+      continue;
+    }
+
+    auto *resetValue = &words[reg.resetValue->offset];
+    if (!laneWords) {
+      bool isReset = words[reg.reset->offset] & 1;
+      std::copy_n(isReset ? resetValue : input, size, next);
+      continue;
+    }
+
+    // In bit-parallel mode, the reset selects the reset value lane by lane.
+    auto *reset = &words[reg.reset->offset];
+    for (unsigned i = 0; i != size; ++i) {
+      auto k = i % laneWords;
+      next[i] = (reset[k] & resetValue[i]) | (~reset[k] & input[i]);
+    }
+  }
+  for (auto &reg : registers)
+    std::copy_n(&latches[reg.nextOffset], getSize(reg.state.width),
+                &words[reg.state.offset]);
+}
+
+//===----------------------------------------------------------------------===//
+// ProgramBuilder
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// Flatten a design into a program.
+class ProgramBuilder {
+public:
+  ProgramBuilder(Program &program, ModuleOp module)
+      : program(program), symbolTable(module) {}
+
+  /// Allocate the values of the specified module and add its operations to
+  /// the program.  \p argSlots holds the values of the module's arguments, and
+  /// the values of its outputs are returned in \p outputSlots.
+  LogicalResult flatten(rtl::RTLModuleOp module, ArrayRef<Slot> argSlots,
+                        SmallVectorImpl<Slot> &outputSlots);
+
+  /// Check that all registers are clocked by the same input of the top-level
+  /// module.
+  LogicalResult checkClocks();
+
+  /// Check that all nodes can be evaluated in bit-parallel mode.
+  LogicalResult checkBitParallel();
+
+  /// Sort the nodes in the order of their data dependencies.
+  LogicalResult levelize();
+
+  /// Allocate the storage for a value of the specified type.
+  Optional<Slot> allocate(Type type, Location loc);
+
+private:
+  LogicalResult addOperation(Operation *op, DenseMap<Value, Slot> &slots);
+
+  Program &program;
+  SymbolTable symbolTable;
+
+  /// The operation each node and register was created for, for diagnostics.
+  std::vector<Operation *> nodeOps, registerOps;
+  /// The clock of each register.
+  SmallVector<Slot, 4> clocks;
+
+  /// The modules currently being flattened, to diagnose recursive instances.
+  SmallPtrSet<Operation *, 8> moduleStack;
+};
+} // end anonymous namespace
+
+Optional<Slot> ProgramBuilder::allocate(Type type, Location loc) {
+  auto intType = type.dyn_cast<IntegerType>();
+  if (!intType) {
+    mlir::emitError(loc, "cannot simulate values of type ") << type;
+    return None;
+  }
+  Slot slot{unsigned(program.words.size()), intType.getWidth()};
+  program.words.resize(program.words.size() + program.getSize(slot.width));
+  return slot;
+}
+
+LogicalResult ProgramBuilder::flatten(rtl::RTLModuleOp module,
+                                      ArrayRef<Slot> argSlots,
+                                      SmallVectorImpl<Slot> &outputSlots) {
+  if (!moduleStack.insert(module).second)
+    return module.emitError("cannot simulate recursive instances of module '")
+           << module.getName() << "'";
+
+  DenseMap<Value, Slot> slots;
+  for (auto it : llvm::zip(module.getArguments(), argSlots))
+    slots[std::get<0>(it)] = std::get<1>(it);
+
+  // Operations may be used before they are defined, so allocate all of the
+  // values up front.
+  auto *body = module.getBodyBlock();
+  for (auto &op : *body) {
+    for (auto result : op.getResults()) {
+      auto slot = allocate(result.getType(), op.getLoc());
+      if (!slot)
+        return failure();
+      slots[result] = *slot;
+    }
+  }
+
+  for (auto &op : *body) {
+    if (auto output = dyn_cast<rtl::OutputOp>(op)) {
+      for (auto operand : output.getOperands())
+        outputSlots.push_back(slots[operand]);
+      continue;
+    }
+    if (failed(addOperation(&op, slots)))
+      return failure();
+  }
+
+  moduleStack.erase(module);
+  return success();
+}
+
+LogicalResult ProgramBuilder::addOperation(Operation *op,
+                                           DenseMap<Value, Slot> &slots) {
+  // Constants are written into their storage once and never change.
+  if (auto constant = dyn_cast<rtl::ConstantOp>(op)) {
+    program.writeConstant(slots[constant.getResult()], constant.getValue());
+    return success();
+  }
+
+  // Instances are flattened into the program, and their results are copied
+  // from the outputs of the instantiated module.
+  if (auto instance = dyn_cast<rtl::InstanceOp>(op)) {
+    auto module =
+        symbolTable.lookup<rtl::RTLModuleOp>(instance.moduleName());
+    if (!module)
+      return instance.emitError("cannot simulate instance of '")
+             << instance.moduleName() << "', which has no body";
+
+    SmallVector<Slot, 4> argSlots, outputSlots;
+    for (auto input : instance.inputs())
+      argSlots.push_back(slots[input]);
+    if (failed(flatten(module, argSlots, outputSlots)))
+      return failure();
+
+    for (auto it : llvm::zip(instance.getResults(), outputSlots)) {
+      auto result = slots[std::get<0>(it)];
+      Node node{Opcode::Copy, result.width <= 64, 0, result, {std::get<1>(it)}};
+      program.nodes.push_back(std::move(node));
+      nodeOps.push_back(op);
+    }
+    return success();
+  }
+
+  if (auto reg = dyn_cast<CompRegOp>(op)) {
+    Register record;
+    record.state = slots[reg.getResult()];
+    record.input = slots[reg.input()];
+    // Like the lowering to SV, a reset without a reset value is ignored.
+    if (reg.reset() && reg.resetValue()) {
+      record.reset = slots[reg.reset()];
+      record.resetValue = slots[reg.resetValue()];
+    }
+    record.nextOffset = program.latches.size();
+    program.latches.resize(program.latches.size() +
+                           program.getSize(record.state.width));
+    program.registers.push_back(record);
+    registerOps.push_back(op);
+    clocks.push_back(slots[reg.clk()]);
+    return success();
+  }
+
+  auto opcode =
+      TypeSwitch<Operation *, Optional<Opcode>>(op)
+          .Case<comb::AddOp>([](auto) { return Opcode::Add; })
+          .Case<comb::SubOp>([](auto) { return Opcode::Sub; })
+          .Case<comb::MulOp>([](auto) { return Opcode::Mul; })
+          .Case<comb::DivUOp>([](auto) { return Opcode::DivU; })
+          .Case<comb::DivSOp>([](auto) { return Opcode::DivS; })
+          .Case<comb::ModUOp>([](auto) { return Opcode::ModU; })
+          .Case<comb::ModSOp>([](auto) { return Opcode::ModS; })
+          .Case<comb::ShlOp>([](auto) { return Opcode::Shl; })
+          .Case<comb::ShrUOp>([](auto) { return Opcode::ShrU; })
+          .Case<comb::ShrSOp>([](auto) { return Opcode::ShrS; })
+          .Case<comb::AndOp>([](auto) { return Opcode::And; })
+          .Case<comb::OrOp>([](auto) { return Opcode::Or; })
+          .Case<comb::XorOp>([](auto) { return Opcode::Xor; })
+          .Case<comb::ICmpOp>([](auto) { return Opcode::ICmp; })
+          .Case<comb::ParityOp>([](auto) { return Opcode::Parity; })
+          .Case<comb::SExtOp>([](auto) { return Opcode::SExt; })
+          .Case<comb::ConcatOp>([](auto) { return Opcode::Concat; })
+          .Case<comb::ExtractOp>([](auto) { return Opcode::Extract; })
+          .Case<comb::MuxOp>([](auto) { return Opcode::Mux; })
+          .Default([](Operation *) { return None; });
+  if (!opcode)
+    return op->emitError("operation is not supported by the cycle simulator");
+
+  Node node{*opcode, false, 0, slots[op->getResult(0)], {}};
+  if (auto icmp = dyn_cast<comb::ICmpOp>(op))
+    node.immediate = unsigned(icmp.predicate());
+  else if (auto extract = dyn_cast<comb::ExtractOp>(op))
+    node.immediate = extract.lowBit();
+
+  node.isNarrow = node.result.width <= 64;
+  for (auto operand : op->getOperands()) {
+    node.operands.push_back(slots[operand]);
+    node.isNarrow &= node.operands.back().width <= 64;
+  }
+  program.nodes.push_back(std::move(node));
+  nodeOps.push_back(op);
+  return success();
+}
+
+LogicalResult ProgramBuilder::checkClocks() {
+  if (clocks.empty())
+    return success();
+
+  auto isInput = [&](Slot slot) {
+    return llvm::any_of(program.inputs, [&](Slot input) {
+      return input.offset == slot.offset;
+    });
+  };
+  for (size_t i = 0, e = clocks.size(); i != e; ++i) {
+    if (!isInput(clocks[i]))
+      return registerOps[i]->emitError(
+          "register clock must be an input of the top-level module");
+    if (clocks[i].offset != clocks[0].offset)
+      return registerOps[i]->emitError(
+          "registers with different clocks are not supported");
+  }
+  return success();
+}
+
+LogicalResult ProgramBuilder::checkBitParallel() {
+  for (size_t i = 0, e = program.nodes.size(); i != e; ++i) {
+    switch (program.nodes[i].opcode) {
+    case Opcode::Mul:
+    case Opcode::DivU:
+    case Opcode::DivS:
+    case Opcode::ModU:
+    case Opcode::ModS:
+      return nodeOps[i]->emitError(
+          "operation is not supported by the bit-parallel simulator");
+    default:
+      break;
+    }
+  }
+  return success();
+}
+
+LogicalResult ProgramBuilder::levelize() {
+  auto &nodes = program.nodes;
+
+  // Find the node computing each value.  Values which are not computed by a
+  // node are inputs, constants or registers, and are available up front.
+  DenseMap<unsigned, unsigned> producers;
+  for (unsigned i = 0, e = nodes.size(); i != e; ++i)
+    producers[nodes[i].result.offset] = i;
+
+  SmallVector<unsigned, 0> numPending(nodes.size());
+  std::vector<SmallVector<unsigned, 2>> users(nodes.size());
+  for (unsigned i = 0, e = nodes.size(); i != e; ++i) {
+    for (auto operand : nodes[i].operands) {
+      auto it = producers.find(operand.offset);
+      if (it == producers.end())
+        continue;
+      users[it->second].push_back(i);
+      ++numPending[i];
+    }
+  }
+
+  // Schedule the nodes whose operands are all available, in their original
+  // order.
+  SmallVector<unsigned, 0> order;
+  order.reserve(nodes.size());
+  for (unsigned i = 0, e = nodes.size(); i != e; ++i)
+    if (numPending[i] == 0)
+      order.push_back(i);
+  for (size_t next = 0; next != order.size(); ++next)
+    for (auto user : users[order[next]])
+      if (--numPending[user] == 0)
+        order.push_back(user);
+
+  if (order.size() != nodes.size()) {
+    for (unsigned i = 0, e = nodes.size(); i != e; ++i)
+      if (numPending[i] != 0)
+        return nodeOps[i]->emitError(
+            "cannot simulate combinational cycle through this operation");
+  }
+
+  std::vector<Node> sorted;
+  sorted.reserve(nodes.size());
+  for (auto index : order)
+    sorted.push_back(std::move(nodes[index]));
+  nodes = std::move(sorted);
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// SimulatorBase
+//===----------------------------------------------------------------------===//
+
+SimulatorBase::SimulatorBase() : program(std::make_unique<Program>()) {}
+
+SimulatorBase::~SimulatorBase() = default;
+
+LogicalResult SimulatorBase::build(ModuleOp module, StringRef top,
+                                   unsigned laneWords) {
+  auto topModule = SymbolTable::lookupSymbolIn(module, top);
+  if (!isa_and_nonnull<rtl::RTLModuleOp>(topModule))
+    return module.emitError("cannot find top-level module '") << top << "'";
+
+  program->laneWords = laneWords;
+  ProgramBuilder builder(*program, module);
+
+  for (auto &port : rtl::getModulePortInfo(topModule)) {
+    if (port.isOutput())
+      continue;
+    auto slot = builder.allocate(port.type, topModule->getLoc());
+    if (!slot)
+      return failure();
+    program->inputs.push_back(*slot);
+    inputs.push_back({port.name, slot->width});
+  }
+
+  SmallVector<Slot, 4> outputSlots;
+  if (failed(builder.flatten(cast<rtl::RTLModuleOp>(topModule),
+                             program->inputs, outputSlots)) ||
+      failed(builder.checkClocks()) ||
+      (laneWords && failed(builder.checkBitParallel())) ||
+      failed(builder.levelize()))
+    return failure();
+
+  for (auto &port : rtl::getModulePortInfo(topModule)) {
+    if (!port.isOutput())
+      continue;
+    auto slot = outputSlots[port.argNum];
+    program->outputs.push_back(slot);
+    outputs.push_back({port.name, slot.width});
+  }
+  return success();
+}
+
+Optional<unsigned> SimulatorBase::lookupInput(StringRef name) const {
+  for (unsigned i = 0, e = inputs.size(); i != e; ++i)
+    if (inputs[i].name.getValue() == name)
+      return i;
+  return None;
+}
+
+Optional<unsigned> SimulatorBase::lookupOutput(StringRef name) const {
+  for (unsigned i = 0, e = outputs.size(); i != e; ++i)
+    if (outputs[i].name.getValue() == name)
+      return i;
+  return None;
+}
+
+void SimulatorBase::evaluate() {
+  program->evaluate();
+  needsEvaluation = false;
+}
+
+void SimulatorBase::step(uint64_t numCycles) {
+  for (uint64_t i = 0; i != numCycles; ++i) {
+    if (needsEvaluation)
+      evaluate();
+    program->latchRegisters();
+    ++cycle;
+    needsEvaluation = true;
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// CycleSimulator
+//===----------------------------------------------------------------------===//
+
+std::unique_ptr<CycleSimulator> CycleSimulator::create(ModuleOp module,
+                                                       StringRef top) {
+  std::unique_ptr<CycleSimulator> simulator(new CycleSimulator());
+  if (failed(simulator->build(module, top, /*laneWords=*/0)))
+    return {};
+  return simulator;
+}
+
+void CycleSimulator::setInput(unsigned index, const APInt &value) {
+  auto slot = program->inputs[index];
+  if (slot.width == 0)
+    return;
+  program->write(slot, value.zextOrTrunc(slot.width));
+  needsEvaluation = true;
+}
+
+APInt CycleSimulator::getOutput(unsigned index) {
+  if (needsEvaluation)
+    evaluate();
+  return program->read(program->outputs[index]);
+}
+
+//===----------------------------------------------------------------------===//
+// BitParallelSimulator
+//===----------------------------------------------------------------------===//
+
+std::unique_ptr<BitParallelSimulator>
+BitParallelSimulator::create(ModuleOp module, StringRef top,
+                             unsigned numLanes) {
+  if (numLanes == 0 || numLanes % 64 != 0) {
+    module.emitError("the number of lanes must be a multiple of 64");
+    return {};
+  }
+
+  std::unique_ptr<BitParallelSimulator> simulator(new BitParallelSimulator());
+  simulator->numLanes = numLanes;
+  if (failed(simulator->build(module, top, numLanes / 64)))
+    return {};
+  return simulator;
+}
+
+void BitParallelSimulator::setInput(unsigned index, unsigned lane,
+                                    const APInt &value) {
+  auto slot = program->inputs[index];
+  uint64_t mask = uint64_t(1) << (lane % 64);
+  for (unsigned bit = 0; bit != slot.width; ++bit) {
+    auto &word = program->getBit(slot, bit)[lane / 64];
+    if (bit < value.getBitWidth() && value[bit])
+      word |= mask;
+    else
+      word &= ~mask;
+  }
+  needsEvaluation = true;
+}
+
+APInt BitParallelSimulator::getOutput(unsigned index, unsigned lane) {
+  if (needsEvaluation)
+    evaluate();
+  auto slot = program->outputs[index];
+  APInt value(std::max(slot.width, 1U), 0);
+  for (unsigned bit = 0; bit != slot.width; ++bit)
+    if ((program->getBit(slot, bit)[lane / 64] >> (lane % 64)) & 1)
+      value.setBit(bit);
+  return value;
+}
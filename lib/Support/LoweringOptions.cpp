@@ -41,6 +41,8 @@ void LoweringOptions::parse(StringRef text, ErrorHandlerT errorHandler) {
       // Empty options are fine.
     } else if (option == "noAlwaysFF") {
       useAlwaysFF = false;
+    } else if (option == "sourceMapIDs") {
+      emitSourceMapIDs = true;
     } else if (option.startswith("emittedLineLength=")) {
       option = option.drop_front(strlen("emittedLineLength="));
       if (option.getAsInteger(10, emittedLineLength)) {
@@ -61,6 +63,8 @@ std::string LoweringOptions::toString() const {
     options += "noAlwaysFF,";
   if (emittedLineLength != 90)
     options += "emittedLineLength=" + std::to_string(emittedLineLength) + ',';
+  if (emitSourceMapIDs)
+    options += "sourceMapIDs,";
 
   // Remove a trailing comma if present.
   if (!options.empty()) {
@@ -0,0 +1,146 @@
+//===- ParallelScheduling.cpp - Size-aware parallel loops -----------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements size-aware scheduling of operations on the thread pool.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Support/ParallelScheduling.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/SymbolTable.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Parallel.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#define DEBUG_TYPE "parallel-schedule"
+
+using namespace circt;
+
+namespace {
+/// Command line options for reporting parallel schedules.  Used to dynamically
+/// register the options in the tools which want them.
+struct ParallelSchedulingCLOptions {
+  llvm::cl::opt<bool> printSchedule{
+      "print-parallel-schedule",
+      llvm::cl::desc("Print the time taken by each operation processed by a "
+                     "parallel loop, to help find load imbalances"),
+      llvm::cl::init(false)};
+};
+} // namespace
+
+/// The staticly initialized command line options.
+static llvm::ManagedStatic<ParallelSchedulingCLOptions> clOptions;
+
+void circt::registerParallelSchedulingCLOptions() { *clOptions; }
+
+size_t circt::estimateOperationCost(Operation *op) {
+  size_t cost = 0;
+  op->walk([&](Operation *) { ++cost; });
+  return cost;
+}
+
+std::vector<size_t> circt::estimateOperationCosts(MLIRContext *context,
+                                                  ArrayRef<Operation *> ops) {
+  std::vector<size_t> costs(ops.size());
+  if (!context->isMultithreadingEnabled() || ops.size() <= 1)
+    return costs;
+
+  // Estimating the costs requires walking all of the operations, so do this in
+  // parallel as well.
+  llvm::parallelForEachN(0, ops.size(), [&](size_t index) {
+    costs[index] = estimateOperationCost(ops[index]);
+  });
+  return costs;
+}
+
+/// Print the time taken by each operation, slowest first.
+static void printSchedule(raw_ostream &os, ArrayRef<Operation *> ops,
+                          ArrayRef<size_t> costs, ArrayRef<double> times) {
+  std::vector<size_t> order(ops.size());
+  for (size_t index = 0, e = ops.size(); index != e; ++index)
+    order[index] = index;
+  std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+    return times[lhs] > times[rhs];
+  });
+
+  os << "===- Parallel schedule: " << ops.size() << " operations -===\n";
+  for (auto index : order) {
+    auto *op = ops[index];
+    os << llvm::format("%10.4f s  ", times[index]) << op->getName();
+    if (auto name =
+            op->getAttrOfType<StringAttr>(SymbolTable::getSymbolAttrName()))
+      os << " @" << name.getValue();
+    if (costs[index])
+      os << " (" << costs[index] << " ops)";
+    os << "\n";
+  }
+}
+
+void circt::parallelForEachLargestFirst(MLIRContext *context,
+                                        ArrayRef<Operation *> ops,
+                                        function_ref<void(size_t index)> fn) {
+  parallelForEachLargestFirst(context, ops,
+                              estimateOperationCosts(context, ops), fn);
+}
+
+void circt::parallelForEachLargestFirst(MLIRContext *context,
+                                        ArrayRef<Operation *> ops,
+                                        ArrayRef<size_t> costs,
+                                        function_ref<void(size_t index)> fn) {
+  assert(costs.size() == ops.size() && "expected one cost per operation");
+  using Clock = std::chrono::steady_clock;
+  std::vector<double> times(ops.size());
+  auto run = [&](size_t index) {
+    auto startTime = Clock::now();
+    fn(index);
+    times[index] =
+        std::chrono::duration<double>(Clock::now() - startTime).count();
+  };
+
+  if (!context->isMultithreadingEnabled() || ops.size() <= 1) {
+    for (size_t index = 0, e = ops.size(); index != e; ++index)
+      run(index);
+  } else {
+    // Order the operations by decreasing cost.  Ties keep their original order
+    // to make the schedule deterministic.
+    std::vector<size_t> order(ops.size());
+    for (size_t index = 0, e = ops.size(); index != e; ++index)
+      order[index] = index;
+    std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+      return costs[lhs] > costs[rhs];
+    });
+
+    // The thread pool does not guarantee the order in which spawned tasks are
+    // started, so start one worker per thread instead and have the workers
+    // pull the operations off the sorted list.
+    mlir::ParallelDiagnosticHandler diagHandler(context);
+    std::atomic<size_t> nextIndex(0);
+    size_t numWorkers = std::min<size_t>(
+        llvm::parallel::strategy.compute_thread_count(), ops.size());
+    llvm::parallelForEachN(0, numWorkers, [&](size_t) {
+      for (size_t i = nextIndex++; i < order.size(); i = nextIndex++) {
+        diagHandler.setOrderIDForThread(order[i]);
+        run(order[i]);
+        diagHandler.eraseOrderIDForThread();
+      }
+    });
+  }
+
+  if (clOptions.isConstructed() && clOptions->printSchedule)
+    printSchedule(llvm::errs(), ops, costs, times);
+  else
+    LLVM_DEBUG(printSchedule(llvm::dbgs(), ops, costs, times));
+}
@@ -8,16 +8,29 @@
 //
 // This file implements a simplified canonicalizer pass that doesn't do CFG
 // optimizations and other things that aren't helpful for many hardware IRs.
+// It also implements an incremental simplifier built on the same driver.
 //
 //===----------------------------------------------------------------------===//
 
+#include "circt/Transforms/IncrementalSimplifier.h"
 #include "circt/Transforms/Passes.h"
 
 #include "circt/Support/LLVM.h"
+#include "mlir/IR/RegionKindInterface.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Rewrite/PatternApplicator.h"
 #include "mlir/Transforms/FoldUtils.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/Parallel.h"
+#include "llvm/Support/Threading.h"
+#include <limits>
+#include <numeric>
+#include <queue>
+
+#define DEBUG_TYPE "simple-canonicalizer"
+
 using namespace circt;
 
 #define GEN_PASS_CLASSES
@@ -32,52 +45,100 @@ namespace {
 /// applies the locally optimal patterns in a roughly "bottom up" way.
 class GreedyPatternRewriteDriver : public PatternRewriter {
 public:
+  /// If a scope is specified, only operations nested within it are visited.
   explicit GreedyPatternRewriteDriver(
-      MLIRContext *ctx, const mlir::FrozenRewritePatternSet &patterns)
-      : PatternRewriter(ctx), matcher(patterns), folder(ctx) {
-    worklist.reserve(64);
-
+      MLIRContext *ctx, const mlir::FrozenRewritePatternSet &patterns,
+      Region *scope = nullptr)
+      : PatternRewriter(ctx), matcher(patterns), folder(ctx), scope(scope) {
     // Apply a simple cost model based solely on pattern benefit.
     matcher.applyDefaultCostModel();
   }
 
+  /// Simplify all of the operations nested in the regions.
   void simplify(MutableArrayRef<Region> regions, int maxIterations);
 
-  void addToWorklist(Operation *op) {
-    // Check to see if the worklist already contains this op.
-    if (worklistMap.count(op))
-      return;
+  /// Simplify the specified operations and their transitive users.
+  void simplifyFanOut(ArrayRef<Operation *> roots, int maxIterations);
+
+  /// Return the number of the operation, numbering it if it hasn't been seen
+  /// before.  Numbers are never reused during a run of the driver, so unlike
+  /// the address of an operation, a number never refers to an operation which
+  /// was created after another one was erased.
+  unsigned getOpNumber(Operation *op) {
+    auto it = opNumbers.try_emplace(op, opsByNumber.size());
+    if (it.second) {
+      opsByNumber.push_back(op);
+      inWorklist.push_back(false);
+      touched.push_back(false);
+      changed.push_back(false);
+    }
+    return it.first->second;
+  }
 
-    worklistMap[op] = worklist.size();
-    worklist.push_back(op);
+  /// Return the operations created or modified by the driver which still
+  /// exist, in the order they were first changed.
+  void getChangedOps(SmallVectorImpl<Operation *> &ops) const {
+    for (auto number : changedOps)
+      if (auto *op = opsByNumber[number])
+        ops.push_back(op);
   }
 
-  Operation *popFromWorklist() {
-    auto *op = worklist.back();
-    worklist.pop_back();
+  /// Add the operation to the worklist, and record that it was touched by a
+  /// change so that it is revisited by the next iteration.  Return the number
+  /// of the operation, or None if it is outside of the scope of the driver.
+  Optional<unsigned> addToWorklist(Operation *op) {
+    // Operations outside of the scope are being simplified by another driver.
+    if (scope && !scope->isAncestor(op->getParentRegion()))
+      return None;
+
+    auto number = getOpNumber(op);
+    markTouched(number);
+    addNumberToWorklist(number);
+    return number;
+  }
 
-    // This operation is no longer in the worklist, keep worklistMap up to date.
-    if (op)
-      worklistMap.erase(op);
-    return op;
+  /// Pop the next operation off of the worklist, or return null if it is
+  /// empty.  Erasing an operation only clears its bit, so the numbers of the
+  /// operations erased while in the worklist are skipped here.
+  Operation *popFromWorklist(unsigned &number) {
+    while (!worklist.empty()) {
+      number = worklist.pop_back_val();
+      if (inWorklist.test(number)) {
+        inWorklist.reset(number);
+        return opsByNumber[number];
+      }
+    }
+    return nullptr;
   }
 
-  /// If the specified operation is in the worklist, remove it.  If not, this is
-  /// a no-op.
+  /// Forget the specified operation, which is about to be erased.  If it is in
+  /// the worklist, it is removed.
   void removeFromWorklist(Operation *op) {
-    auto it = worklistMap.find(op);
-    if (it != worklistMap.end()) {
-      assert(worklist[it->second] == op && "malformed worklist data structure");
-      worklist[it->second] = nullptr;
-      worklistMap.erase(it);
+    auto it = opNumbers.find(op);
+    if (it != opNumbers.end()) {
+      inWorklist.reset(it->second);
+      opsByNumber[it->second] = nullptr;
+      opNumbers.erase(it);
     }
   }
 
+  /// The number of iterations run, the number of operations which were
+  /// changed, and the largest size of the initial worklist of an iteration.
+  size_t numIterations = 0;
+  size_t numChanges = 0;
+  size_t maxWorklistSize = 0;
+
+  /// The number of operations erased, including nested operations.
+  size_t numErased = 0;
+
   // These are hooks implemented for PatternRewriter.
 protected:
   // Implement the hook for inserting operations, and make sure that newly
   // inserted ops are added to the worklist for processing.
-  void notifyOperationInserted(Operation *op) override { addToWorklist(op); }
+  void notifyOperationInserted(Operation *op) override {
+    if (auto number = addToWorklist(op))
+      markChanged(*number);
+  }
 
   // If an operation is about to be removed, make sure it is not in our
   // worklist anymore because we'd get dangling references to it.
@@ -86,19 +147,48 @@ protected:
     op->walk([this](Operation *operation) {
       removeFromWorklist(operation);
       folder.notifyRemoval(operation);
+      ++numErased;
     });
   }
 
   // When the root of a pattern is about to be replaced, it can trigger
   // simplifications to its users - make sure to add them to the worklist
   // before the root is changed.
-  void notifyRootReplaced(Operation *op) override {
-    for (auto result : op->getResults())
-      for (auto *user : result.getUsers())
-        addToWorklist(user);
-  }
+  void notifyRootReplaced(Operation *op) override { addUsersToWorklist(op); }
 
 private:
+  /// Add the users of the operation, whose operands are about to be replaced,
+  /// to the worklist.
+  void addUsersToWorklist(Operation *op) {
+    for (auto *user : op->getUsers())
+      if (auto number = addToWorklist(user))
+        markChanged(*number);
+  }
+
+  /// Run the driver on the operations in the worklist.
+  void run(int maxIterations);
+
+  void addNumberToWorklist(unsigned number) {
+    if (inWorklist.test(number))
+      return;
+    inWorklist.set(number);
+    worklist.push_back(number);
+  }
+
+  void markTouched(unsigned number) {
+    if (touched.test(number))
+      return;
+    touched.set(number);
+    touchedOps.push_back(number);
+  }
+
+  void markChanged(unsigned number) {
+    if (changed.test(number))
+      return;
+    changed.set(number);
+    changedOps.push_back(number);
+  }
+
   // Look over the provided operands for any defining operations that should
   // be re-added to the worklist. This function should be called when an
   // operation is modified or removed, as it may trigger further
@@ -121,49 +211,106 @@ private:
   /// The low-level pattern applicator.
   mlir::PatternApplicator matcher;
 
-  /// The worklist for this transformation keeps track of the operations that
-  /// need to be revisited, plus their index in the worklist.  This allows us to
-  /// efficiently remove operations from the worklist when they are erased, even
-  /// if they aren't the root of a pattern.
-  std::vector<Operation *> worklist;
-  DenseMap<Operation *, unsigned> worklistMap;
+  /// Each operation seen by the driver is numbered once, and the worklist
+  /// holds the numbers of the operations that need to be revisited.
+  /// Membership is tracked in a bit vector, so erasing an operation only has
+  /// to clear its bit, and erased operations are skipped when popped.  MLIR
+  /// operations have no scratch slot to hold the number, so looking up the
+  /// number of an operation takes one hash lookup.
+  DenseMap<Operation *, unsigned> opNumbers;
+  std::vector<Operation *> opsByNumber;
+  SmallVector<unsigned, 64> worklist;
+  llvm::BitVector inWorklist;
+
+  /// The operations touched by changes during the current iteration.  Only
+  /// these are revisited by the next iteration.
+  SmallVector<unsigned, 64> touchedOps;
+  llvm::BitVector touched;
+
+  /// The operations created or modified during the whole run.
+  SmallVector<unsigned, 16> changedOps;
+  llvm::BitVector changed;
 
   /// Non-pattern based folder for operations.
   mlir::OperationFolder folder;
+
+  /// The region the driver is restricted to, if any.
+  Region *scope;
 };
 } // end anonymous namespace
 
-/// Performs the rewrites while folding and erasing any dead ops. Returns true
-/// if the rewrite converges in `maxIterations`.
 void GreedyPatternRewriteDriver::simplify(MutableArrayRef<Region> regions,
                                           int maxIterations) {
+  for (auto &region : regions)
+    region.walk([&](Operation *op) { addNumberToWorklist(getOpNumber(op)); });
+  run(maxIterations);
+}
+
+/// The operations are added to the worklist in post order of their users, so
+/// that they are popped with their operands before their users wherever the
+/// cone is acyclic.
+void GreedyPatternRewriteDriver::simplifyFanOut(ArrayRef<Operation *> roots,
+                                                int maxIterations) {
+  DenseSet<Operation *> visited;
+  SmallVector<std::pair<Operation *, Operation::user_iterator>, 16> stack;
+  for (auto *root : roots) {
+    if (!visited.insert(root).second)
+      continue;
+    stack.push_back({root, root->user_begin()});
+    while (!stack.empty()) {
+      auto &entry = stack.back();
+      auto *op = entry.first;
+      if (entry.second != op->user_end()) {
+        auto *user = *entry.second++;
+        if (visited.insert(user).second)
+          stack.push_back({user, user->user_begin()});
+        continue;
+      }
+      stack.pop_back();
+      addNumberToWorklist(getOpNumber(op));
+    }
+  }
+  run(maxIterations);
+}
+
+/// Performs the rewrites while folding and erasing any dead ops, until the
+/// rewrite converges or `maxIterations` is reached.
+void GreedyPatternRewriteDriver::run(int maxIterations) {
   // Add the given operation to the worklist.
-  auto collectOps = [this](Operation *op) { addToWorklist(op); };
+  auto collectOps = [this](Operation *op) {
+    if (auto number = addToWorklist(op))
+      markChanged(*number);
+  };
 
-  bool changed = false;
+  size_t changes = 0;
   int i = 0;
   do {
-    // Add all nested operations to the worklist.
-    for (auto &region : regions)
-      region.walk(collectOps);
+    // The first iteration visits the operations added by the caller.  Later
+    // iterations only revisit the operations touched by the changes of the
+    // previous iteration, as nothing else can have new simplification
+    // opportunities.
+    if (i != 0) {
+      for (auto number : touchedOps) {
+        touched.reset(number);
+        if (opsByNumber[number])
+          addNumberToWorklist(number);
+      }
+    }
+    touchedOps.clear();
+    size_t worklistSize = worklist.size();
+    maxWorklistSize = std::max(maxWorklistSize, worklistSize);
 
     // These are scratch vectors used in the folding loop below.
     SmallVector<Value, 8> originalOperands, resultValues;
 
-    changed = false;
-    while (!worklist.empty()) {
-      auto *op = popFromWorklist();
-
-      // Nulls get added to the worklist when operations are removed, ignore
-      // them.
-      if (op == nullptr)
-        continue;
-
+    changes = 0;
+    unsigned number;
+    while (auto *op = popFromWorklist(number)) {
       // If the operation is trivially dead - remove it.
       if (isOpTriviallyDead(op)) {
         notifyOperationRemoved(op);
         op->erase();
-        changed = true;
+        ++changes;
         continue;
       }
 
@@ -176,9 +323,7 @@ void GreedyPatternRewriteDriver::simplify(MutableArrayRef<Region> regions,
 
         // Add all the users of the result to the worklist so we make sure
         // to revisit them.
-        for (auto result : op->getResults())
-          for (auto *userOp : result.getUsers())
-            addToWorklist(userOp);
+        addUsersToWorklist(op);
 
         notifyOperationRemoved(op);
       };
@@ -187,20 +332,165 @@ void GreedyPatternRewriteDriver::simplify(MutableArrayRef<Region> regions,
       bool inPlaceUpdate;
       if ((succeeded(folder.tryToFold(op, collectOps, preReplaceAction,
                                       &inPlaceUpdate)))) {
-        changed = true;
+        ++changes;
         if (!inPlaceUpdate)
           continue;
+        markTouched(number);
+        markChanged(number);
       }
 
       // Try to match one of the patterns. The rewriter is automatically
       // notified of any necessary changes, so there is nothing else to do here.
-      changed |= succeeded(matcher.matchAndRewrite(op, *this));
+      if (succeeded(matcher.matchAndRewrite(op, *this))) {
+        ++changes;
+        markTouched(number);
+        markChanged(number);
+      }
+    }
+
+    LLVM_DEBUG(llvm::dbgs() << "iteration " << i << ": worklist size "
+                            << worklistSize << ", " << changes
+                            << " changes\n");
+    ++numIterations;
+    numChanges += changes;
+  } while (changes && ++i < maxIterations);
+}
+
+/// Collect the canonicalization patterns of all operations registered in the
+/// context.
+static mlir::FrozenRewritePatternSet
+getCanonicalizationPatterns(MLIRContext *context) {
+  RewritePatternSet patterns(context);
+  for (auto *op : context->getRegisteredOperations())
+    op->getCanonicalizationPatterns(patterns, context);
+  return mlir::FrozenRewritePatternSet(std::move(patterns));
+}
+
+//===----------------------------------------------------------------------===//
+// Block Partitioning
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// A set of operations from a block which don't share any values with the
+/// rest of the block, other than the block arguments and constants.  While
+/// the partition is simplified, its operations are moved in to a "shadow"
+/// operation which has the same name and attributes as the parent of the
+/// block.  The shadow operation is nested in the block, so that the partition
+/// still sees the enclosing operations, such as the parent module and its
+/// symbol table.  The shadow block has its own copies of the block arguments
+/// and of any constants used by the partition, so that the use lists of values
+/// shared with other partitions are never modified concurrently.
+struct BlockPartition {
+  BlockPartition(Operation *parentOp, Block &block);
+
+  /// Move the specified operation from the original block to the end of the
+  /// partition.  \p order is the position of the operation in the block.
+  void addOperation(Operation *op, unsigned order, Block &block);
+
+  /// Simplify the partition, and compute the order in which its operations
+  /// are moved back in to the original block.  \p addStatistics is called with
+  /// the driver once it is done.
+  void simplify(
+      MLIRContext *context, const mlir::FrozenRewritePatternSet &patterns,
+      function_ref<void(const GreedyPatternRewriteDriver &)> addStatistics);
+
+  Region &getRegion() { return shadowOp->getRegion(0); }
+  Block &getBlock() { return getRegion().front(); }
+
+  /// The operation holding the partition.
+  Operation *shadowOp;
+
+  /// The copies of the original constants used by the partition.
+  DenseMap<Operation *, Operation *> constants;
+
+  /// The original operations of the partition with their positions in the
+  /// block, and once simplified, all of the operations of the partition with
+  /// the positions they are moved back to.
+  SmallVector<std::pair<unsigned, Operation *>, 0> orderedOps;
+};
+} // end anonymous namespace
+
+BlockPartition::BlockPartition(Operation *parentOp, Block &block) {
+  shadowOp = Operation::create(parentOp->getLoc(), parentOp->getName(), {}, {},
+                               parentOp->getAttrDictionary(), {},
+                               /*numRegions=*/1);
+  auto *shadowBlock = new Block();
+  getRegion().push_back(shadowBlock);
+  for (auto arg : block.getArguments())
+    shadowBlock->addArgument(arg.getType());
+
+  // Keep the terminator of the block, if any, at the end.
+  auto insertPt = block.end();
+  if (!block.empty() && block.back().hasTrait<OpTrait::IsTerminator>())
+    insertPt = Block::iterator(&block.back());
+  block.getOperations().insert(insertPt, shadowOp);
+}
+
+void BlockPartition::addOperation(Operation *op, unsigned order,
+                                  Block &block) {
+  auto &shadowBlock = getBlock();
+  op->moveBefore(&shadowBlock, shadowBlock.end());
+  orderedOps.push_back({order, op});
+
+  // Redirect the uses of block arguments and constants from the original
+  // block to the copies owned by this partition.
+  op->walk([&](Operation *nested) {
+    for (auto &operand : nested->getOpOperands()) {
+      auto value = operand.get();
+      if (auto arg = value.dyn_cast<BlockArgument>()) {
+        if (arg.getOwner() == &block)
+          operand.set(shadowBlock.getArgument(arg.getArgNumber()));
+        continue;
+      }
+
+      // Other values from the original block are defined by operations which
+      // will be moved in to this partition.
+      auto *def = value.getDefiningOp();
+      if (def->getBlock() != &block || !def->hasTrait<OpTrait::ConstantLike>())
+        continue;
+      auto &constant = constants[def];
+      if (!constant) {
+        constant = def->clone();
+        shadowBlock.push_front(constant);
+      }
+      auto resultNumber = value.cast<OpResult>().getResultNumber();
+      operand.set(constant->getResult(resultNumber));
     }
-  } while (changed && ++i < maxIterations);
+  });
+}
+
+void BlockPartition::simplify(
+    MLIRContext *context, const mlir::FrozenRewritePatternSet &patterns,
+    function_ref<void(const GreedyPatternRewriteDriver &)> addStatistics) {
+  // Record the position of the original operations by their number in the
+  // driver.  Operations may be erased and new ones allocated at the same
+  // address while the partition is simplified, but numbers are never reused.
+  GreedyPatternRewriteDriver driver(context, patterns, &getRegion());
+  DenseMap<unsigned, unsigned> orderOfNumber;
+  for (auto &entry : orderedOps)
+    orderOfNumber.insert({driver.getOpNumber(entry.second), entry.first});
+
+  driver.simplify(shadowOp->getRegions(), /*maxIterations=*/10);
+  addStatistics(driver);
+
+  // Order the operations which survived with their original position, and the
+  // new operations with the original operation which follows them, or after
+  // all of the original operations.
+  orderedOps.clear();
+  for (auto &op : getBlock())
+    orderedOps.push_back({0, &op});
+  unsigned order = std::numeric_limits<unsigned>::max();
+  for (auto &entry : llvm::reverse(orderedOps)) {
+    auto it = orderOfNumber.find(driver.getOpNumber(entry.second));
+    if (it != orderOfNumber.end())
+      order = std::min(order, it->second);
+    entry.first = order;
+  }
 }
 
 //===----------------------------------------------------------------------===//
 // SimpleCanonicalizer
+
 //===----------------------------------------------------------------------===//
 
 namespace {
@@ -210,18 +500,172 @@ struct SimpleCanonicalizer
   /// Initialize the canonicalizer by building the set of patterns used during
   /// execution.
   LogicalResult initialize(MLIRContext *context) override {
-    RewritePatternSet owningPatterns(context);
-    for (auto *op : context->getRegisteredOperations())
-      op->getCanonicalizationPatterns(owningPatterns, context);
-    patterns = std::move(owningPatterns);
+    patterns = getCanonicalizationPatterns(context);
     return success();
   }
   void runOnOperation() override;
 
+  /// Split the block in to partitions and simplify them concurrently.  Return
+  /// false if the block is too small or can't be split.
+  bool simplifyInParallel(Block &block);
+
+  /// Record the work done by a driver in the pass statistics.  This is safe to
+  /// call concurrently, as statistics are updated atomically.
+  void addStatistics(const GreedyPatternRewriteDriver &driver) {
+    numIterations += driver.numIterations;
+    numChanges += driver.numChanges;
+    maxWorklistSize.updateMax(driver.maxWorklistSize);
+  }
+
   mlir::FrozenRewritePatternSet patterns;
 };
 } // end anonymous namespace
 
+bool SimpleCanonicalizer::simplifyInParallel(Block &block) {
+  // Number the top level operations which can be moved in to a partition.
+  // Terminators stay in the block, and constants are copied in to each
+  // partition which uses them.
+  SmallVector<Operation *, 0> ops;
+  DenseMap<Operation *, unsigned> opNumbers;
+  for (auto &op : block) {
+    if (op.hasTrait<OpTrait::IsTerminator>() ||
+        op.hasTrait<OpTrait::ConstantLike>())
+      continue;
+    opNumbers.insert({&op, ops.size()});
+    ops.push_back(&op);
+  }
+  if (ops.size() < partitionThreshold)
+    return false;
+
+  // Find the connected components of the operations, ignoring the values
+  // which the partitions get their own copies of.
+  std::vector<unsigned> leaders(ops.size());
+  std::iota(leaders.begin(), leaders.end(), 0);
+  auto findLeader = [&](unsigned index) {
+    while (leaders[index] != index)
+      index = leaders[index] = leaders[leaders[index]];
+    return index;
+  };
+  for (unsigned index = 0, e = ops.size(); index != e; ++index) {
+    ops[index]->walk([&](Operation *nested) {
+      for (auto operand : nested->getOperands()) {
+        auto *def = operand.getDefiningOp();
+        if (!def || !(def = block.findAncestorOpInBlock(*def)))
+          continue;
+        auto it = opNumbers.find(def);
+        if (it != opNumbers.end())
+          leaders[findLeader(index)] = findLeader(it->second);
+      }
+    });
+  }
+
+  DenseMap<unsigned, size_t> componentSizes;
+  for (unsigned index = 0, e = ops.size(); index != e; ++index)
+    ++componentSizes[findLeader(index)];
+  if (componentSizes.size() < 2)
+    return false;
+
+  // Assign the components to partitions, largest first, always picking the
+  // partition with the fewest operations so far.
+  SmallVector<std::pair<size_t, unsigned>, 0> components;
+  for (auto &component : componentSizes)
+    components.push_back({component.second, component.first});
+  llvm::sort(components,
+             [](const auto &lhs, const auto &rhs) { return lhs > rhs; });
+
+  size_t partitionCount = std::min<size_t>(
+      components.size(), llvm::hardware_concurrency().compute_thread_count());
+  std::vector<BlockPartition> partitions;
+  using Load = std::pair<size_t, unsigned>;
+  std::priority_queue<Load, std::vector<Load>, std::greater<Load>> loads;
+  for (unsigned index = 0; index != partitionCount; ++index) {
+    partitions.emplace_back(getOperation(), block);
+    loads.push({0, index});
+  }
+
+  DenseMap<unsigned, unsigned> partitionOfComponent;
+  for (auto &component : components) {
+    auto load = loads.top();
+    loads.pop();
+    partitionOfComponent[component.second] = load.second;
+    loads.push({load.first + component.first, load.second});
+  }
+  for (unsigned index = 0, e = ops.size(); index != e; ++index)
+    partitions[partitionOfComponent[findLeader(index)]].addOperation(
+        ops[index], index, block);
+  numPartitions += partitions.size();
+
+  // Simplify the partitions concurrently, each with its own constant pool.
+  llvm::parallelForEachN(0, partitions.size(), [&](size_t index) {
+    partitions[index].simplify(
+        &getContext(), patterns,
+        [&](const GreedyPatternRewriteDriver &driver) {
+          addStatistics(driver);
+        });
+  });
+
+  // Move the operations back in to the block, interleaving the partitions in
+  // their original order.
+  SmallVector<std::pair<unsigned, Operation *>, 0> orderedOps;
+  for (auto &partition : partitions)
+    orderedOps.append(partition.orderedOps.begin(),
+                      partition.orderedOps.end());
+  std::stable_sort(
+      orderedOps.begin(), orderedOps.end(),
+      [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
+
+  auto insertPt = block.end();
+  if (!block.empty() && block.back().hasTrait<OpTrait::IsTerminator>())
+    insertPt = Block::iterator(&block.back());
+  for (auto &op : orderedOps)
+    op.second->moveBefore(&block, insertPt);
+
+  for (auto &partition : partitions) {
+    for (auto args : llvm::zip(partition.getBlock().getArguments(),
+                               block.getArguments()))
+      std::get<0>(args).replaceAllUsesWith(std::get<1>(args));
+    partition.shadowOp->erase();
+  }
+
+  // Merge the constant pools of the partitions, moving the surviving
+  // constants to the start of the block so that they dominate their users.
+  using ConstantKey = std::tuple<const void *, Attribute, Type>;
+  DenseMap<ConstantKey, Operation *> uniquedConstants;
+  SmallVector<Operation *, 0> constants;
+  for (auto &op : block)
+    if (op.hasTrait<OpTrait::ConstantLike>())
+      constants.push_back(&op);
+
+  auto constantInsertPt = block.begin();
+  for (auto *constant : constants) {
+    if (constant->use_empty()) {
+      constant->erase();
+      continue;
+    }
+    ConstantKey key(constant->getName().getAsOpaquePointer(),
+                    constant->getAttrDictionary(),
+                    constant->getResult(0).getType());
+    auto &uniqued = uniquedConstants[key];
+    if (uniqued) {
+      constant->replaceAllUsesWith(uniqued);
+      constant->erase();
+      continue;
+    }
+    uniqued = constant;
+    if (Block::iterator(constant) == constantInsertPt)
+      ++constantInsertPt;
+    else
+      constant->moveBefore(&block, constantInsertPt);
+  }
+  return true;
+}
+
+/// Return true if the single region of the operation is a graph region.
+static bool isGraphRegion(Operation *op) {
+  auto regionKind = dyn_cast<mlir::RegionKindInterface>(op);
+  return regionKind && regionKind.getRegionKind(0) == mlir::RegionKind::Graph;
+}
+
 void SimpleCanonicalizer::runOnOperation() {
   auto regions = getOperation()->getRegions();
   if (regions.empty())
@@ -233,15 +677,48 @@ void SimpleCanonicalizer::runOnOperation() {
   assert(getOperation()->hasTrait<OpTrait::IsIsolatedFromAbove>() &&
          "patterns can only be applied to operations IsolatedFromAbove");
 
+  // Large graphs held in a single block, such as a flattened design, are
+  // split in to partitions which are simplified concurrently.  This is
+  // followed by a serial run over the whole region, which handles the
+  // interactions between partitions and normally converges immediately.
+  // Only graph regions are split, as moving operations between partitions
+  // would not preserve the dominance order of an SSACFG region.
+  if (parallel && getContext().isMultithreadingEnabled() &&
+      regions.size() == 1 && llvm::hasSingleElement(regions.front()) &&
+      isGraphRegion(getOperation()))
+    simplifyInParallel(regions.front().front());
+
   // Start the pattern driver.
   GreedyPatternRewriteDriver driver(getOperation()->getContext(), patterns);
 
   // FIXME: 10 is a bad value for a magic number here!
   driver.simplify(regions, 10);
-  return;
+  addStatistics(driver);
 }
 
 /// Create a Canonicalizer pass.
 std::unique_ptr<Pass> circt::createSimpleCanonicalizerPass() {
   return std::make_unique<SimpleCanonicalizer>();
 }
+
+//===----------------------------------------------------------------------===//
+// IncrementalSimplifier
+//===----------------------------------------------------------------------===//
+
+IncrementalSimplifier::IncrementalSimplifier(MLIRContext *context)
+    : IncrementalSimplifier(context, getCanonicalizationPatterns(context)) {}
+
+IncrementalSimplifier::IncrementalSimplifier(
+    MLIRContext *context, mlir::FrozenRewritePatternSet patterns)
+    : context(context), patterns(std::move(patterns)) {}
+
+SimplifyResult IncrementalSimplifier::simplify(ArrayRef<Operation *> changedOps,
+                                               int maxIterations) {
+  GreedyPatternRewriteDriver driver(context, patterns);
+  driver.simplifyFanOut(changedOps, maxIterations);
+
+  SimplifyResult result;
+  driver.getChangedOps(result.changedOps);
+  result.numErased = driver.numErased;
+  return result;
+}
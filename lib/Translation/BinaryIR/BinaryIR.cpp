@@ -0,0 +1,800 @@
+//===- BinaryIR.cpp - Binary IR reader and writer -------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the reader and the writer of the binary IR format.
+//
+// A file is laid out as follows, where every integer is an unsigned LEB128
+// number, and every reference to a table entry is its index in the table:
+//
+//   file       ::= magic version strings types attributes locations
+//                  numValues operation
+//   strings    ::= count (length bytes)*
+//   types      ::= count string*              // The textual form of the type.
+//   attributes ::= count attribute*
+//   attribute  ::= Text string                // The textual form of the attr.
+//                | Dictionary count (string attribute)*
+//   locations  ::= count location*
+//   location   ::= Unknown
+//                | FileLineCol string line column
+//                | Name string location
+//                | CallSite location location
+//                | Fused (attribute + 1 | 0) count location*
+//   operation  ::= string location count operand* count type*
+//                  (attribute + 1 | 0) count block* count region*
+//   operand    ::= value                      // A value defined earlier.
+//                | value type                 // A value defined later.
+//   region     ::= count (count type* count operation*)*
+//
+// Values are numbered in the order they are defined: the results of an
+// operation before the values defined in its regions, and the arguments of a
+// block before the values defined by its operations.  Table entries only
+// refer to the entries before them.  Successors refer to the blocks of the
+// enclosing region.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Translation/BinaryIR.h"
+#include "circt/Dialect/Comb/CombDialect.h"
+#include "circt/Dialect/FIRRTL/FIRRTLDialect.h"
+#include "circt/Dialect/RTL/RTLDialect.h"
+#include "circt/Dialect/SV/SVDialect.h"
+#include "circt/Dialect/Seq/SeqDialect.h"
+#include "circt/Support/LLVM.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/Verifier.h"
+#include "mlir/Parser.h"
+#include "mlir/Translation.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/LEB128.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace circt;
+
+/// Every file starts with these bytes.  The leading null byte keeps textual
+/// IR from ever being mistaken for binary IR.
+static const StringRef binaryIRMagic("\0CIRCTIR", 8);
+
+/// The version of the format, which is bumped on every incompatible change.
+static constexpr uint64_t binaryIRVersion = 1;
+
+namespace {
+/// The kinds of entries of the attribute table.
+enum AttributeKind : uint64_t { TextAttrKind, DictionaryAttrKind };
+
+/// The kinds of entries of the location table.
+enum LocationKind : uint64_t {
+  UnknownLocKind,
+  FileLineColLocKind,
+  NameLocKind,
+  CallSiteLocKind,
+  FusedLocKind
+};
+} // end anonymous namespace
+
+bool circt::isBinaryIR(StringRef buffer) {
+  return buffer.startswith(binaryIRMagic);
+}
+
+//===----------------------------------------------------------------------===//
+// Writer
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// Writes an operation in the binary IR format.  The operation stream is
+/// written into a separate buffer first, since the tables preceding it are
+/// only complete once every operation has been visited.
+class BinaryIRWriter {
+public:
+  void write(Operation *root, raw_ostream &os);
+
+private:
+  unsigned getStringID(StringRef string);
+  unsigned getTypeID(Type type);
+  unsigned getAttributeID(Attribute attr);
+  unsigned getLocationID(Location loc);
+
+  void numberValues(Operation *op);
+  void writeOperation(Operation *op);
+  void writeRegion(Region &region);
+  void emit(uint64_t value) { llvm::encodeULEB128(value, opsOS); }
+
+  /// The strings, in the order they were first used.
+  llvm::StringMap<unsigned> stringIDs;
+  std::vector<StringRef> strings;
+
+  /// The type table, holding the ID of the string of each type.
+  DenseMap<Type, unsigned> typeIDs;
+  std::vector<unsigned> types;
+
+  /// The encoded entries of the attribute and location tables.
+  DenseMap<Attribute, unsigned> attributeIDs;
+  std::string attributes;
+  llvm::raw_string_ostream attributesOS{attributes};
+  DenseMap<Location, unsigned> locationIDs;
+  std::string locations;
+  llvm::raw_string_ostream locationsOS{locations};
+  unsigned numLocations = 0;
+
+  /// The number of every value, and the number of values whose definition
+  /// has been written so far.  The uses of the other values are forward
+  /// references.
+  DenseMap<Value, unsigned> valueIDs;
+  unsigned numDefinedValues = 0;
+
+  /// The index of every block in its region.
+  DenseMap<Block *, unsigned> blockIDs;
+
+  /// The operation stream.
+  std::string ops;
+  llvm::raw_string_ostream opsOS{ops};
+};
+} // end anonymous namespace
+
+unsigned BinaryIRWriter::getStringID(StringRef string) {
+  auto it = stringIDs.try_emplace(string, strings.size());
+  if (it.second)
+    strings.push_back(it.first->getKey());
+  return it.first->second;
+}
+
+unsigned BinaryIRWriter::getTypeID(Type type) {
+  auto it = typeIDs.find(type);
+  if (it != typeIDs.end())
+    return it->second;
+
+  std::string text;
+  llvm::raw_string_ostream os(text);
+  os << type;
+  types.push_back(getStringID(os.str()));
+  return typeIDs[type] = types.size() - 1;
+}
+
+/// Dictionaries are stored as their entries, since most of them are unique to
+/// an operation while their entries are shared with many other operations.
+/// Every other attribute is stored in its textual form.
+unsigned BinaryIRWriter::getAttributeID(Attribute attr) {
+  auto it = attributeIDs.find(attr);
+  if (it != attributeIDs.end())
+    return it->second;
+
+  if (auto dict = attr.dyn_cast<DictionaryAttr>()) {
+    SmallVector<std::pair<unsigned, unsigned>, 4> entries;
+    for (auto entry : dict.getValue())
+      entries.push_back(
+          {getStringID(entry.first.strref()), getAttributeID(entry.second)});
+    llvm::encodeULEB128(DictionaryAttrKind, attributesOS);
+    llvm::encodeULEB128(entries.size(), attributesOS);
+    for (auto &entry : entries) {
+      llvm::encodeULEB128(entry.first, attributesOS);
+      llvm::encodeULEB128(entry.second, attributesOS);
+    }
+  } else {
+    std::string text;
+    llvm::raw_string_ostream os(text);
+    os << attr;
+    llvm::encodeULEB128(TextAttrKind, attributesOS);
+    llvm::encodeULEB128(getStringID(os.str()), attributesOS);
+  }
+
+  unsigned id = attributeIDs.size();
+  attributeIDs[attr] = id;
+  return id;
+}
+
+/// Opaque locations cannot be serialized, so they are replaced by their
+/// fallback locations.
+unsigned BinaryIRWriter::getLocationID(Location loc) {
+  auto it = locationIDs.find(loc);
+  if (it != locationIDs.end())
+    return it->second;
+
+  SmallVector<uint64_t, 4> fields;
+  if (auto fileLoc = loc.dyn_cast<FileLineColLoc>()) {
+    fields = {FileLineColLocKind, getStringID(fileLoc.getFilename()),
+              fileLoc.getLine(), fileLoc.getColumn()};
+  } else if (auto nameLoc = loc.dyn_cast<NameLoc>()) {
+    fields = {NameLocKind, getStringID(nameLoc.getName().strref()),
+              getLocationID(nameLoc.getChildLoc())};
+  } else if (auto callLoc = loc.dyn_cast<CallSiteLoc>()) {
+    fields = {CallSiteLocKind, getLocationID(callLoc.getCallee()),
+              getLocationID(callLoc.getCaller())};
+  } else if (auto fusedLoc = loc.dyn_cast<FusedLoc>()) {
+    auto metadata = fusedLoc.getMetadata();
+    fields = {FusedLocKind, metadata ? getAttributeID(metadata) + 1 : 0,
+              fusedLoc.getLocations().size()};
+    for (auto child : fusedLoc.getLocations())
+      fields.push_back(getLocationID(child));
+  } else if (auto opaqueLoc = loc.dyn_cast<OpaqueLoc>()) {
+    unsigned id = getLocationID(opaqueLoc.getFallbackLocation());
+    locationIDs[loc] = id;
+    return id;
+  } else {
+    fields = {UnknownLocKind};
+  }
+
+  for (auto field : fields)
+    llvm::encodeULEB128(field, locationsOS);
+  locationIDs[loc] = numLocations;
+  return numLocations++;
+}
+
+/// Number the values in the order the reader defines them.
+void BinaryIRWriter::numberValues(Operation *op) {
+  for (auto result : op->getResults())
+    valueIDs.insert({result, valueIDs.size()});
+  for (auto &region : op->getRegions()) {
+    for (auto &block : region) {
+      for (auto arg : block.getArguments())
+        valueIDs.insert({arg, valueIDs.size()});
+      for (auto &nested : block)
+        numberValues(&nested);
+    }
+  }
+}
+
+void BinaryIRWriter::writeOperation(Operation *op) {
+  emit(getStringID(op->getName().getStringRef()));
+  emit(getLocationID(op->getLoc()));
+
+  emit(op->getNumOperands());
+  for (auto operand : op->getOperands()) {
+    auto it = valueIDs.find(operand);
+    assert(it != valueIDs.end() &&
+           "operand defined outside of the written operation");
+    emit(it->second);
+    if (it->second >= numDefinedValues)
+      emit(getTypeID(operand.getType()));
+  }
+
+  emit(op->getNumResults());
+  for (auto type : op->getResultTypes())
+    emit(getTypeID(type));
+  numDefinedValues += op->getNumResults();
+
+  auto attrs = op->getAttrDictionary();
+  emit(attrs.empty() ? 0 : getAttributeID(attrs) + 1);
+
+  emit(op->getNumSuccessors());
+  for (auto *successor : op->getSuccessors())
+    emit(blockIDs.lookup(successor));
+
+  emit(op->getNumRegions());
+  for (auto &region : op->getRegions())
+    writeRegion(region);
+}
+
+void BinaryIRWriter::writeRegion(Region &region) {
+  unsigned numBlocks = 0;
+  for (auto &block : region)
+    blockIDs[&block] = numBlocks++;
+  emit(numBlocks);
+
+  for (auto &block : region) {
+    emit(block.getNumArguments());
+    for (auto arg : block.getArguments())
+      emit(getTypeID(arg.getType()));
+    numDefinedValues += block.getNumArguments();
+
+    emit(block.getOperations().size());
+    for (auto &op : block)
+      writeOperation(&op);
+  }
+}
+
+void BinaryIRWriter::write(Operation *root, raw_ostream &os) {
+  numberValues(root);
+  writeOperation(root);
+
+  os << binaryIRMagic;
+  llvm::encodeULEB128(binaryIRVersion, os);
+
+  llvm::encodeULEB128(strings.size(), os);
+  for (auto string : strings) {
+    llvm::encodeULEB128(string.size(), os);
+    os << string;
+  }
+
+  llvm::encodeULEB128(types.size(), os);
+  for (auto type : types)
+    llvm::encodeULEB128(type, os);
+
+  llvm::encodeULEB128(attributeIDs.size(), os);
+  os << attributesOS.str();
+  llvm::encodeULEB128(numLocations, os);
+  os << locationsOS.str();
+
+  llvm::encodeULEB128(valueIDs.size(), os);
+  os << opsOS.str();
+}
+
+void circt::exportBinaryIR(Operation *op, raw_ostream &os) {
+  BinaryIRWriter().write(op, os);
+}
+
+//===----------------------------------------------------------------------===//
+// Reader
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// Reads a module in the binary IR format.  The input is untrusted: every
+/// index and count is checked against the size of what it refers to, and
+/// every count against the number of bytes left, so that a malformed file
+/// results in an error rather than a crash or a huge allocation.
+class BinaryIRReader {
+public:
+  BinaryIRReader(llvm::MemoryBufferRef buffer, MLIRContext *context);
+
+  OwningModuleRef read();
+
+private:
+  InFlightDiagnostic emitError(const Twine &message);
+
+  LogicalResult readInt(uint64_t &value);
+  LogicalResult readCount(uint64_t &count);
+  LogicalResult readID(unsigned &id, size_t numEntries, StringRef kind);
+  LogicalResult readTables();
+  LogicalResult readAttribute();
+  LogicalResult readLocation();
+
+  LogicalResult readOperation(Block *block, ArrayRef<Block *> blocks,
+                              Operation *&op);
+  LogicalResult readRegion(Region &region);
+  LogicalResult readOperand(Value &value);
+  LogicalResult defineValue(Value value);
+  Optional<OperationName> getOperationName(unsigned stringID);
+
+  MLIRContext *context;
+  Location fileLoc;
+  DictionaryAttr emptyDict;
+
+  /// The bytes being read.
+  const uint8_t *start, *ptr, *end;
+
+  /// The tables.  The strings point into the buffer.
+  std::vector<StringRef> strings;
+  std::vector<Type> types;
+  std::vector<Attribute> attributes;
+  std::vector<Location> locations;
+  DenseMap<unsigned, OperationName> operationNames;
+
+  /// The values defined so far, and the placeholders of the values used
+  /// before their definition.
+  std::vector<Value> values;
+  unsigned numDefinedValues = 0;
+  DenseMap<unsigned, Operation *> forwardRefs;
+};
+} // end anonymous namespace
+
+BinaryIRReader::BinaryIRReader(llvm::MemoryBufferRef buffer,
+                               MLIRContext *context)
+    : context(context),
+      fileLoc(FileLineColLoc::get(context, buffer.getBufferIdentifier(),
+                                  /*line=*/0, /*column=*/0)),
+      emptyDict(DictionaryAttr::get(context)),
+      start(reinterpret_cast<const uint8_t *>(buffer.getBufferStart())),
+      ptr(start), end(reinterpret_cast<const uint8_t *>(buffer.getBufferEnd())) {
+}
+
+InFlightDiagnostic BinaryIRReader::emitError(const Twine &message) {
+  return mlir::emitError(fileLoc)
+         << "malformed binary IR at offset " << (ptr - start) << ": "
+         << message;
+}
+
+LogicalResult BinaryIRReader::readInt(uint64_t &value) {
+  unsigned size = 0;
+  const char *error = nullptr;
+  value = llvm::decodeULEB128(ptr, &size, end, &error);
+  if (error)
+    return emitError(error);
+  ptr += size;
+  return success();
+}
+
+/// Read the number of elements of a list.  Every element takes at least one
+/// byte, so a count larger than the rest of the input is malformed.
+LogicalResult BinaryIRReader::readCount(uint64_t &count) {
+  if (failed(readInt(count)))
+    return failure();
+  if (count > uint64_t(end - ptr))
+    return emitError("count " + Twine(count) + " exceeds the input size");
+  return success();
+}
+
+LogicalResult BinaryIRReader::readID(unsigned &id, size_t numEntries,
+                                     StringRef kind) {
+  uint64_t value;
+  if (failed(readInt(value)))
+    return failure();
+  if (value >= numEntries)
+    return emitError("invalid " + kind + " ID " + Twine(value));
+  id = value;
+  return success();
+}
+
+LogicalResult BinaryIRReader::readTables() {
+  uint64_t count;
+  if (failed(readCount(count)))
+    return failure();
+  strings.reserve(count);
+  for (uint64_t i = 0; i != count; ++i) {
+    uint64_t length;
+    if (failed(readInt(length)))
+      return failure();
+    if (length > uint64_t(end - ptr))
+      return emitError("string extends past the end of the input");
+    strings.push_back(StringRef(reinterpret_cast<const char *>(ptr), length));
+    ptr += length;
+  }
+
+  // Every distinct type and attribute is parsed once, however often it is
+  // used.
+  if (failed(readCount(count)))
+    return failure();
+  types.reserve(count);
+  for (uint64_t i = 0; i != count; ++i) {
+    unsigned id;
+    if (failed(readID(id, strings.size(), "string")))
+      return failure();
+    auto type = parseType(strings[id], context);
+    if (!type)
+      return emitError("invalid type '" + strings[id] + "'");
+    types.push_back(type);
+  }
+
+  if (failed(readCount(count)))
+    return failure();
+  attributes.reserve(count);
+  for (uint64_t i = 0; i != count; ++i)
+    if (failed(readAttribute()))
+      return failure();
+
+  if (failed(readCount(count)))
+    return failure();
+  locations.reserve(count);
+  for (uint64_t i = 0; i != count; ++i)
+    if (failed(readLocation()))
+      return failure();
+
+  if (failed(readCount(count)))
+    return failure();
+  values.resize(count);
+  return success();
+}
+
+LogicalResult BinaryIRReader::readAttribute() {
+  uint64_t kind;
+  if (failed(readInt(kind)))
+    return failure();
+
+  if (kind == TextAttrKind) {
+    unsigned id;
+    if (failed(readID(id, strings.size(), "string")))
+      return failure();
+    auto attr = parseAttribute(strings[id], context);
+    if (!attr)
+      return emitError("invalid attribute '" + strings[id] + "'");
+    attributes.push_back(attr);
+    return success();
+  }
+
+  if (kind != DictionaryAttrKind)
+    return emitError("invalid attribute kind " + Twine(kind));
+  uint64_t count;
+  if (failed(readCount(count)))
+    return failure();
+  SmallVector<NamedAttribute, 4> entries;
+  for (uint64_t i = 0; i != count; ++i) {
+    unsigned nameID, attrID;
+    if (failed(readID(nameID, strings.size(), "string")) ||
+        failed(readID(attrID, attributes.size(), "attribute")))
+      return failure();
+    entries.push_back(
+        {Identifier::get(strings[nameID], context), attributes[attrID]});
+  }
+  attributes.push_back(DictionaryAttr::getWithSorted(context, entries));
+  return success();
+}
+
+LogicalResult BinaryIRReader::readLocation() {
+  uint64_t kind;
+  if (failed(readInt(kind)))
+    return failure();
+
+  switch (kind) {
+  case UnknownLocKind:
+    locations.push_back(UnknownLoc::get(context));
+    return success();
+
+  case FileLineColLocKind: {
+    unsigned id;
+    uint64_t line, column;
+    if (failed(readID(id, strings.size(), "string")) ||
+        failed(readInt(line)) || failed(readInt(column)))
+      return failure();
+    locations.push_back(FileLineColLoc::get(context, strings[id], line, column));
+    return success();
+  }
+
+  case NameLocKind: {
+    unsigned nameID, childID;
+    if (failed(readID(nameID, strings.size(), "string")) ||
+        failed(readID(childID, locations.size(), "location")))
+      return failure();
+    locations.push_back(NameLoc::get(Identifier::get(strings[nameID], context),
+                                     locations[childID]));
+    return success();
+  }
+
+  case CallSiteLocKind: {
+    unsigned calleeID, callerID;
+    if (failed(readID(calleeID, locations.size(), "location")) ||
+        failed(readID(callerID, locations.size(), "location")))
+      return failure();
+    locations.push_back(
+        CallSiteLoc::get(locations[calleeID], locations[callerID]));
+    return success();
+  }
+
+  case FusedLocKind: {
+    unsigned metadataID;
+    uint64_t count;
+    if (failed(readID(metadataID, attributes.size() + 1, "attribute")) ||
+        failed(readCount(count)))
+      return failure();
+    SmallVector<Location, 4> fused;
+    for (uint64_t i = 0; i != count; ++i) {
+      unsigned id;
+      if (failed(readID(id, locations.size(), "location")))
+        return failure();
+      fused.push_back(locations[id]);
+    }
+    auto metadata = metadataID ? attributes[metadataID - 1] : Attribute();
+    locations.push_back(FusedLoc::get(context, fused, metadata));
+    return success();
+  }
+  }
+
+  return emitError("invalid location kind " + Twine(kind));
+}
+
+/// Return the name of an operation, loading its dialect if needed, or None if
+/// the operation is not registered and the context does not allow it.
+Optional<OperationName> BinaryIRReader::getOperationName(unsigned stringID) {
+  auto it = operationNames.find(stringID);
+  if (it != operationNames.end())
+    return it->second;
+
+  auto nameString = strings[stringID];
+  if (nameString.contains('.'))
+    context->getOrLoadDialect(nameString.split('.').first);
+  OperationName name(nameString, context);
+  if (!name.getAbstractOperation() && !context->allowsUnregisteredDialects()) {
+    emitError("unregistered operation '" + nameString + "'");
+    return None;
+  }
+  operationNames.insert({stringID, name});
+  return name;
+}
+
+LogicalResult BinaryIRReader::readOperand(Value &value) {
+  unsigned id;
+  if (failed(readID(id, values.size(), "value")))
+    return failure();
+  if (id < numDefinedValues) {
+    value = values[id];
+    return success();
+  }
+
+  // The value is defined later on.  Use a placeholder until then.
+  unsigned typeID;
+  if (failed(readID(typeID, types.size(), "type")))
+    return failure();
+  auto type = types[typeID];
+  auto &placeholder = forwardRefs[id];
+  if (!placeholder)
+    placeholder = Operation::create(
+        fileLoc, OperationName("placeholder", context), ArrayRef<Type>(type),
+        {}, emptyDict, {}, /*numRegions=*/0);
+  else if (placeholder->getResult(0).getType() != type)
+    return emitError("value " + Twine(id) + " used with different types");
+  value = placeholder->getResult(0);
+  return success();
+}
+
+LogicalResult BinaryIRReader::defineValue(Value value) {
+  unsigned id = numDefinedValues++;
+  if (id >= values.size())
+    return emitError("more values than declared");
+  values[id] = value;
+
+  auto it = forwardRefs.find(id);
+  if (it == forwardRefs.end())
+    return success();
+  auto *placeholder = it->second;
+  forwardRefs.erase(it);
+  if (placeholder->getResult(0).getType() != value.getType()) {
+    placeholder->dropAllUses();
+    placeholder->destroy();
+    return emitError("value " + Twine(id) + " used with a different type");
+  }
+  placeholder->getResult(0).replaceAllUsesWith(value);
+  placeholder->destroy();
+  return success();
+}
+
+/// Read an operation and append it to \p block, if any.  \p op is set as soon
+/// as the operation is created, so that it can be destroyed if the rest of it
+/// turns out to be malformed.
+LogicalResult BinaryIRReader::readOperation(Block *block,
+                                            ArrayRef<Block *> blocks,
+                                            Operation *&op) {
+  unsigned nameID, locID;
+  if (failed(readID(nameID, strings.size(), "string")) ||
+      failed(readID(locID, locations.size(), "location")))
+    return failure();
+  auto name = getOperationName(nameID);
+  if (!name)
+    return failure();
+
+  uint64_t count;
+  if (failed(readCount(count)))
+    return failure();
+  SmallVector<Value, 4> operands(count);
+  for (auto &operand : operands)
+    if (failed(readOperand(operand)))
+      return failure();
+
+  if (failed(readCount(count)))
+    return failure();
+  SmallVector<Type, 4> resultTypes;
+  for (uint64_t i = 0; i != count; ++i) {
+    unsigned typeID;
+    if (failed(readID(typeID, types.size(), "type")))
+      return failure();
+    resultTypes.push_back(types[typeID]);
+  }
+
+  unsigned attrID;
+  if (failed(readID(attrID, attributes.size() + 1, "attribute")))
+    return failure();
+  auto attrs = attrID ? attributes[attrID - 1].dyn_cast<DictionaryAttr>()
+                      : emptyDict;
+  if (!attrs)
+    return emitError("operation attributes are not a dictionary");
+
+  if (failed(readCount(count)))
+    return failure();
+  SmallVector<Block *, 2> successors;
+  for (uint64_t i = 0; i != count; ++i) {
+    unsigned blockID;
+    if (failed(readID(blockID, blocks.size(), "block")))
+      return failure();
+    successors.push_back(blocks[blockID]);
+  }
+
+  uint64_t numRegions;
+  if (failed(readCount(numRegions)))
+    return failure();
+
+  op = Operation::create(locations[locID], *name, resultTypes, operands, attrs,
+                         successors, numRegions);
+  if (block)
+    block->push_back(op);
+  for (auto result : op->getResults())
+    if (failed(defineValue(result)))
+      return failure();
+  for (auto &region : op->getRegions())
+    if (failed(readRegion(region)))
+      return failure();
+  return success();
+}
+
+LogicalResult BinaryIRReader::readRegion(Region &region) {
+  uint64_t numBlocks;
+  if (failed(readCount(numBlocks)))
+    return failure();
+  SmallVector<Block *, 1> blocks;
+  for (uint64_t i = 0; i != numBlocks; ++i) {
+    blocks.push_back(new Block());
+    region.push_back(blocks.back());
+  }
+
+  for (auto *block : blocks) {
+    uint64_t count;
+    if (failed(readCount(count)))
+      return failure();
+    for (uint64_t i = 0; i != count; ++i) {
+      unsigned typeID;
+      if (failed(readID(typeID, types.size(), "type")) ||
+          failed(defineValue(block->addArgument(types[typeID]))))
+        return failure();
+    }
+
+    if (failed(readCount(count)))
+      return failure();
+    for (uint64_t i = 0; i != count; ++i) {
+      Operation *op = nullptr;
+      if (failed(readOperation(block, blocks, op)))
+        return failure();
+    }
+  }
+  return success();
+}
+
+OwningModuleRef BinaryIRReader::read() {
+  Operation *root = nullptr;
+  auto result = [&]() -> LogicalResult {
+    if (!isBinaryIR(StringRef(reinterpret_cast<const char *>(start),
+                              end - start)))
+      return emitError("missing binary IR header");
+    ptr += binaryIRMagic.size();
+
+    uint64_t version;
+    if (failed(readInt(version)))
+      return failure();
+    if (version != binaryIRVersion)
+      return emitError("unsupported version " + Twine(version));
+
+    if (failed(readTables()) || failed(readOperation(nullptr, {}, root)))
+      return failure();
+    if (ptr != end)
+      return emitError("unexpected data after the operation");
+    if (!forwardRefs.empty())
+      return emitError("value " + Twine(forwardRefs.begin()->first) +
+                       " is used but never defined");
+    if (!isa<ModuleOp>(root))
+      return emitError("expected a builtin.module");
+    return verify(root);
+  }();
+
+  if (succeeded(result))
+    return cast<ModuleOp>(root);
+
+  // Destroy the operations first, so that the placeholders have no uses left.
+  if (root)
+    root->destroy();
+  for (auto &forwardRef : forwardRefs) {
+    forwardRef.second->dropAllUses();
+    forwardRef.second->destroy();
+  }
+  return {};
+}
+
+OwningModuleRef circt::importBinaryIR(llvm::MemoryBufferRef buffer,
+                                      MLIRContext *context) {
+  return BinaryIRReader(buffer, context).read();
+}
+
+//===----------------------------------------------------------------------===//
+// Translation registration
+//===----------------------------------------------------------------------===//
+
+void circt::registerBinaryIRTranslation() {
+  TranslateFromMLIRRegistration toBinary(
+      "export-circt-binary",
+      [](ModuleOp module, raw_ostream &os) {
+        exportBinaryIR(module, os);
+        return success();
+      },
+      [](DialectRegistry &registry) {
+        registry.insert<comb::CombDialect, firrtl::FIRRTLDialect,
+                        rtl::RTLDialect, seq::SeqDialect, sv::SVDialect>();
+      });
+
+  TranslateToMLIRRegistration fromBinary(
+      "import-circt-binary",
+      [](llvm::SourceMgr &sourceMgr, MLIRContext *context) {
+        context->loadDialect<comb::CombDialect, firrtl::FIRRTLDialect,
+                             rtl::RTLDialect, seq::SeqDialect, sv::SVDialect>();
+        auto *buffer = sourceMgr.getMemoryBuffer(sourceMgr.getMainFileID());
+        return importBinaryIR(buffer->getMemBufferRef(), context);
+      });
+}
@@ -11,6 +11,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "circt/Translation/ExportVerilog.h"
+
+#include "ExportVerilogInternals.h"
 #include "circt/Dialect/Comb/CombDialect.h"
 #include "circt/Dialect/Comb/CombVisitors.h"
 #include "circt/Dialect/RTL/RTLOps.h"
@@ -19,19 +21,25 @@
 #include "circt/Dialect/SV/SVOps.h"
 #include "circt/Dialect/SV/SVVisitors.h"
 #include "circt/Support/LLVM.h"
+#include "circt/Support/ImplicitLocOpBuilder.h"
 #include "circt/Support/LoweringOptions.h"
+#include "circt/Translation/Passes.h"
 #include "mlir/IR/BuiltinOps.h"
-#include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/Pass/PassManager.h"
 #include "mlir/Support/FileUtilities.h"
 #include "mlir/Translation.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SaveAndRestore.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
+#include <mutex>
 
 using namespace circt;
 
@@ -43,25 +51,6 @@ using namespace sv;
 // Helper routines
 //===----------------------------------------------------------------------===//
 
-/// Return true for operations that are always inlined into a containing
-/// expression.
-static bool isExpressionAlwaysInline(Operation *op) {
-  // We need to emit array indexes inline per verilog "lvalue" semantics.
-  if (isa<ArrayIndexInOutOp>(op))
-    return true;
-
-  // An SV interface modport is a symbolic name that is always inlined.
-  if (isa<GetModportOp>(op) || isa<ReadInterfaceSignalOp>(op))
-    return true;
-
-  return false;
-}
-
-/// Return whether an operation is a constant.
-static bool isConstantExpression(Operation *op) {
-  return isa<ConstantOp>(op) || isa<ConstantXOp>(op) || isa<ConstantZOp>(op);
-}
-
 /// Return true for nullary operations that are better emitted multiple
 /// times as inline expression (when they have multiple uses) rather than having
 /// a temporary wire.
@@ -324,20 +313,13 @@ enum VerilogPrecedence {
 };
 } // end anonymous namespace
 
-/// Return the location information as a (potentially empty) string.
+/// Return the specified set of unique locations as a (potentially empty)
+/// string.
 static std::string
-getLocationInfoAsString(const SmallPtrSet<Operation *, 8> &ops) {
+getLocationInfoAsString(ArrayRef<FileLineColLoc> locations) {
   std::string resultStr;
   llvm::raw_string_ostream sstr(resultStr);
 
-  // Multiple operations may come from the same location or may not have useful
-  // location info.  Unique it now.
-  SmallPtrSet<Attribute, 8> locations;
-  for (auto *op : ops) {
-    if (auto loc = op->getLoc().dyn_cast<FileLineColLoc>())
-      locations.insert(loc);
-  }
-
   auto printLoc = [&](FileLineColLoc loc) {
     sstr << loc.getFilename();
     if (auto line = loc.getLine()) {
@@ -349,7 +331,7 @@ getLocationInfoAsString(const SmallPtrSet<Operation *, 8> &ops) {
 
   switch (locations.size()) {
   case 1:
-    printLoc((*locations.begin()).cast<FileLineColLoc>());
+    printLoc(locations.front());
     LLVM_FALLTHROUGH;
   case 0:
     return sstr.str();
@@ -358,11 +340,7 @@ getLocationInfoAsString(const SmallPtrSet<Operation *, 8> &ops) {
   }
 
   // Sort the entries.
-  SmallVector<FileLineColLoc, 8> locVector;
-  locVector.reserve(locations.size());
-  for (auto loc : locations)
-    locVector.push_back(loc.cast<FileLineColLoc>());
-
+  SmallVector<FileLineColLoc, 8> locVector(locations.begin(), locations.end());
   llvm::array_pod_sort(
       locVector.begin(), locVector.end(),
       [](const FileLineColLoc *lhs, const FileLineColLoc *rhs) -> int {
@@ -439,12 +417,73 @@ public:
   bool encounteredError = false;
   unsigned currentIndent = 0;
 
+  /// The name that the source map IDs handed out by this state are scoped to,
+  /// typically the name of the module being emitted.  If this is empty,
+  /// location information is always printed inline.
+  StringRef sourceMapScope;
+
+  /// The location strings referred to by the source map IDs handed out so
+  /// far, indexed by ID.
+  std::vector<std::string> sourceMapEntries;
+
+  /// Return the comment (including its leading tab) describing the locations
+  /// of the specified operations, or an empty string if they have no useful
+  /// location information.
+  StringRef getLocationComment(const SmallPtrSet<Operation *, 8> &ops);
+
 private:
+  /// Statements mostly share a handful of location sets, so the comment for
+  /// each set is only formatted once.  This is keyed on the bytes of the
+  /// sorted list of uniqued location attribute pointers in the set.
+  llvm::StringMap<std::string> locationComments;
+
   VerilogEmitterState(const VerilogEmitterState &) = delete;
   void operator=(const VerilogEmitterState &) = delete;
 };
 } // namespace
 
+StringRef VerilogEmitterState::getLocationComment(
+    const SmallPtrSet<Operation *, 8> &ops) {
+  // Multiple operations may come from the same location or may not have useful
+  // location info.  Unique it now.
+  SmallVector<const void *, 8> locations;
+  for (auto *op : ops) {
+    if (auto loc = op->getLoc().dyn_cast<FileLineColLoc>())
+      locations.push_back(Attribute(loc).getAsOpaquePointer());
+  }
+  if (locations.empty())
+    return {};
+
+  llvm::array_pod_sort(locations.begin(), locations.end());
+  locations.erase(std::unique(locations.begin(), locations.end()),
+                  locations.end());
+
+  StringRef key(reinterpret_cast<const char *>(locations.data()),
+                locations.size() * sizeof(const void *));
+  auto it = locationComments.try_emplace(key);
+  auto &comment = it.first->second;
+  if (!it.second)
+    return comment;
+
+  SmallVector<FileLineColLoc, 8> locVector;
+  locVector.reserve(locations.size());
+  for (auto *loc : locations)
+    locVector.push_back(
+        Attribute::getFromOpaquePointer(loc).cast<FileLineColLoc>());
+
+  auto locInfo = getLocationInfoAsString(locVector);
+  if (locInfo.empty())
+    return comment;
+
+  if (options.emitSourceMapIDs && !sourceMapScope.empty()) {
+    comment = "\t// @" + std::to_string(sourceMapEntries.size());
+    sourceMapEntries.push_back(std::move(locInfo));
+  } else {
+    comment = "\t// " + locInfo;
+  }
+  return comment;
+}
+
 //===----------------------------------------------------------------------===//
 // EmitterBase
 //===----------------------------------------------------------------------===//
@@ -482,10 +521,7 @@ public:
   /// aggregate it together and print a pretty comment specifying where the
   /// operations came from.  In any case, print a newline.
   void emitLocationInfoAndNewLine(const SmallPtrSet<Operation *, 8> &ops) {
-    auto locInfo = getLocationInfoAsString(ops);
-    if (!locInfo.empty())
-      os << "\t// " << locInfo;
-    os << '\n';
+    os << state.getLocationComment(ops) << '\n';
   }
 
   void emitTextWithSubstitutions(StringRef string, Operation *op,
@@ -573,7 +609,6 @@ public:
   explicit ModuleEmitter(VerilogEmitterState &state) : EmitterBase(state) {}
 
   void emitRTLModule(RTLModuleOp module);
-  void prepareRTLModule(Block &block);
   void emitRTLExternModule(RTLModuleExternOp module);
   void emitRTLGeneratedModule(RTLModuleGeneratedOp module);
 
@@ -2442,228 +2477,11 @@ void ModuleEmitter::emitRTLGeneratedModule(RTLModuleGeneratedOp module) {
   os << "// external generated module " << verilogName.getValue() << "\n\n";
 }
 
-// Given a side effect free "always inline" operation, make sure that it exists
-// in the same block as its users and that it has one use for each one.
-static void lowerAlwaysInlineOperation(Operation *op) {
-  assert(op->getNumResults() == 1 &&
-         "only support 'always inline' ops with one result");
-
-  // Nuke use-less operations.
-  if (op->use_empty()) {
-    op->erase();
-    return;
-  }
-
-  // Moving/cloning an op should pull along its operand tree with it if they are
-  // always inline.  This happens when an array index has a constant operand for
-  // example.
-  auto recursivelyHandleOperands = [](Operation *op) {
-    for (auto operand : op->getOperands()) {
-      if (auto *operandOp = operand.getDefiningOp())
-        if (isExpressionAlwaysInline(operandOp))
-          lowerAlwaysInlineOperation(operandOp);
-    }
-  };
-
-  // If this operation has multiple uses, duplicate it into N-1 of them in turn.
-  while (!op->hasOneUse()) {
-    OpOperand &use = *op->getUses().begin();
-    Operation *user = use.getOwner();
-
-    // Clone the op before the user.
-    auto *newOp = op->clone();
-    user->getBlock()->getOperations().insert(Block::iterator(user), newOp);
-    // Change the user to use the new op.
-    use.set(newOp->getResult(0));
-
-    // If any of the operations of the moved op are always inline, recursively
-    // handle them too.
-    recursivelyHandleOperands(newOp);
-  }
-
-  // Finally, ensures the op is in the same block as its user so it can be
-  // inlined.
-  Operation *user = *op->getUsers().begin();
-  if (op->getBlock() != user->getBlock()) {
-    op->moveBefore(user);
-
-    // If any of the operations of the moved op are always inline, recursively
-    // move/clone them too.
-    recursivelyHandleOperands(op);
-  }
-  return;
-}
-
-/// We lower the Merge operation to a wire at the top level along with connects
-/// to it and a ReadInOut.
-static Value lowerMergeOp(MergeOp merge) {
-  auto module = merge->getParentOfType<RTLModuleOp>();
-  assert(module && "merges should only be in a module");
-
-  // Start with the wire at the top level.
-  ImplicitLocOpBuilder b(merge.getLoc(), &module.getBodyBlock()->front());
-  auto wire = b.create<WireOp>(merge.getType());
-
-  // Each of the operands is a connect or passign into the wire.
-  b.setInsertionPoint(merge);
-  if (merge->getParentOp()->hasTrait<sv::ProceduralRegion>()) {
-    for (auto op : merge.getOperands())
-      b.create<PAssignOp>(wire, op);
-  } else {
-    for (auto op : merge.getOperands())
-      b.create<ConnectOp>(wire, op);
-  }
-
-  return b.create<ReadInOutOp>(wire);
-}
-
-/// Lower a commutative operation into an expression tree.  This enables
-/// long-line splitting to work with them.
-static Value lowerVariadicCommutativeOp(Operation &op, OperandRange operands) {
-  Value lhs, rhs;
-  switch (operands.size()) {
-  case 0:
-    assert(0 && "cannot be called with empty operand range");
-    break;
-  case 1:
-    return operands[0];
-  case 2:
-    lhs = operands[0];
-    rhs = operands[1];
-    break;
-  default:
-    auto firstHalf = operands.size() / 2;
-    lhs = lowerVariadicCommutativeOp(op, operands.take_front(firstHalf));
-    rhs = lowerVariadicCommutativeOp(op, operands.drop_front(firstHalf));
-    break;
-  }
-
-  OperationState state(op.getLoc(), op.getName());
-  // state.addOperands(ValueRange{lhs, rhs});
-  state.addOperands(lhs);
-  state.addOperands(rhs);
-  state.addTypes(op.getResult(0).getType());
-  auto *newOp = Operation::create(state);
-  op.getBlock()->getOperations().insert(Block::iterator(&op), newOp);
-  return newOp->getResult(0);
-}
-
-/// When we find that an operation is used before it is defined in a graph
-/// region, we emit an explicit wire to resolve the issue.
-static void lowerUsersToTemporaryWire(Operation &op) {
-  Block *block = op.getBlock();
-  auto builder = ImplicitLocOpBuilder::atBlockBegin(op.getLoc(), block);
-
-  for (auto result : op.getResults()) {
-    auto newWire = builder.create<WireOp>(result.getType());
-
-    while (!result.use_empty()) {
-      auto newWireRead = builder.create<ReadInOutOp>(newWire);
-      OpOperand &use = *result.getUses().begin();
-      use.set(newWireRead);
-      newWireRead->moveBefore(use.getOwner());
-    }
-
-    auto connect = builder.create<ConnectOp>(newWire, result);
-    connect->moveAfter(&op);
-  }
-}
-
-/// For each module we emit, do a prepass over the structure, pre-lowering and
-/// otherwise rewriting operations we don't want to emit.
-void ModuleEmitter::prepareRTLModule(Block &block) {
-  for (auto &op : llvm::make_early_inc_range(block)) {
-    // If the operations has regions, lower each of the regions.
-    for (auto &region : op.getRegions()) {
-      if (!region.empty())
-        prepareRTLModule(region.front());
-    }
-
-    // Duplicate "always inline" expression for each of their users and move
-    // them to be next to their users.
-    if (isExpressionAlwaysInline(&op)) {
-      lowerAlwaysInlineOperation(&op);
-      continue;
-    }
-
-    // Lower 'merge' operations to wires and connects.
-    if (auto merge = dyn_cast<MergeOp>(op)) {
-      auto result = lowerMergeOp(merge);
-      op.getResult(0).replaceAllUsesWith(result);
-      op.erase();
-      continue;
-    }
-
-    // Lower commutative variadic operations with more than two operands into
-    // balanced operand trees so we can split long lines across multiple
-    // statements.
-    if (op.getNumOperands() > 2 && op.getNumResults() == 1 &&
-        op.hasTrait<mlir::OpTrait::IsCommutative>() &&
-        mlir::MemoryEffectOpInterface::hasNoEffect(&op) &&
-        op.getNumRegions() == 0 && op.getNumSuccessors() == 0 &&
-        op.getAttrs().empty()) {
-      // Lower this operation to a balanced binary tree of the same operation.
-      auto result = lowerVariadicCommutativeOp(op, op.getOperands());
-      op.getResult(0).replaceAllUsesWith(result);
-      op.erase();
-      continue;
-    }
-  }
-
-  // Now that all the basic ops are settled, check for any use-before def issues
-  // in graph regions.  Lower these into explicit wires to keep the emitter
-  // simple.
-  if (!block.getParentOp()->hasTrait<ProceduralRegion>()) {
-    SmallPtrSet<Operation *, 32> seenOperations;
-
-    for (auto &op : llvm::make_early_inc_range(block)) {
-      // Check the users of any expressions to see if they are
-      // lexically below the operation itself.  If so, it is being used out
-      // of order.
-      bool haveAnyOutOfOrderUses = false;
-      for (auto *userOp : op.getUsers()) {
-        // If the user is in a suboperation like an always block, then zip up
-        // to the operation that uses it.
-        while (&block != &userOp->getParentRegion()->front())
-          userOp = userOp->getParentOp();
-
-        if (seenOperations.count(userOp)) {
-          haveAnyOutOfOrderUses = true;
-          break;
-        }
-      }
-
-      // Remember that we've seen this operation.
-      seenOperations.insert(&op);
-
-      // If all the uses of the operation are below this, then we're ok.
-      if (!haveAnyOutOfOrderUses)
-        continue;
-
-      // If this is a reg/wire declaration, then we move it to the top of the
-      // block.  We can't abstract the inout result.
-      if (op.getNumResults() == 1 &&
-          op.getResult(0).getType().isa<InOutType>() &&
-          op.getNumOperands() == 0) {
-        op.moveBefore(&block.front());
-        continue;
-      }
-
-      // If this is a constant, then we move it to the top of the block.
-      if (isConstantExpression(&op)) {
-        op.moveBefore(&block.front());
-        continue;
-      }
-
-      // Otherwise, we need to lower this to a wire to resolve this.
-      lowerUsersToTemporaryWire(op);
-    }
-  }
-}
-
 void ModuleEmitter::emitRTLModule(RTLModuleOp module) {
-  // Perform lowerings to make it easier to emit the module.
-  prepareRTLModule(*module.getBodyBlock());
+  // The entry points of the emitter prepare the modules which have not been
+  // prepared yet, before any module is emitted.
+  assert(isPreparedForEmission(*module.getBodyBlock()) &&
+         "module must be prepared for emission");
 
   // Add all the ports to the name table.
   SmallVector<ModulePortInfo> portInfo = module.getPorts();
@@ -2814,67 +2632,316 @@ struct RootEmitterBase {
 
 } // namespace
 
+/// Print the source map entries handed out while emitting \p scope, one line
+/// per ID.  Each line holds the qualified ID (e.g. `Foo@3`), a tab, and the
+/// locations that the ID stands for.
+static void emitSourceMap(raw_ostream &os, StringRef scope,
+                          ArrayRef<std::string> entries,
+                          StringRef linePrefix = "") {
+  for (auto &entry : llvm::enumerate(entries))
+    os << linePrefix << scope << '@' << entry.index() << '\t' << entry.value()
+       << '\n';
+}
+
 //===----------------------------------------------------------------------===//
 // Unified Emitter
 //===----------------------------------------------------------------------===//
 
 namespace {
 
-/// A Verilog emitter that emits all modules into a single output stream.
+/// A Verilog emitter that emits all modules into a single output stream.  Each
+/// top-level operation is emitted into a separate buffer.  This lets the
+/// modules be emitted in parallel, while writing the buffers out in the
+/// original order of the operations keeps the output identical to a serial
+/// emission.  A buffer is written out and released as soon as all the buffers
+/// before it have been.
 struct UnifiedEmitter : public RootEmitterBase {
-  explicit UnifiedEmitter(llvm::raw_ostream &os, ModuleOp rootOp)
-      : RootEmitterBase(rootOp), os(os) {}
+  explicit UnifiedEmitter(llvm::raw_ostream &os, ModuleOp rootOp,
+                          llvm::raw_ostream *sourceMapOS)
+      : RootEmitterBase(rootOp), os(os), sourceMapOS(sourceMapOS) {}
 
   /// The output stream to emit into.
   llvm::raw_ostream &os;
 
+  /// The stream to write the source map table into, if any.
+  llvm::raw_ostream *sourceMapOS;
+
+  /// The emitter options, read from the root module.
+  LoweringOptions options;
+
+  /// The top-level operations in their original order.
+  SmallVector<Operation *, 0> ops;
+
+  /// Read the emitter options and collect the top-level operations.
+  void collectOperations();
+
+  /// Emit the top-level operation with the specified index, and write out the
+  /// buffers which are complete.  This may be called concurrently for
+  /// different operations.
+  void emitOperation(size_t index);
+
+  /// Write the source map table, if one was requested.  This must be called
+  /// after all operations have been emitted.
+  void emitSourceMaps();
+
   void emitMLIRModule();
+
+private:
+  /// The emitted text and source map entries of each operation.
+  std::vector<std::string> buffers;
+  std::vector<std::vector<std::string>> sourceMaps;
+  SmallVector<StringRef, 0> sourceMapScopes;
+
+  /// Which operations have been emitted, and the number of buffers written
+  /// out so far.  These are guarded by `writeMutex`, as is `os`.
+  std::vector<bool> emitted;
+  size_t numWritten = 0;
+  std::mutex writeMutex;
 };
 
 } // namespace
 
-void UnifiedEmitter::emitMLIRModule() {
-  VerilogEmitterState state(os);
-
+void UnifiedEmitter::collectOperations() {
   // Read the emitter options out of the module.
-  state.options.parseFromAttribute(rootOp);
+  options = LoweringOptions(rootOp);
 
-  for (auto &op : *rootOp.getBody()) {
-    if (auto rootOp = dyn_cast<RTLModuleOp>(op))
-      ModuleEmitter(state).emitRTLModule(rootOp);
-    else if (auto rootOp = dyn_cast<RTLModuleExternOp>(op))
-      ModuleEmitter(state).emitRTLExternModule(rootOp);
-    else if (auto rootOp = dyn_cast<RTLModuleGeneratedOp>(op))
-      ModuleEmitter(state).emitRTLGeneratedModule(rootOp);
-    else if (isa<RTLGeneratorSchemaOp>(op)) { /* Empty */
-    } else if (isa<InterfaceOp>(op) || isa<VerbatimOp>(op) ||
-               isa<IfDefProceduralOp>(op))
-      ModuleEmitter(state).emitStatement(&op);
-    else {
-      encounteredError = true;
-      op.emitError("unknown operation");
-    }
+  for (auto &op : *rootOp.getBody())
+    ops.push_back(&op);
+  buffers.resize(ops.size());
+  sourceMaps.resize(ops.size());
+  sourceMapScopes.resize(ops.size());
+  emitted.resize(ops.size());
+}
+
+void UnifiedEmitter::emitOperation(size_t index) {
+  auto &op = *ops[index];
+  llvm::raw_string_ostream bufferStream(buffers[index]);
+  VerilogEmitterState state(bufferStream);
+  state.options = options;
+
+  // Source map IDs are scoped to the module or interface they occur in.
+  if (auto module = dyn_cast<RTLModuleOp>(op))
+    state.sourceMapScope = module.getNameAttr().getValue();
+  else if (auto intfOp = dyn_cast<InterfaceOp>(op))
+    state.sourceMapScope = intfOp.sym_name();
+  sourceMapScopes[index] = state.sourceMapScope;
+
+  if (auto module = dyn_cast<RTLModuleOp>(op))
+    ModuleEmitter(state).emitRTLModule(module);
+  else if (auto module = dyn_cast<RTLModuleExternOp>(op))
+    ModuleEmitter(state).emitRTLExternModule(module);
+  else if (auto module = dyn_cast<RTLModuleGeneratedOp>(op))
+    ModuleEmitter(state).emitRTLGeneratedModule(module);
+  else if (isa<RTLGeneratorSchemaOp>(op)) { /* Empty */
+  } else if (isa<InterfaceOp>(op) || isa<VerbatimOp>(op) ||
+             isa<IfDefProceduralOp>(op))
+    ModuleEmitter(state).emitStatement(&op);
+  else {
+    encounteredError = true;
+    op.emitError("unknown operation");
   }
+
   if (state.encounteredError)
     encounteredError = true;
+  bufferStream.flush();
+  sourceMaps[index] = std::move(state.sourceMapEntries);
+
+  // Write out the buffers which are now complete, releasing each one as soon
+  // as it is written.
+  std::lock_guard<std::mutex> lock(writeMutex);
+  emitted[index] = true;
+  while (numWritten != ops.size() && emitted[numWritten]) {
+    os << buffers[numWritten];
+    std::string().swap(buffers[numWritten]);
+    ++numWritten;
+  }
+}
+
+void UnifiedEmitter::emitSourceMaps() {
+  if (!options.emitSourceMapIDs)
+    return;
+
+  // Write the source map table to its own stream if we have one, otherwise
+  // append it to the output in a comment block.
+  if (!sourceMapOS)
+    os << "\n// Source map:\n";
+  for (size_t index = 0, e = ops.size(); index != e; ++index) {
+    if (sourceMapOS)
+      emitSourceMap(*sourceMapOS, sourceMapScopes[index], sourceMaps[index]);
+    else
+      emitSourceMap(os, sourceMapScopes[index], sourceMaps[index], "// ");
+  }
+}
+
+void UnifiedEmitter::emitMLIRModule() {
+  collectOperations();
+
+  auto *context = rootOp.getContext();
+  if (context->isMultithreadingEnabled()) {
+    mlir::ParallelDiagnosticHandler diagHandler(context);
+    llvm::parallelForEachN(0, ops.size(), [&](size_t index) {
+      diagHandler.setOrderIDForThread(index);
+      emitOperation(index);
+      diagHandler.eraseOrderIDForThread();
+    });
+  } else {
+    for (size_t index = 0, e = ops.size(); index != e; ++index)
+      emitOperation(index);
+  }
+
+  emitSourceMaps();
 }
 
+//===----------------------------------------------------------------------===//
+// Streaming Emitter
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// The state shared by the passes of a streaming emission pipeline.
+struct StreamingEmitter : public UnifiedEmitter {
+  using UnifiedEmitter::UnifiedEmitter;
+
+  /// The index of each rtl.module among the top-level operations.
+  DenseMap<Operation *, size_t> moduleIndices;
+};
+
+/// The first pass of a streaming emission pipeline.  It runs once the set of
+/// top-level operations is final, and emits all of them but the rtl.module
+/// operations, which are emitted by the nested pipeline.  The pass manager
+/// hands the operations of a nested pipeline out to the threads in order, so
+/// the modules finish roughly in the order of the design, and each one is
+/// written out as soon as no module before it is pending.
+struct StartStreamingEmissionPass
+    : public mlir::PassWrapper<StartStreamingEmissionPass,
+                               mlir::OperationPass<ModuleOp>> {
+  explicit StartStreamingEmissionPass(
+      std::shared_ptr<StreamingEmitter> emitter)
+      : emitter(std::move(emitter)) {}
+
+  void runOnOperation() override {
+    auto &state = *emitter;
+    state.rootOp = getOperation();
+    state.collectOperations();
+
+    for (size_t index = 0, e = state.ops.size(); index != e; ++index) {
+      if (isa<RTLModuleOp>(state.ops[index]))
+        state.moduleIndices[state.ops[index]] = index;
+      else
+        state.emitOperation(index);
+    }
+    markAllAnalysesPreserved();
+  }
+
+  std::shared_ptr<StreamingEmitter> emitter;
+};
+
+/// The pass of a streaming emission pipeline which emits each rtl.module, and
+/// then frees its body.  The module itself stays, as the interface which the
+/// instances in other modules refer to, until the pipeline finishes.
+struct EmitModuleStreamingPass
+    : public mlir::PassWrapper<EmitModuleStreamingPass,
+                               mlir::OperationPass<RTLModuleOp>> {
+  explicit EmitModuleStreamingPass(std::shared_ptr<StreamingEmitter> emitter)
+      : emitter(std::move(emitter)) {}
+
+  void runOnOperation() override {
+    auto module = getOperation();
+    emitter->emitOperation(emitter->moduleIndices.lookup(module));
+
+    // Replace the body with wires driving the outputs, which keeps the IR
+    // valid until the module is replaced by a declaration.
+    auto *body = module.getBodyBlock();
+    auto output = cast<OutputOp>(body->getTerminator());
+    SmallVector<Operation *, 0> oldOps;
+    for (auto &op : body->without_terminator())
+      oldOps.push_back(&op);
+
+    ImplicitLocOpBuilder builder(module.getLoc(), output);
+    SmallVector<Value, 4> results;
+    for (auto type : output.getOperandTypes())
+      results.push_back(
+          builder.create<ReadInOutOp>(builder.create<WireOp>(type)));
+    output->setOperands(results);
+
+    for (auto *op : oldOps)
+      op->dropAllReferences();
+    for (auto *op : oldOps)
+      op->erase();
+  }
+
+  std::shared_ptr<StreamingEmitter> emitter;
+};
+
+/// The last pass of a streaming emission pipeline.  It replaces the emitted
+/// rtl.module operations, whose bodies are stubs by now, by declarations, and
+/// writes the source map table.
+struct FinishStreamingEmissionPass
+    : public mlir::PassWrapper<FinishStreamingEmissionPass,
+                               mlir::OperationPass<ModuleOp>> {
+  explicit FinishStreamingEmissionPass(
+      std::shared_ptr<StreamingEmitter> emitter)
+      : emitter(std::move(emitter)) {}
+
+  void runOnOperation() override {
+    for (auto &entry : emitter->moduleIndices) {
+      auto module = cast<RTLModuleOp>(entry.first);
+      OpBuilder builder(module);
+      SmallVector<ModulePortInfo> ports = module.getPorts();
+      builder.create<RTLModuleExternOp>(module.getLoc(), module.getNameAttr(),
+                                        ports);
+      module.erase();
+    }
+
+    emitter->emitSourceMaps();
+    if (emitter->encounteredError)
+      signalPassFailure();
+  }
+
+  std::shared_ptr<StreamingEmitter> emitter;
+};
+
+} // namespace
+
 //===----------------------------------------------------------------------===//
 // Split Emitter
 //===----------------------------------------------------------------------===//
 
+/// Write \p contents to the file at \p path, unless the file already exists
+/// with exactly these contents.  Leaving unchanged files alone preserves their
+/// modification time, so that timestamp-driven downstream tools only reprocess
+/// the modules that actually changed between two runs.
+static LogicalResult writeFileIfChanged(StringRef path, StringRef contents,
+                                        std::string &errorMessage) {
+  if (auto existing = llvm::MemoryBuffer::getFile(path))
+    if ((*existing)->getBuffer() == contents)
+      return success();
+
+  auto output = openOutputFile(path, &errorMessage);
+  if (!output)
+    return failure();
+  output->os() << contents;
+  output->keep();
+  return success();
+}
+
 namespace {
 
 /// A Verilog emitter that separates modules into individual output files.
 struct SplitEmitter : public RootEmitterBase {
-  explicit SplitEmitter(StringRef dirname, ModuleOp rootOp)
-      : RootEmitterBase(rootOp), dirname(dirname) {}
+  explicit SplitEmitter(StringRef dirname, ModuleOp rootOp,
+                        const llvm::StringSet<> *reusedModules)
+      : RootEmitterBase(rootOp), dirname(dirname),
+        reusedModules(reusedModules) {}
 
   /// A list of modules and their position within the per-file operations.
   struct EmittedModule {
     Operation *op;
     size_t position;
     SmallString<32> filename;
+    std::vector<std::string> sourceMap;
+    /// Whether the file was kept from an earlier run, and is only listed.
+    bool reused = false;
   };
   SmallVector<EmittedModule, 0> moduleOps;
 
@@ -2884,6 +2951,9 @@ private:
   /// The directory to emit files into.
   StringRef dirname;
 
+  /// The external modules whose files were emitted by an earlier run.
+  const llvm::StringSet<> *reusedModules;
+
   /// A list of per-file operations (e.g., `sv.verbatim` or `sv.ifdef`).
   SmallVector<Operation *, 0> perFileOps;
 
@@ -2906,7 +2976,13 @@ void SplitEmitter::emitMLIRModule() {
         })
         .Case<VerbatimOp, IfDefProceduralOp>(
             [&](auto &) { perFileOps.push_back(&op); })
-        .Case<RTLGeneratorSchemaOp, RTLModuleExternOp>([&](auto &) {})
+        .Case<RTLModuleExternOp>([&](auto extModule) {
+          if (!reusedModules || !reusedModules->count(extModule.getName()))
+            return;
+          moduleOps.push_back({&op, perFileOps.size(), {}});
+          moduleOps.back().reused = true;
+        })
+        .Case<RTLGeneratorSchemaOp>([&](auto &) {})
         .Default([&](auto *) {
           op.emitError("unknown operation");
           encounteredError = true;
@@ -2923,6 +2999,13 @@ void SplitEmitter::emitModule(const LoweringOptions &options,
                               EmittedModule &mod) {
   auto op = mod.op;
 
+  // Files kept from an earlier run are only listed.
+  if (mod.reused) {
+    mod.filename = cast<RTLModuleExternOp>(op).getName();
+    mod.filename.append(".sv");
+    return;
+  }
+
   // Given the operation, determine the file stem name and how to emit it.
   std::function<void(VerilogEmitterState &)> emit;
 
@@ -2945,22 +3028,21 @@ void SplitEmitter::emitModule(const LoweringOptions &options,
   SmallString<128> outputFilename(dirname);
   llvm::sys::path::append(outputFilename, mod.filename);
 
-  // Open the output file.
-  std::string errorMessage;
-  auto output = openOutputFile(outputFilename, &errorMessage);
-  if (!output) {
-    encounteredError = true;
-    llvm::errs() << errorMessage << "\n";
-    return;
-  }
+  // Emit into a buffer first, so the output file is only touched if its
+  // contents changed.
+  std::string contents;
+  llvm::raw_string_ostream os(contents);
 
   // Emit the prolog of per-file operations, the module itself, and the epilog
   // of per-file operations.
-  VerilogEmitterState state(output->os());
+  VerilogEmitterState state(os);
 
   // Copy the global options in to the individual module state.
   state.options = options;
 
+  // Source map IDs are scoped to the module or interface the file is for.
+  state.sourceMapScope = llvm::sys::path::stem(mod.filename);
+
   for (size_t i = 0; i < std::min(mod.position, perFileOps.size()); ++i) {
     ModuleEmitter(state).emitStatement(perFileOps[i]);
   }
@@ -2971,38 +3053,102 @@ void SplitEmitter::emitModule(const LoweringOptions &options,
 
   if (state.encounteredError)
     encounteredError = true;
-  output->keep();
+  mod.sourceMap = std::move(state.sourceMapEntries);
+
+  std::string errorMessage;
+  if (failed(writeFileIfChanged(outputFilename, os.str(), errorMessage))) {
+    encounteredError = true;
+    llvm::errs() << errorMessage << "\n";
+  }
 }
 
 //===----------------------------------------------------------------------===//
 // MLIRModuleEmitter
 //===----------------------------------------------------------------------===//
 
-LogicalResult circt::exportVerilog(ModuleOp module, llvm::raw_ostream &os) {
-  UnifiedEmitter emitter(os, module);
+/// Prepare the rtl.module operations which are not in the form required by the
+/// emitter yet.  The ones already prepared, e.g. by the PrepareForEmission pass
+/// in the pipeline of the caller, are only checked.
+static void prepareModulesForEmission(ModuleOp module) {
+  // The preparation creates SV operations.  The SV dialect may not have been
+  // loaded yet, which can happen if the input IR has no SV operations.
+  auto *context = module.getContext();
+  context->loadDialect<SVDialect>();
+
+  SmallVector<RTLModuleOp, 0> modules(module.getOps<RTLModuleOp>());
+  auto prepare = [](RTLModuleOp rtlModule) {
+    auto &body = *rtlModule.getBodyBlock();
+    if (isPreparedForEmission(body))
+      return;
+    PrepareForEmissionStats stats;
+    prepareRTLModule(body, stats);
+  };
+  if (context->isMultithreadingEnabled())
+    llvm::parallelForEach(modules.begin(), modules.end(), prepare);
+  else
+    llvm::for_each(modules, prepare);
+}
+
+LogicalResult circt::exportVerilog(ModuleOp module, llvm::raw_ostream &os,
+                                   llvm::raw_ostream *sourceMapOS) {
+  prepareModulesForEmission(module);
+  UnifiedEmitter emitter(os, module, sourceMapOS);
   emitter.emitMLIRModule();
   return failure(emitter.encounteredError);
 }
 
-LogicalResult circt::exportSplitVerilog(ModuleOp module, StringRef dirname) {
-  SplitEmitter emitter(dirname, module);
+void circt::buildStreamingExportVerilogPipeline(
+    mlir::OpPassManager &pm, llvm::raw_ostream &os,
+    llvm::raw_ostream *sourceMapOS) {
+  auto emitter =
+      std::make_shared<StreamingEmitter>(os, ModuleOp(), sourceMapOS);
+  pm.addPass(std::make_unique<StartStreamingEmissionPass>(emitter));
+  auto &modulePM = pm.nest<RTLModuleOp>();
+  modulePM.addPass(createPrepareForEmissionPass());
+  modulePM.addPass(std::make_unique<EmitModuleStreamingPass>(emitter));
+  pm.addPass(std::make_unique<FinishStreamingEmissionPass>(emitter));
+}
+
+LogicalResult
+circt::exportSplitVerilog(ModuleOp module, StringRef dirname,
+                          const llvm::StringSet<> *reusedModules) {
+  prepareModulesForEmission(module);
+  SplitEmitter emitter(dirname, module, reusedModules);
   emitter.emitMLIRModule();
 
   // Write the file list.
   SmallString<128> filelistPath(dirname);
   llvm::sys::path::append(filelistPath, "filelist.f");
 
+  std::string filelist;
+  llvm::raw_string_ostream os(filelist);
+  for (auto &mod : emitter.moduleOps) {
+    os << mod.filename << "\n";
+  }
+
   std::string errorMessage;
-  auto output = mlir::openOutputFile(filelistPath, &errorMessage);
-  if (!output) {
+  if (failed(writeFileIfChanged(filelistPath, os.str(), errorMessage))) {
     module->emitError(errorMessage);
     return failure();
   }
 
-  for (auto mod : std::move(emitter.moduleOps)) {
-    output->os() << mod.filename << "\n";
+  // Write the source map table for all files, if requested.
+  if (LoweringOptions(module).emitSourceMapIDs) {
+    SmallString<128> sourceMapPath(dirname);
+    llvm::sys::path::append(sourceMapPath, "sourcemap.txt");
+
+    std::string sourceMap;
+    llvm::raw_string_ostream sourceMapOS(sourceMap);
+    for (auto &mod : emitter.moduleOps)
+      emitSourceMap(sourceMapOS, llvm::sys::path::stem(mod.filename),
+                    mod.sourceMap);
+
+    if (failed(writeFileIfChanged(sourceMapPath, sourceMapOS.str(),
+                                  errorMessage))) {
+      module->emitError(errorMessage);
+      return failure();
+    }
   }
-  output->keep();
 
   return failure(emitter.encounteredError);
 }
@@ -3014,10 +3160,6 @@ void circt::registerToVerilogTranslation() {
   mlir::TranslateFromMLIRRegistration toVerilog(
       "export-verilog",
       [](ModuleOp module, llvm::raw_ostream &os) {
-        // ExportVerilog requires that the SV dialect be loaded in order to
-        // create WireOps. It may not have been  loaded by the MLIR parser,
-        // which can happen if the input IR has no SV operations.
-        module->getContext()->loadDialect<sv::SVDialect>();
         applyLoweringCLOptions(module);
         return exportVerilog(module, os);
       },
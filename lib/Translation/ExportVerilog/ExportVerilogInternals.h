@@ -0,0 +1,69 @@
+//===- ExportVerilogInternals.h - Shared Internal Impl Details --*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Stuff shared between the Verilog emitter and the passes preparing IR for it.
+//
+//===----------------------------------------------------------------------===//
+
+// NOLINTNEXTLINE(llvm-header-guard)
+#ifndef TRANSLATION_EXPORTVERILOG_EXPORTVERILOGINTERNALS_H
+#define TRANSLATION_EXPORTVERILOG_EXPORTVERILOGINTERNALS_H
+
+#include "circt/Dialect/RTL/RTLOps.h"
+#include "circt/Dialect/SV/SVOps.h"
+#include "circt/Support/LLVM.h"
+
+namespace circt {
+
+/// Return true for operations that are always inlined into a containing
+/// expression.
+inline bool isExpressionAlwaysInline(Operation *op) {
+  // We need to emit array indexes inline per verilog "lvalue" semantics.
+  if (isa<sv::ArrayIndexInOutOp>(op))
+    return true;
+
+  // An SV interface modport is a symbolic name that is always inlined.
+  if (isa<sv::GetModportOp>(op) || isa<sv::ReadInterfaceSignalOp>(op))
+    return true;
+
+  return false;
+}
+
+/// Return whether an operation is a constant.
+inline bool isConstantExpression(Operation *op) {
+  return isa<rtl::ConstantOp>(op) || isa<sv::ConstantXOp>(op) ||
+         isa<sv::ConstantZOp>(op);
+}
+
+/// Counts of the rewrites performed by prepareRTLModule.
+struct PrepareForEmissionStats {
+  unsigned numAlwaysInlineOpsMoved = 0;
+  unsigned numMergeOpsLowered = 0;
+  unsigned numVariadicOpsLowered = 0;
+  unsigned numTemporaryWires = 0;
+
+  /// Return true if any rewrite was performed.
+  bool changedIR() const {
+    return numAlwaysInlineOpsMoved || numMergeOpsLowered ||
+           numVariadicOpsLowered || numTemporaryWires;
+  }
+};
+
+/// For each module we emit, do a prepass over the structure, pre-lowering and
+/// otherwise rewriting operations we don't want to emit.  This makes no
+/// changes to a block it has already been run on.
+void prepareRTLModule(Block &block, PrepareForEmissionStats &stats);
+
+/// Return true if the block, and the blocks nested in it, are already in the
+/// form produced by prepareRTLModule, e.g. because the PrepareForEmission pass
+/// ran on the module as part of the caller's pipeline.
+bool isPreparedForEmission(Block &block);
+
+} // namespace circt
+
+#endif // TRANSLATION_EXPORTVERILOG_EXPORTVERILOGINTERNALS_H
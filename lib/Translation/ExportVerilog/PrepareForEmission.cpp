@@ -0,0 +1,326 @@
+//===- PrepareForEmission.cpp - IR Prepass for Emitter --------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the "prepare" pass that walks the IR before the emitter
+// gets involved.  This allows us to do some transformations that would be
+// awkward to implement inline in the emitter.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ExportVerilogInternals.h"
+#include "circt/Dialect/Comb/CombOps.h"
+#include "circt/Dialect/SV/SVDialect.h"
+#include "circt/Support/ImplicitLocOpBuilder.h"
+#include "circt/Translation/Passes.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+
+using namespace circt;
+
+using namespace comb;
+using namespace rtl;
+using namespace sv;
+
+namespace circt {
+#define GEN_PASS_CLASSES
+#include "circt/Translation/Passes.h.inc"
+} // namespace circt
+
+//===----------------------------------------------------------------------===//
+// Module Preparation
+//===----------------------------------------------------------------------===//
+
+// Given a side effect free "always inline" operation, make sure that it exists
+// in the same block as its users and that it has one use for each one.  Return
+// true if the IR was changed.
+static bool lowerAlwaysInlineOperation(Operation *op) {
+  assert(op->getNumResults() == 1 &&
+         "only support 'always inline' ops with one result");
+
+  // Nuke use-less operations.
+  if (op->use_empty()) {
+    op->erase();
+    return true;
+  }
+
+  // Moving/cloning an op should pull along its operand tree with it if they are
+  // always inline.  This happens when an array index has a constant operand for
+  // example.
+  auto recursivelyHandleOperands = [](Operation *op) {
+    for (auto operand : op->getOperands()) {
+      if (auto *operandOp = operand.getDefiningOp())
+        if (isExpressionAlwaysInline(operandOp))
+          lowerAlwaysInlineOperation(operandOp);
+    }
+  };
+
+  // If this operation has multiple uses, duplicate it into N-1 of them in turn.
+  bool changed = false;
+  while (!op->hasOneUse()) {
+    changed = true;
+    OpOperand &use = *op->getUses().begin();
+    Operation *user = use.getOwner();
+
+    // Clone the op before the user.
+    auto *newOp = op->clone();
+    user->getBlock()->getOperations().insert(Block::iterator(user), newOp);
+    // Change the user to use the new op.
+    use.set(newOp->getResult(0));
+
+    // If any of the operations of the moved op are always inline, recursively
+    // handle them too.
+    recursivelyHandleOperands(newOp);
+  }
+
+  // Finally, ensures the op is in the same block as its user so it can be
+  // inlined.
+  Operation *user = *op->getUsers().begin();
+  if (op->getBlock() != user->getBlock()) {
+    op->moveBefore(user);
+    changed = true;
+
+    // If any of the operations of the moved op are always inline, recursively
+    // move/clone them too.
+    recursivelyHandleOperands(op);
+  }
+  return changed;
+}
+
+/// We lower the Merge operation to a wire at the top level along with connects
+/// to it and a ReadInOut.
+static Value lowerMergeOp(MergeOp merge) {
+  auto module = merge->getParentOfType<RTLModuleOp>();
+  assert(module && "merges should only be in a module");
+
+  // Start with the wire at the top level.
+  ImplicitLocOpBuilder b(merge.getLoc(), &module.getBodyBlock()->front());
+  auto wire = b.create<WireOp>(merge.getType());
+
+  // Each of the operands is a connect or passign into the wire.
+  b.setInsertionPoint(merge);
+  if (merge->getParentOp()->hasTrait<sv::ProceduralRegion>()) {
+    for (auto op : merge.getOperands())
+      b.create<PAssignOp>(wire, op);
+  } else {
+    for (auto op : merge.getOperands())
+      b.create<ConnectOp>(wire, op);
+  }
+
+  return b.create<ReadInOutOp>(wire);
+}
+
+/// Lower a commutative operation into an expression tree.  This enables
+/// long-line splitting to work with them.
+static Value lowerVariadicCommutativeOp(Operation &op, OperandRange operands) {
+  Value lhs, rhs;
+  switch (operands.size()) {
+  case 0:
+    assert(0 && "cannot be called with empty operand range");
+    break;
+  case 1:
+    return operands[0];
+  case 2:
+    lhs = operands[0];
+    rhs = operands[1];
+    break;
+  default:
+    auto firstHalf = operands.size() / 2;
+    lhs = lowerVariadicCommutativeOp(op, operands.take_front(firstHalf));
+    rhs = lowerVariadicCommutativeOp(op, operands.drop_front(firstHalf));
+    break;
+  }
+
+  OperationState state(op.getLoc(), op.getName());
+  // state.addOperands(ValueRange{lhs, rhs});
+  state.addOperands(lhs);
+  state.addOperands(rhs);
+  state.addTypes(op.getResult(0).getType());
+  auto *newOp = Operation::create(state);
+  op.getBlock()->getOperations().insert(Block::iterator(&op), newOp);
+  return newOp->getResult(0);
+}
+
+/// Return true if the operation is a commutative variadic operation with more
+/// than two operands, which is lowered into a balanced operand tree so that
+/// long lines can be split across multiple statements.
+static bool isVariadicCommutativeOp(Operation &op) {
+  return op.getNumOperands() > 2 && op.getNumResults() == 1 &&
+         op.hasTrait<mlir::OpTrait::IsCommutative>() &&
+         mlir::MemoryEffectOpInterface::hasNoEffect(&op) &&
+         op.getNumRegions() == 0 && op.getNumSuccessors() == 0 &&
+         op.getAttrs().empty();
+}
+
+/// Return the ancestor of the operation in the specified block.
+static Operation *getAncestorInBlock(Block &block, Operation *op) {
+  while (&block != &op->getParentRegion()->front())
+    op = op->getParentOp();
+  return op;
+}
+
+/// When we find that an operation is used before it is defined in a graph
+/// region, we emit an explicit wire to resolve the issue.
+static void lowerUsersToTemporaryWire(Operation &op) {
+  Block *block = op.getBlock();
+  auto builder = ImplicitLocOpBuilder::atBlockBegin(op.getLoc(), block);
+
+  for (auto result : op.getResults()) {
+    auto newWire = builder.create<WireOp>(result.getType());
+
+    while (!result.use_empty()) {
+      auto newWireRead = builder.create<ReadInOutOp>(newWire);
+      OpOperand &use = *result.getUses().begin();
+      use.set(newWireRead);
+      newWireRead->moveBefore(use.getOwner());
+    }
+
+    auto connect = builder.create<ConnectOp>(newWire, result);
+    connect->moveAfter(&op);
+  }
+}
+
+/// For each module we emit, do a prepass over the structure, pre-lowering and
+/// otherwise rewriting operations we don't want to emit.
+void circt::prepareRTLModule(Block &block, PrepareForEmissionStats &stats) {
+  for (auto &op : llvm::make_early_inc_range(block)) {
+    // If the operations has regions, lower each of the regions.
+    for (auto &region : op.getRegions()) {
+      if (!region.empty())
+        prepareRTLModule(region.front(), stats);
+    }
+
+    // Duplicate "always inline" expression for each of their users and move
+    // them to be next to their users.
+    if (isExpressionAlwaysInline(&op)) {
+      if (lowerAlwaysInlineOperation(&op))
+        ++stats.numAlwaysInlineOpsMoved;
+      continue;
+    }
+
+    // Lower 'merge' operations to wires and connects.
+    if (auto merge = dyn_cast<MergeOp>(op)) {
+      auto result = lowerMergeOp(merge);
+      op.getResult(0).replaceAllUsesWith(result);
+      op.erase();
+      ++stats.numMergeOpsLowered;
+      continue;
+    }
+
+    // Lower commutative variadic operations with more than two operands into
+    // balanced operand trees so we can split long lines across multiple
+    // statements.
+    if (isVariadicCommutativeOp(op)) {
+      // Lower this operation to a balanced binary tree of the same operation.
+      auto result = lowerVariadicCommutativeOp(op, op.getOperands());
+      op.getResult(0).replaceAllUsesWith(result);
+      op.erase();
+      ++stats.numVariadicOpsLowered;
+      continue;
+    }
+  }
+
+  // Now that all the basic ops are settled, check for any use-before def issues
+  // in graph regions.  Lower these into explicit wires to keep the emitter
+  // simple.
+  if (!block.getParentOp()->hasTrait<ProceduralRegion>()) {
+    SmallPtrSet<Operation *, 32> seenOperations;
+
+    for (auto &op : llvm::make_early_inc_range(block)) {
+      // Check the users of any expressions to see if they are
+      // lexically below the operation itself.  If so, it is being used out
+      // of order.
+      bool haveAnyOutOfOrderUses = false;
+      for (auto *userOp : op.getUsers()) {
+        // If the user is in a suboperation like an always block, then zip up
+        // to the operation that uses it.
+        if (seenOperations.count(getAncestorInBlock(block, userOp))) {
+          haveAnyOutOfOrderUses = true;
+          break;
+        }
+      }
+
+      // Remember that we've seen this operation.
+      seenOperations.insert(&op);
+
+      // If all the uses of the operation are below this, then we're ok.
+      if (!haveAnyOutOfOrderUses)
+        continue;
+
+      // If this is a reg/wire declaration, then we move it to the top of the
+      // block.  We can't abstract the inout result.
+      if (op.getNumResults() == 1 &&
+          op.getResult(0).getType().isa<InOutType>() &&
+          op.getNumOperands() == 0) {
+        op.moveBefore(&block.front());
+        continue;
+      }
+
+      // If this is a constant, then we move it to the top of the block.
+      if (isConstantExpression(&op)) {
+        op.moveBefore(&block.front());
+        continue;
+      }
+
+      // Otherwise, we need to lower this to a wire to resolve this.
+      lowerUsersToTemporaryWire(op);
+      stats.numTemporaryWires += op.getNumResults();
+    }
+  }
+}
+
+bool circt::isPreparedForEmission(Block &block) {
+  bool isGraphRegion = !block.getParentOp()->hasTrait<ProceduralRegion>();
+  SmallPtrSet<Operation *, 32> seenOperations;
+
+  for (auto &op : block) {
+    for (auto &region : op.getRegions()) {
+      if (!region.empty() && !isPreparedForEmission(region.front()))
+        return false;
+    }
+
+    if (isExpressionAlwaysInline(&op) &&
+        (!op.hasOneUse() || op.getBlock() != (*op.user_begin())->getBlock()))
+      return false;
+    if (isa<MergeOp>(op) || isVariadicCommutativeOp(op))
+      return false;
+
+    if (isGraphRegion) {
+      for (auto *userOp : op.getUsers())
+        if (seenOperations.count(getAncestorInBlock(block, userOp)))
+          return false;
+      seenOperations.insert(&op);
+    }
+  }
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Pass Infrastructure
+//===----------------------------------------------------------------------===//
+
+namespace {
+struct PrepareForEmissionPass
+    : public PrepareForEmissionBase<PrepareForEmissionPass> {
+  void runOnOperation() override {
+    PrepareForEmissionStats stats;
+    prepareRTLModule(*getOperation().getBodyBlock(), stats);
+
+    numAlwaysInlineOpsMoved += stats.numAlwaysInlineOpsMoved;
+    numMergeOpsLowered += stats.numMergeOpsLowered;
+    numVariadicOpsLowered += stats.numVariadicOpsLowered;
+    numTemporaryWires += stats.numTemporaryWires;
+
+    if (!stats.changedIR())
+      markAllAnalysesPreserved();
+  }
+};
+} // end anonymous namespace
+
+std::unique_ptr<mlir::Pass> circt::createPrepareForEmissionPass() {
+  return std::make_unique<PrepareForEmissionPass>();
+}
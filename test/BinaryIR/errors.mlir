@@ -0,0 +1,12 @@
+// RUN: not circt-translate -import-circt-binary %s 2>&1 | FileCheck %s --check-prefix=HEADER
+// RUN: circt-translate -export-circt-binary %s -o %t.bin
+// RUN: head -c 48 %t.bin > %t.truncated.bin
+// RUN: not circt-translate -import-circt-binary %t.truncated.bin 2>&1 | FileCheck %s --check-prefix=TRUNCATED
+
+// HEADER: malformed binary IR at offset 0: missing binary IR header
+// TRUNCATED: malformed binary IR at offset
+
+rtl.module @Top(%in: i4) -> (%out: i4) {
+  %0 = comb.xor %in, %in : i4
+  rtl.output %0 : i4
+}
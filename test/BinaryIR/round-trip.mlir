@@ -0,0 +1,42 @@
+// RUN: circt-opt %s -mlir-print-debuginfo > %t.expected.mlir
+// RUN: circt-translate -export-circt-binary %s -o %t.bin
+// RUN: circt-translate -import-circt-binary %t.bin -mlir-print-debuginfo > %t.actual.mlir
+// RUN: diff %t.expected.mlir %t.actual.mlir
+// RUN: circt-translate -import-circt-binary %t.bin -mlir-print-debuginfo | FileCheck %s
+
+// CHECK-LABEL: rtl.module.extern @Child
+rtl.module.extern @Child(%a: i4) -> (%b: i4)
+
+// Values may be used before they are defined in graph regions.
+// CHECK-LABEL: rtl.module @Top
+// CHECK-NEXT:    %0 = comb.xor %1, %in
+// CHECK-NEXT:    %1 = comb.and %0, %in
+rtl.module @Top(%clock: i1, %in: i4) -> (%out: i4, %flag: i1) {
+  %0 = comb.xor %1, %in : i4 loc("Top.fir":3:7)
+  %1 = comb.and %0, %in : i4 loc("name"("Top.fir":4:9))
+  %b = rtl.instance "child" @Child(%1) {parameters = {WIDTH = 4 : i32, NAME = "x\0A"}} : (i4) -> i4 loc(fused["Top.fir":5:1, "Child.fir":1:1])
+  %c3 = rtl.constant 3 : i4 loc(callsite("Top.fir":6:1 at "Top.fir":7:1))
+  %eq = comb.icmp eq %b, %c3 : i4 loc(unknown)
+  %reg = sv.reg : !rtl.inout<i4>
+  // CHECK: sv.always posedge %clock {
+  // CHECK-NEXT: sv.ifdef.procedural "SYNTHESIS" {
+  // CHECK-NEXT: } else {
+  // CHECK-NEXT: sv.passign %reg, %b
+  sv.always posedge %clock {
+    sv.ifdef.procedural "SYNTHESIS" {
+    } else {
+      sv.passign %reg, %b : i4
+    }
+  }
+  %read = sv.read_inout %reg : !rtl.inout<i4>
+  rtl.output %read, %eq : i4, i1
+}
+
+// CHECK-LABEL: firrtl.circuit "Circuit"
+firrtl.circuit "Circuit" {
+  // CHECK: firrtl.module @Circuit
+  firrtl.module @Circuit(%in: !firrtl.bundle<a: uint<1>, b: flip<sint<4>>>, %out: !firrtl.flip<uint<1>>) {
+    %0 = firrtl.subfield %in("a") : (!firrtl.bundle<a: uint<1>, b: flip<sint<4>>>) -> !firrtl.uint<1>
+    firrtl.connect %out, %0 : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+  }
+}
@@ -11,7 +11,9 @@
  */
 
 #include "mlir-c/IR.h"
+#include "circt-c/Dialect/Comb.h"
 #include "circt-c/Dialect/RTL.h"
+#include "circt-c/Transforms.h"
 #include "mlir-c/AffineExpr.h"
 #include "mlir-c/AffineMap.h"
 #include "mlir-c/BuiltinTypes.h"
@@ -90,6 +92,58 @@ int testRTLTypes() {
   return 0;
 }
 
+static void countChangedOp(MlirOperation op, void *userData) {
+  ++*(int *)userData;
+}
+
+int testIncrementalSimplifier() {
+  MlirContext ctx = mlirContextCreate();
+  mlirDialectHandleLoadDialect(mlirGetDialectHandle__comb__(), ctx);
+  mlirDialectHandleLoadDialect(mlirGetDialectHandle__rtl__(), ctx);
+
+  MlirModule module = mlirModuleCreateParse(
+      ctx, mlirStringRefCreateFromCString(
+               "rtl.module @top(%a: i8, %b: i8) -> (%x: i8) {\n"
+               "  %c-1_i8 = rtl.constant -1 : i8\n"
+               "  %0 = comb.and %a, %c-1_i8 : i8\n"
+               "  %1 = comb.or %0, %b : i8\n"
+               "  rtl.output %1 : i8\n"
+               "}\n"));
+  if (mlirModuleIsNull(module))
+    return 1;
+
+  MlirOperation top = mlirBlockGetFirstOperation(mlirModuleGetBody(module));
+  MlirBlock body = mlirRegionGetFirstBlock(mlirOperationGetRegion(top, 0));
+  MlirOperation andOp =
+      mlirOperationGetNextInBlock(mlirBlockGetFirstOperation(body));
+
+  // The comb.and folds away along with the constant it used, and the comb.or
+  // which used it is modified.
+  MlirIncrementalSimplifier simplifier = mlirIncrementalSimplifierCreate(ctx);
+  int numChanged = 0;
+  intptr_t numErased = mlirIncrementalSimplifierRun(
+      simplifier, 1, &andOp, countChangedOp, &numChanged);
+  if (numErased != 2)
+    return 2;
+  if (numChanged != 1)
+    return 3;
+
+  // Running again finds nothing else to do.
+  MlirOperation orOp =
+      mlirOperationGetNextInBlock(mlirBlockGetFirstOperation(body));
+  numChanged = 0;
+  numErased = mlirIncrementalSimplifierRun(simplifier, 1, &orOp,
+                                           countChangedOp, &numChanged);
+  if (numErased != 0 || numChanged != 0)
+    return 4;
+
+  mlirIncrementalSimplifierDestroy(simplifier);
+  mlirModuleDestroy(module);
+  mlirContextDestroy(ctx);
+
+  return 0;
+}
+
 int main() {
   fprintf(stderr, "@registration\n");
   int errcode = registerOnlyRTL();
@@ -99,11 +153,17 @@ int main() {
   errcode = testRTLTypes();
   fprintf(stderr, "%d\n", errcode);
 
+  fprintf(stderr, "@incrementalsimplifier\n");
+  errcode = testIncrementalSimplifier();
+  fprintf(stderr, "%d\n", errcode);
+
   // clang-format off
   // CHECK-LABEL: @registration
   // CHECK: 0
   // CHECK-LABEL: @rtltypes
   // CHECK: 0
+  // CHECK-LABEL: @incrementalsimplifier
+  // CHECK: 0
   // clang-format on
 
   return 0;
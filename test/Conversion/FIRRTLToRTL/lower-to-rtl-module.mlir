@@ -51,12 +51,13 @@ firrtl.circuit "Simple" {
   firrtl.module @TestInstance(%u2: !firrtl.uint<2>, %s8: !firrtl.sint<8>,
                               %clock: !firrtl.clock,
                               %reset: !firrtl.uint<1>) {
+    // Inputs driven by values defined before the instance are used directly.
     // CHECK-NEXT: %c0_i2 = rtl.constant
-    // CHECK-NEXT: %xyz.out4 = rtl.instance "xyz" @Simple([[ARG1:%.+]], %u2, %s8) : (i4, i2, i8) -> i4
+    // CHECK-NEXT: [[ARG1:%.+]] = comb.concat %c0_i2, %u2 : (i2, i2) -> i4
+    // CHECK-NEXT: %xyz.out4 = rtl.instance "xyz" @Simple([[ARG1]], %u2, %s8) : (i4, i2, i8) -> i4
     %xyz:4 = firrtl.instance @Simple {name = "xyz", portNames=["in1", "in2", "in3", "out4"]}
      : !firrtl.flip<uint<4>>, !firrtl.flip<uint<2>>, !firrtl.flip<sint<8>>, !firrtl.uint<4>
 
-    // CHECK: [[ARG1]] = comb.concat %c0_i2, %u2 : (i2, i2) -> i4
     firrtl.connect %xyz#0, %u2 : !firrtl.flip<uint<4>>, !firrtl.uint<2>
 
     // CHECK-NOT: rtl.connect
@@ -349,13 +349,12 @@ firrtl.circuit "Simple" {
   firrtl.module @foo() {
     // CHECK-NEXT:  %io_cpu_flush.wire = sv.wire : !rtl.inout<i1>
     %io_cpu_flush.wire = firrtl.wire : !firrtl.uint<1>
-    // CHECK-NEXT: rtl.instance "fetch" @bar([[IO:%[0-9]+]])
+    // CHECK-NEXT:  [[IO:%.+]] = sv.read_inout %io_cpu_flush.wire
+    // CHECK-NEXT: rtl.instance "fetch" @bar([[IO]])
     %i = firrtl.instance @bar {name = "fetch", portNames=["io_cpu_flush"]} : !firrtl.flip<uint<1>>
     firrtl.connect %i, %io_cpu_flush.wire : !firrtl.flip<uint<1>>, !firrtl.uint<1>
 
     %hits_1_7 = firrtl.node %io_cpu_flush.wire {name = "hits_1_7"} : !firrtl.uint<1>
-    // CHECK-NEXT:  [[IO]] = sv.read_inout %io_cpu_flush.wire
-    // CHECK-NEXT:  [[IO:%.+]] = sv.read_inout %io_cpu_flush.wire
     // CHECK-NEXT:  %hits_1_7 = sv.wire : !rtl.inout<i1>
     // CHECK-NEXT:  sv.connect %hits_1_7, [[IO]] : i1
     %1455 = firrtl.asPassive %hits_1_7 : !firrtl.uint<1>
@@ -526,8 +525,7 @@ firrtl.circuit "Simple" {
     firrtl.connect %reg, %5 : !firrtl.uint<32>, !firrtl.uint<32>
     firrtl.connect %io_q, %reg: !firrtl.flip<uint<32>>, !firrtl.uint<32>
 
-    // CHECK-NEXT: %7 = sv.read_inout %reg : !rtl.inout<i32>
-    // CHECK-NEXT: rtl.output %7 : i32
+    // CHECK-NEXT: rtl.output %0 : i32
   }
 
   //  module MemSimple :
@@ -721,4 +719,36 @@ firrtl.circuit "Simple" {
     firrtl.connect %3, %en : !firrtl.uint<1>, !firrtl.uint<1>
 }
 
+  // Constants and module level reads are created once per module, and an
+  // instance input driven by a lowered value needs no temporary wire.
+  // CHECK-LABEL: rtl.module @Pooling
+  firrtl.module @Pooling(%a: !firrtl.uint<4>, %b: !firrtl.uint<4>,
+                         %c: !firrtl.uint<1>, %x: !firrtl.flip<uint<5>>,
+                         %y: !firrtl.flip<uint<4>>) {
+    // CHECK-NEXT: %false = rtl.constant false
+    // CHECK-NOT: rtl.constant
+    // CHECK: %w = sv.wire
+    %w = firrtl.wire : !firrtl.uint<4>
+    firrtl.connect %w, %a : !firrtl.uint<4>, !firrtl.uint<4>
+
+    // CHECK-NOT: sv.wire
+    // CHECK: [[W:%.+]] = sv.read_inout %w
+    // CHECK-NOT: sv.read_inout
+    // CHECK: [[WEXT:%.+]] = comb.concat %false, [[W]] : (i1, i4) -> i5
+    // CHECK-NOT: rtl.constant
+    // CHECK: [[BEXT:%.+]] = comb.concat %false, %b : (i1, i4) -> i5
+    // CHECK-NEXT: [[ADD:%.+]] = comb.add [[WEXT]], [[BEXT]] : i5
+    %0 = firrtl.add %w, %b : (!firrtl.uint<4>, !firrtl.uint<4>) -> !firrtl.uint<5>
+    firrtl.connect %x, %0 : !firrtl.flip<uint<5>>, !firrtl.uint<5>
+
+    // CHECK-NEXT: rtl.instance "inst" @bar(%c) : (i1) -> ()
+    %i = firrtl.instance @bar {name = "inst", portNames = ["io_cpu_flush"]} : !firrtl.flip<uint<1>>
+    firrtl.connect %i, %c : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+    firrtl.connect %y, %w : !firrtl.flip<uint<4>>, !firrtl.uint<4>
+
+    // CHECK-NOT: sv.wire
+    // CHECK-NOT: sv.read_inout
+    // CHECK-NEXT: rtl.output [[ADD]], [[W]] : i5, i4
+  }
+
 }
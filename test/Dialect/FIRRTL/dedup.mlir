@@ -0,0 +1,82 @@
+// RUN: circt-opt -pass-pipeline='firrtl.circuit(firrtl-dedup)' %s | FileCheck %s
+
+// Modules which only differ in the names of their operations are merged.
+// CHECK-LABEL: firrtl.circuit "Simple"
+firrtl.circuit "Simple" {
+  // CHECK: firrtl.module @A
+  firrtl.module @A(%in: !firrtl.uint<1>, %out: !firrtl.flip<uint<1>>) {
+    %a = firrtl.wire : !firrtl.uint<1>
+    firrtl.connect %a, %in : !firrtl.uint<1>, !firrtl.uint<1>
+    firrtl.connect %out, %a : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+  }
+  // CHECK-NOT: firrtl.module @B
+  firrtl.module @B(%in: !firrtl.uint<1>, %out: !firrtl.flip<uint<1>>) {
+    %b = firrtl.wire : !firrtl.uint<1>
+    firrtl.connect %b, %in : !firrtl.uint<1>, !firrtl.uint<1>
+    firrtl.connect %out, %b : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+  }
+  // CHECK: firrtl.module @Simple
+  firrtl.module @Simple() {
+    // CHECK-NEXT: firrtl.instance @A {name = "a"}
+    // CHECK-NEXT: firrtl.instance @A {name = "b"}
+    %a_in, %a_out = firrtl.instance @A {name = "a"} : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+    %b_in, %b_out = firrtl.instance @B {name = "b"} : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+  }
+}
+
+// Modules which differ in structure, or in their port names, are not merged.
+// CHECK-LABEL: firrtl.circuit "Different"
+firrtl.circuit "Different" {
+  // CHECK: firrtl.module @A
+  firrtl.module @A(%in: !firrtl.uint<1>, %out: !firrtl.flip<uint<1>>) {
+    firrtl.connect %out, %in : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+  }
+  // CHECK: firrtl.module @B
+  firrtl.module @B(%in: !firrtl.uint<1>, %out: !firrtl.flip<uint<1>>) {
+    %0 = firrtl.not %in : (!firrtl.uint<1>) -> !firrtl.uint<1>
+    firrtl.connect %out, %0 : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+  }
+  // CHECK: firrtl.module @C
+  firrtl.module @C(%x: !firrtl.uint<1>, %y: !firrtl.flip<uint<1>>) {
+    firrtl.connect %y, %x : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+  }
+  // CHECK: firrtl.module @Different
+  firrtl.module @Different() {
+    // CHECK-NEXT: firrtl.instance @A {name = "a"}
+    // CHECK-NEXT: firrtl.instance @B {name = "b"}
+    // CHECK-NEXT: firrtl.instance @C {name = "c"}
+    %a_in, %a_out = firrtl.instance @A {name = "a"} : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+    %b_in, %b_out = firrtl.instance @B {name = "b"} : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+    %c_x, %c_y = firrtl.instance @C {name = "c"} : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+  }
+}
+
+// Modules become equivalent once their children have been merged, and the
+// annotations of merged modules are combined.
+// CHECK-LABEL: firrtl.circuit "Hierarchy"
+firrtl.circuit "Hierarchy" {
+  // CHECK: firrtl.module @Leaf0() attributes {annotations = [{a = "a"}, {b = "b"}]}
+  firrtl.module @Leaf0() attributes {annotations = [{a = "a"}]} {
+    %w = firrtl.wire : !firrtl.uint<1>
+  }
+  // CHECK-NOT: firrtl.module @Leaf1
+  firrtl.module @Leaf1() attributes {annotations = [{b = "b"}]} {
+    %v = firrtl.wire : !firrtl.uint<1>
+  }
+  // CHECK: firrtl.module @Mid0
+  // CHECK-NEXT: firrtl.instance @Leaf0 {name = "leaf"}
+  firrtl.module @Mid0() {
+    firrtl.instance @Leaf0 {name = "leaf"}
+  }
+  // CHECK-NOT: firrtl.module @Mid1
+  firrtl.module @Mid1() {
+    firrtl.instance @Leaf1 {name = "leaf"}
+  }
+  // CHECK: firrtl.module @Hierarchy
+  firrtl.module @Hierarchy() {
+    // CHECK-NEXT: firrtl.instance @Mid0 {name = "mid0"}
+    // CHECK-NEXT: firrtl.instance @Mid0 {name = "mid1"}
+    firrtl.instance @Mid0 {name = "mid0"}
+    firrtl.instance @Mid1 {name = "mid1"}
+  }
+}
@@ -479,3 +479,12 @@ firrtl.circuit "MemoryPortsWithDifferentTypes" {
     %memory_r0, %memory_r1 = firrtl.mem Undefined {depth = 16 : i64, name = "memory", portNames = ["r0", "r1"], readLatency = 0 : i32, writeLatency = 1 : i32} : !firrtl.flip<bundle<addr: uint<4>, en: uint<1>, clk: clock, data: flip<uint<8>>>>, !firrtl.flip<bundle<addr: uint<4>, en: uint<1>, clk: clock, data: flip<sint<8>>>>
   }
 }
+
+// -----
+
+firrtl.circuit "SubindexOfEmptyVector" {
+  firrtl.module @SubindexOfEmptyVector(%a: !firrtl.vector<uint<1>, 0>) {
+    // expected-error @+1 {{out of range index '0' in vector type '!firrtl.vector<uint<1>, 0>'}}
+    %0 = firrtl.subindex %a[0] : !firrtl.vector<uint<1>, 0>
+  }
+}
@@ -53,3 +53,60 @@ firrtl.circuit "Test" {
   }
 }
 
+
+// The modules are solved in parallel rounds.  Check that constants still flow
+// through several levels of the hierarchy, including into instances of a
+// module which is only found to execute after that module has been solved.
+firrtl.circuit "Hierarchy" {
+  // CHECK-LABEL: @Const
+  firrtl.module @Const(%out: !firrtl.flip<uint<1>>) {
+    %c1_ui1 = firrtl.constant(1 : ui1) : !firrtl.uint<1>
+    firrtl.connect %out, %c1_ui1 : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+  }
+
+  // CHECK-LABEL: @Mid
+  firrtl.module @Mid(%out: !firrtl.flip<uint<1>>) {
+    %c_out = firrtl.instance @Const {name = "c", portNames = ["out"]} : !firrtl.uint<1>
+    // CHECK: firrtl.connect %out, %c1_ui1{{(_[0-9]+)?}} :
+    firrtl.connect %out, %c_out : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+  }
+
+  // CHECK-LABEL: @Wrap
+  firrtl.module @Wrap(%out: !firrtl.flip<uint<1>>) {
+    %m_out = firrtl.instance @Mid {name = "m", portNames = ["out"]} : !firrtl.uint<1>
+    // CHECK: firrtl.connect %out, %c1_ui1{{(_[0-9]+)?}} :
+    firrtl.connect %out, %m_out : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+  }
+
+  // CHECK-LABEL: @Hierarchy
+  firrtl.module @Hierarchy(%result1: !firrtl.flip<uint<1>>,
+                           %result2: !firrtl.flip<uint<1>>) {
+    %c_out = firrtl.instance @Const {name = "c", portNames = ["out"]} : !firrtl.uint<1>
+    %w_out = firrtl.instance @Wrap {name = "w", portNames = ["out"]} : !firrtl.uint<1>
+    // CHECK: firrtl.connect %result1, %c1_ui1{{(_[0-9]+)?}} :
+    firrtl.connect %result1, %c_out : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+    // CHECK: firrtl.connect %result2, %c1_ui1{{(_[0-9]+)?}} :
+    firrtl.connect %result2, %w_out : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+  }
+}
+
+// With an external main module, every module may be instantiated outside of
+// the circuit, so all of their ports are overdefined.  The results of the
+// instances within the circuit still only take the values connected to the
+// ports of the instantiated module.
+firrtl.circuit "ExtMain" {
+  firrtl.extmodule @ExtMain(%in: !firrtl.uint<1>)
+
+  // CHECK-LABEL: @ExtUser
+  firrtl.module @ExtUser(%result: !firrtl.flip<uint<1>>) {
+    %c_out = firrtl.instance @ExtConst {name = "c", portNames = ["out"]} : !firrtl.uint<1>
+    // CHECK: firrtl.connect %result, %c1_ui1{{(_[0-9]+)?}} :
+    firrtl.connect %result, %c_out : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+  }
+
+  // CHECK-LABEL: @ExtConst
+  firrtl.module @ExtConst(%out: !firrtl.flip<uint<1>>) {
+    %c1_ui1 = firrtl.constant(1 : ui1) : !firrtl.uint<1>
+    firrtl.connect %out, %c1_ui1 : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+  }
+}
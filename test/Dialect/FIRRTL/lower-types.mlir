@@ -768,3 +768,38 @@ firrtl.circuit "WireSemantics"  {
     // CHECK: firrtl.connect %d_a_a, %dx_a_a
   }
 }
+
+// -----
+
+// COM: Test chains of subfield and subindex accesses, which are lowered to a
+// COM: range of the flattened fields of their input.
+firrtl.circuit "AccessChains" {
+  // CHECK-LABEL: firrtl.module @AccessChains(%in_0_a: !firrtl.uint<1>, %in_0_b_0: !firrtl.uint<2>, %in_0_b_1: !firrtl.uint<2>, %in_1_a: !firrtl.uint<1>, %in_1_b_0: !firrtl.uint<2>, %in_1_b_1: !firrtl.uint<2>, %out_a: !firrtl.flip<uint<1>>, %out_b: !firrtl.flip<uint<2>>, %out_c_0: !firrtl.flip<uint<2>>, %out_c_1: !firrtl.flip<uint<2>>)
+  firrtl.module @AccessChains(%in: !firrtl.vector<bundle<a: uint<1>, b: vector<uint<2>, 2>>, 2>,
+                              %out: !firrtl.flip<bundle<a: uint<1>, b: uint<2>, c: vector<uint<2>, 2>>>) {
+    %w = firrtl.wire : !firrtl.vector<bundle<a: uint<1>, b: vector<uint<2>, 2>>, 2>
+    firrtl.connect %w, %in : !firrtl.vector<bundle<a: uint<1>, b: vector<uint<2>, 2>>, 2>, !firrtl.vector<bundle<a: uint<1>, b: vector<uint<2>, 2>>, 2>
+
+    // COM: out.a <= w[1].a
+    // CHECK: firrtl.connect %out_a, %w_1_a
+    %0 = firrtl.subfield %out("a") : (!firrtl.flip<bundle<a: uint<1>, b: uint<2>, c: vector<uint<2>, 2>>>) -> !firrtl.flip<uint<1>>
+    %1 = firrtl.subindex %w[1] : !firrtl.vector<bundle<a: uint<1>, b: vector<uint<2>, 2>>, 2>
+    %2 = firrtl.subfield %1("a") : (!firrtl.bundle<a: uint<1>, b: vector<uint<2>, 2>>) -> !firrtl.uint<1>
+    firrtl.connect %0, %2 : !firrtl.flip<uint<1>>, !firrtl.uint<1>
+
+    // COM: out.b <= w[1].b[1]
+    // CHECK: firrtl.connect %out_b, %w_1_b_1
+    %3 = firrtl.subfield %out("b") : (!firrtl.flip<bundle<a: uint<1>, b: uint<2>, c: vector<uint<2>, 2>>>) -> !firrtl.flip<uint<2>>
+    %4 = firrtl.subfield %1("b") : (!firrtl.bundle<a: uint<1>, b: vector<uint<2>, 2>>) -> !firrtl.vector<uint<2>, 2>
+    %5 = firrtl.subindex %4[1] : !firrtl.vector<uint<2>, 2>
+    firrtl.connect %3, %5 : !firrtl.flip<uint<2>>, !firrtl.uint<2>
+
+    // COM: out.c <= w[0].b
+    // CHECK: firrtl.connect %out_c_0, %w_0_b_0
+    // CHECK: firrtl.connect %out_c_1, %w_0_b_1
+    %6 = firrtl.subfield %out("c") : (!firrtl.flip<bundle<a: uint<1>, b: uint<2>, c: vector<uint<2>, 2>>>) -> !firrtl.flip<vector<uint<2>, 2>>
+    %7 = firrtl.subindex %w[0] : !firrtl.vector<bundle<a: uint<1>, b: vector<uint<2>, 2>>, 2>
+    %8 = firrtl.subfield %7("b") : (!firrtl.bundle<a: uint<1>, b: vector<uint<2>, 2>>) -> !firrtl.vector<uint<2>, 2>
+    firrtl.connect %6, %8 : !firrtl.flip<vector<uint<2>, 2>>, !firrtl.vector<uint<2>, 2>
+  }
+}
@@ -0,0 +1,36 @@
+// RUN: circt-opt -pass-pipeline='rtl.module(simple-canonicalizer{parallel=true partition-threshold=2})' %s | FileCheck %s
+// RUN: circt-opt -pass-pipeline='rtl.module(simple-canonicalizer{parallel=true partition-threshold=2})' -pass-statistics %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=STATS
+// RUN: circt-opt -pass-pipeline='func(simple-canonicalizer{parallel=true partition-threshold=2})' -pass-statistics %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=SSACFG
+
+// STATS: 2 num-partitions
+
+// COM: Functions have SSACFG regions, which are never split.
+// SSACFG: 0 num-partitions
+
+// The two output cones only share the ports and constants, so they are
+// simplified in separate partitions and their constants merged afterwards.
+
+// CHECK-LABEL: rtl.module @partitions(%arg0: i4, %arg1: i4) -> (i4, i4) {
+// CHECK-DAG:     %c0_i4 = rtl.constant 0 : i4
+// CHECK-DAG:     %c1_i4 = rtl.constant 1 : i4
+// CHECK-DAG:     [[XOR:%.+]] = comb.xor %arg0, %c1_i4 : i4
+// CHECK:         rtl.output [[XOR]], %c0_i4 : i4, i4
+// CHECK-NEXT:  }
+
+rtl.module @partitions(%arg0: i4, %arg1: i4) -> (i4, i4) {
+  %c0_i4 = rtl.constant 0 : i4
+  %c1_i4 = rtl.constant 1 : i4
+  %0 = comb.or %arg0, %c0_i4 : i4
+  %1 = comb.and %arg1, %c1_i4 : i4
+  %2 = comb.xor %0, %c1_i4 : i4
+  %3 = comb.and %1, %c0_i4 : i4
+  rtl.output %2, %3 : i4, i4
+}
+
+func @ssacfg(%arg0: i4, %arg1: i4) -> (i4, i4) {
+  %c0_i4 = rtl.constant 0 : i4
+  %c1_i4 = rtl.constant 1 : i4
+  %0 = comb.or %arg0, %c0_i4 : i4
+  %1 = comb.and %arg1, %c1_i4 : i4
+  return %0, %1 : i4, i4
+}
@@ -1,4 +1,5 @@
 // RUN: circt-opt -simple-canonicalizer %s | FileCheck %s
+// RUN: circt-opt -simple-canonicalizer -rtl-disable-integer-attr-cache %s | FileCheck %s
 
 // CHECK-LABEL: rtl.module @extract_noop(%arg0: i3) -> (i3) {
 // CHECK-NEXT:    rtl.output %arg0
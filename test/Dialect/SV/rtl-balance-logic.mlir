@@ -0,0 +1,72 @@
+// RUN: circt-opt -rtl-balance-logic %s | FileCheck %s
+// RUN: circt-opt -rtl-balance-logic -pass-statistics %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=STATS
+
+// STATS-DAG: 4 num-chains-balanced
+// STATS-DAG: 8 critical-path-before
+// STATS-DAG: 6 critical-path-after
+
+// CHECK-LABEL: rtl.module @and_chain(%arg0: i4, %arg1: i4, %arg2: i4, %arg3: i4) -> (i4) {
+// CHECK-NEXT:    %0 = comb.and %arg0, %arg1 : i4
+// CHECK-NEXT:    %1 = comb.and %arg2, %arg3 : i4
+// CHECK-NEXT:    %2 = comb.and %0, %1 {name = "result"} : i4
+// CHECK-NEXT:    rtl.output %2 : i4
+rtl.module @and_chain(%arg0: i4, %arg1: i4, %arg2: i4, %arg3: i4) -> (i4) {
+  %0 = comb.and %arg0, %arg1 : i4
+  %1 = comb.and %0, %arg2 : i4
+  %2 = comb.and %1, %arg3 {name = "result"} : i4
+  rtl.output %2 : i4
+}
+
+// Inputs which arrive late go through the fewest operations.
+// CHECK-LABEL: rtl.module @late_input(%arg0: i4, %arg1: i4, %arg2: i4, %arg3: i4, %arg4: i4) -> (i4) {
+// CHECK-NEXT:    %0 = comb.add %arg0, %arg1 : i4
+// CHECK-NEXT:    %1 = comb.xor %arg2, %arg3 : i4
+// CHECK-NEXT:    %2 = comb.xor %arg4, %1 : i4
+// CHECK-NEXT:    %3 = comb.xor %2, %0 : i4
+// CHECK-NEXT:    rtl.output %3 : i4
+rtl.module @late_input(%arg0: i4, %arg1: i4, %arg2: i4, %arg3: i4, %arg4: i4) -> (i4) {
+  %0 = comb.add %arg0, %arg1 : i4
+  %1 = comb.xor %0, %arg2 : i4
+  %2 = comb.xor %1, %arg3 : i4
+  %3 = comb.xor %2, %arg4 : i4
+  rtl.output %3 : i4
+}
+
+// Intermediate results with other uses are inputs of the chain.
+// CHECK-LABEL: rtl.module @shared(%arg0: i1, %arg1: i1, %arg2: i1, %arg3: i1) -> (i1, i1) {
+// CHECK-NEXT:    %0 = comb.or %arg0, %arg1 : i1
+// CHECK-NEXT:    %1 = comb.or %arg2, %arg3 : i1
+// CHECK-NEXT:    %2 = comb.or %0, %1 : i1
+// CHECK-NEXT:    rtl.output %2, %0 : i1, i1
+rtl.module @shared(%arg0: i1, %arg1: i1, %arg2: i1, %arg3: i1) -> (i1, i1) {
+  %0 = comb.or %arg0, %arg1 : i1
+  %1 = comb.or %0, %arg2 : i1
+  %2 = comb.or %1, %arg3 : i1
+  rtl.output %2, %0 : i1, i1
+}
+
+// Chains which would not get any faster are left alone.
+// CHECK-LABEL: rtl.module @balanced(%arg0: i4, %arg1: i4, %arg2: i4, %arg3: i4) -> (i4) {
+// CHECK-NEXT:    %0 = comb.and %arg0, %arg1, %arg2, %arg3 : i4
+// CHECK-NEXT:    rtl.output %0 : i4
+rtl.module @balanced(%arg0: i4, %arg1: i4, %arg2: i4, %arg3: i4) -> (i4) {
+  %0 = comb.and %arg0, %arg1, %arg2, %arg3 : i4
+  rtl.output %0 : i4
+}
+
+// Priority mux chains are selected by the or of the conditions of their first
+// half.
+// CHECK-LABEL: rtl.module @mux_chain(%arg0: i1, %arg1: i1, %arg2: i1, %arg3: i1, %arg4: i4, %arg5: i4, %arg6: i4, %arg7: i4, %arg8: i4) -> (i4) {
+// CHECK-NEXT:    %0 = comb.mux %arg0, %arg4, %arg5 : i4
+// CHECK-NEXT:    %1 = comb.mux %arg3, %arg7, %arg8 : i4
+// CHECK-NEXT:    %2 = comb.mux %arg2, %arg6, %1 : i4
+// CHECK-NEXT:    %3 = comb.or %arg0, %arg1 : i1
+// CHECK-NEXT:    %4 = comb.mux %3, %0, %2 {name = "result"} : i4
+// CHECK-NEXT:    rtl.output %4 : i4
+rtl.module @mux_chain(%arg0: i1, %arg1: i1, %arg2: i1, %arg3: i1, %arg4: i4, %arg5: i4, %arg6: i4, %arg7: i4, %arg8: i4) -> (i4) {
+  %0 = comb.mux %arg3, %arg7, %arg8 : i4
+  %1 = comb.mux %arg2, %arg6, %0 : i4
+  %2 = comb.mux %arg1, %arg5, %1 : i4
+  %3 = comb.mux %arg0, %arg4, %2 {name = "result"} : i4
+  rtl.output %3 : i4
+}
@@ -0,0 +1,81 @@
+// RUN: circt-opt -rtl-print-timing %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=REPORT
+// RUN: circt-opt -rtl-print-timing %s 2>/dev/null | FileCheck %s
+
+// REPORT-LABEL: @child: critical path 4, ending at seq.compreg
+// REPORT-NEXT:    4 comb.add
+// CHECK-LABEL: rtl.module @child
+// CHECK-NEXT:    %0 = comb.add %a, %b {timing.arrival = 4 : i64} : i4
+// CHECK-NEXT:    %1 = seq.compreg %0, %clk {timing.arrival = 0 : i64} : i4
+// CHECK-NEXT:    %2 = comb.xor %1, %a {timing.arrival = 1 : i64} : i4
+// CHECK-NEXT:    rtl.output %0, %2 : i4, i4
+rtl.module @child(%a: i4, %b: i4, %clk: i1) -> (i4, i4) {
+  %0 = comb.add %a, %b : i4
+  %1 = seq.compreg %0, %clk : i4
+  %2 = comb.xor %1, %a : i4
+  rtl.output %0, %2 : i4, i4
+}
+
+// Paths from the inputs to the outputs of an instance go through the
+// instantiated module.
+// REPORT-LABEL: @top: critical path 9, ending at rtl.output
+// REPORT-NEXT:    5 rtl.instance
+// REPORT-NEXT:    9 comb.mul
+// CHECK-LABEL: rtl.module @top
+// CHECK-NEXT:    %0 = comb.and %x, %y {timing.arrival = 1 : i64} : i4
+// CHECK-NEXT:    rtl.instance "inst" @child(%0, %y, %clk) {timing.arrival = 5 : i64}
+// CHECK-NEXT:    comb.mul {{.+}} {timing.arrival = 9 : i64} : i4
+rtl.module @top(%x: i4, %y: i4, %clk: i1) -> (i4) {
+  %0 = comb.and %x, %y : i4
+  %1:2 = rtl.instance "inst" @child(%0, %y, %clk) : (i4, i4, i1) -> (i4, i4)
+  %2 = comb.mul %1#0, %1#1 : i4
+  rtl.output %2 : i4
+}
+
+// Reads of wires see the values connected to them.
+// REPORT-LABEL: @wires: critical path 2, ending at rtl.output
+// REPORT-NEXT:    1 comb.and
+// REPORT-NEXT:    1 sv.read_inout
+// REPORT-NEXT:    2 comb.xor
+rtl.module @wires(%a: i1, %b: i1) -> (i1) {
+  %w = sv.wire : !rtl.inout<i1>
+  %0 = sv.read_inout %w : !rtl.inout<i1>
+  %1 = comb.xor %0, %b : i1
+  sv.connect %w, %2 : i1
+  %2 = comb.and %a, %b : i1
+  rtl.output %1 : i1
+}
+
+// External modules end the paths reaching their inputs, and start new paths
+// at their outputs.
+// REPORT-LABEL: @uses_ext: critical path 4, ending at rtl.instance
+// REPORT-NEXT:    4 comb.add
+rtl.module.extern @ext(%in: i4) -> (%out: i4)
+rtl.module @uses_ext(%x: i4) -> (i4) {
+  %0 = comb.add %x, %x : i4
+  %1 = rtl.instance "e" @ext(%0) : (i4) -> (i4)
+  %2 = comb.sub %1, %x : i4
+  rtl.output %2 : i4
+}
+
+// Operations nested in procedural regions are on the paths through them, which
+// end at the procedural assignments.
+// REPORT-LABEL: @procedural: critical path 5, ending at sv.passign
+// REPORT-NEXT:    4 comb.add
+// REPORT-NEXT:    5 comb.xor
+// CHECK-LABEL: rtl.module @procedural
+// CHECK:         sv.always posedge %clk {
+// CHECK-NEXT:      %1 = comb.xor %0, %a {timing.arrival = 5 : i64} : i4
+rtl.module @procedural(%a: i4, %b: i4, %clk: i1) {
+  %r = sv.reg : !rtl.inout<i4>
+  %0 = comb.add %a, %b : i4
+  sv.always posedge %clk {
+    %1 = comb.xor %0, %a : i4
+    sv.passign %r, %1 : i4
+  }
+}
+
+// REPORT-LABEL: @constant: no timing paths
+rtl.module @constant() -> (i4) {
+  %c1_i4 = rtl.constant 1 : i4
+  rtl.output %c1_i4 : i4
+}
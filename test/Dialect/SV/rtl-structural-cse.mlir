@@ -0,0 +1,69 @@
+// RUN: circt-opt -pass-pipeline='rtl.module(rtl-structural-cse)' %s | FileCheck %s
+
+// The operands of commutative operations are compared in any order.
+// CHECK-LABEL: rtl.module @commutative(%arg0: i4, %arg1: i4) -> (i4, i4, i4) {
+// CHECK-NEXT:    %0 = comb.and %arg0, %arg1 : i4
+// CHECK-NEXT:    %1 = comb.sub %arg0, %arg1 : i4
+// CHECK-NEXT:    %2 = comb.sub %arg1, %arg0 : i4
+// CHECK-NEXT:    %3 = comb.xor %0, %0 : i4
+// CHECK-NEXT:    rtl.output %3, %1, %2 : i4, i4, i4
+rtl.module @commutative(%arg0: i4, %arg1: i4) -> (i4, i4, i4) {
+  %0 = comb.and %arg0, %arg1 : i4
+  %1 = comb.and %arg1, %arg0 : i4
+  %2 = comb.sub %arg0, %arg1 : i4
+  %3 = comb.sub %arg1, %arg0 : i4
+  %4 = comb.xor %0, %1 : i4
+  rtl.output %4, %2, %3 : i4, i4, i4
+}
+
+// Operations used before they are defined are merged once their operands
+// have been.
+// CHECK-LABEL: rtl.module @use_before_def(%arg0: i4) -> (i4, i4) {
+// CHECK-NEXT:    rtl.output [[ADD:%[0-9]+]], [[ADD]] : i4, i4
+// CHECK-NEXT:    [[ADD]] = comb.add [[NOT:%[0-9]+]], %arg0 : i4
+// CHECK-NEXT:    [[NOT]] = comb.xor %arg0, %c-1_i4 : i4
+// CHECK-NEXT:    %c-1_i4 = rtl.constant -1 : i4
+// CHECK-NEXT:  }
+rtl.module @use_before_def(%arg0: i4) -> (i4, i4) {
+  rtl.output %0, %1 : i4, i4
+  %0 = comb.add %2, %arg0 : i4
+  %1 = comb.add %arg0, %3 : i4
+  %2 = comb.xor %arg0, %c-1_i4 : i4
+  %3 = comb.xor %arg0, %c-1_i4_0 : i4
+  %c-1_i4 = rtl.constant -1 : i4
+  %c-1_i4_0 = rtl.constant -1 : i4
+}
+
+// Operations in nested regions are replaced by operations in the regions
+// enclosing them, but not by operations in other nested regions.
+// CHECK-LABEL: rtl.module @nested(%arg0: i1, %arg1: i1) -> (i1) {
+// CHECK-NEXT:    [[AND:%[0-9]+]] = comb.and %arg0, %arg1 : i1
+// CHECK-NEXT:    sv.initial {
+// CHECK-NEXT:      sv.fwrite "%x"([[AND]]) : i1
+// CHECK-NEXT:      [[XOR0:%[0-9]+]] = comb.xor %arg0, %arg1 : i1
+// CHECK-NEXT:      sv.fwrite "%x"([[XOR0]]) : i1
+// CHECK-NEXT:      sv.fwrite "%x"([[XOR0]]) : i1
+// CHECK-NEXT:    }
+// CHECK-NEXT:    sv.initial {
+// CHECK-NEXT:      [[XOR1:%[0-9]+]] = comb.xor %arg0, %arg1 : i1
+// CHECK-NEXT:      sv.fwrite "%x"([[XOR1]]) : i1
+// CHECK-NEXT:    }
+// CHECK-NEXT:    [[OR:%[0-9]+]] = comb.or %arg0, %arg1 : i1
+// CHECK-NEXT:    rtl.output [[OR]] : i1
+rtl.module @nested(%arg0: i1, %arg1: i1) -> (i1) {
+  %0 = comb.and %arg0, %arg1 : i1
+  sv.initial {
+    %2 = comb.and %arg1, %arg0 : i1
+    sv.fwrite "%x"(%2) : i1
+    %3 = comb.xor %arg0, %arg1 : i1
+    sv.fwrite "%x"(%3) : i1
+    %4 = comb.xor %arg1, %arg0 : i1
+    sv.fwrite "%x"(%4) : i1
+  }
+  sv.initial {
+    %2 = comb.xor %arg0, %arg1 : i1
+    sv.fwrite "%x"(%2) : i1
+  }
+  %1 = comb.or %arg0, %arg1 : i1
+  rtl.output %1 : i1
+}
@@ -0,0 +1,30 @@
+// RUN: circt-cyclesim %s -top=Top -n 3 -lanes=128 -vectors=%S/Inputs/vectors.txt | FileCheck %s
+// RUN: not circt-cyclesim %s -top=Mul -lanes=64 2>&1 | FileCheck %s --check-prefix=MUL
+// RUN: not circt-cyclesim %s -top=Top -lanes=100 2>&1 | FileCheck %s --check-prefix=LANES
+
+// CHECK:      lane 0 cycle 0: sum=251 lt=0 shr=0 acc=0
+// CHECK-NEXT: lane 1 cycle 0: sum=207 lt=1 shr=255 acc=0
+// CHECK-NEXT: lane 2 cycle 0: sum=137 lt=1 shr=255 acc=0
+// CHECK-NEXT: lane 0 cycle 1: sum=251 lt=0 shr=0 acc=1
+// CHECK-NEXT: lane 1 cycle 1: sum=207 lt=1 shr=255 acc=200
+// CHECK-NEXT: lane 2 cycle 1: sum=137 lt=1 shr=255 acc=128
+// CHECK-NEXT: lane 0 cycle 2: sum=251 lt=0 shr=0 acc=2
+// CHECK-NEXT: lane 1 cycle 2: sum=207 lt=1 shr=255 acc=0
+// CHECK-NEXT: lane 2 cycle 2: sum=137 lt=1 shr=255 acc=0
+rtl.module @Top(%clk: i1, %rst: i1, %a: i8, %b: i8) -> (%sum: i8, %lt: i1, %shr: i8, %acc: i8) {
+  %c0_i8 = rtl.constant 0 : i8
+  %sum = comb.add %a, %b : i8
+  %lt = comb.icmp slt %a, %b : i8
+  %shr = comb.shrs %a, %b : i8
+  %next = comb.add %acc, %a : i8
+  %acc = seq.compreg %next, %clk, %rst, %c0_i8 : i8
+  rtl.output %sum, %lt, %shr, %acc : i8, i1, i8, i8
+}
+
+// MUL: error: operation is not supported by the bit-parallel simulator
+rtl.module @Mul(%a: i8, %b: i8) -> (%mul: i8) {
+  %mul = comb.mul %a, %b : i8
+  rtl.output %mul : i8
+}
+
+// LANES: error: the number of lanes must be a multiple of 64
@@ -0,0 +1,29 @@
+// RUN: circt-cyclesim %s -top=Narrow -input a=200 -input b=7 | FileCheck %s --check-prefix=NARROW
+// RUN: circt-cyclesim %s -top=Wide -input a=0x123456789abcdef0123 -input b=4 | FileCheck %s --check-prefix=WIDE
+
+// NARROW: cycle 0: add=207 sub=193 divs=248 mods=0 shrs=254 cat=51207 ext=9 sext=65480 slt=1 ult=0 parity=1
+rtl.module @Narrow(%a: i8, %b: i8) -> (%add: i8, %sub: i8, %divs: i8, %mods: i8, %shrs: i8, %cat: i16, %ext: i4, %sext: i16, %slt: i1, %ult: i1, %parity: i1) {
+  %add = comb.add %a, %b : i8
+  %sub = comb.sub %a, %b : i8
+  %divs = comb.divs %a, %b : i8
+  %mods = comb.mods %a, %b : i8
+  %c5_i8 = rtl.constant 5 : i8
+  %shrs = comb.shrs %a, %c5_i8 : i8
+  %cat = comb.concat %a, %b : (i8, i8) -> i16
+  %ext = comb.extract %a from 3 : (i8) -> i4
+  %sext = comb.sext %a : (i8) -> i16
+  %slt = comb.icmp slt %a, %b : i8
+  %ult = comb.icmp ult %a, %b : i8
+  %parity = comb.parity %a : i8
+  rtl.output %add, %sub, %divs, %mods, %shrs, %cat, %ext, %sext, %slt, %ult, %parity : i8, i8, i8, i8, i8, i16, i4, i16, i1, i1, i1
+}
+
+// WIDE: cycle 0: shl=85968058283706962416176 high=291 cat=85968058283706962416180 mul=85968058283706962416176
+rtl.module @Wide(%a: i80, %b: i80) -> (%shl: i80, %high: i16, %cat: i84, %mul: i80) {
+  %shl = comb.shl %a, %b : i80
+  %high = comb.extract %a from 64 : (i80) -> i16
+  %b4 = comb.extract %b from 0 : (i80) -> i4
+  %cat = comb.concat %a, %b4 : (i80, i4) -> i84
+  %mul = comb.mul %a, %b, %b : i80
+  rtl.output %shl, %high, %cat, %mul : i80, i16, i84, i80
+}
@@ -0,0 +1,24 @@
+// RUN: circt-cyclesim %s -top=Top -n 6 -input en=1 -input rst=1@3 -input rst=0@4 | FileCheck %s
+
+// CHECK:      cycle 0: count=0 wrapped=0
+// CHECK-NEXT: cycle 1: count=1 wrapped=0
+// CHECK-NEXT: cycle 2: count=2 wrapped=0
+// CHECK-NEXT: cycle 3: count=3 wrapped=1
+// CHECK-NEXT: cycle 4: count=0 wrapped=0
+// CHECK-NEXT: cycle 5: count=1 wrapped=0
+
+rtl.module @Counter(%clk: i1, %rst: i1, %en: i1) -> (%count: i2) {
+  %c0_i2 = rtl.constant 0 : i2
+  %c1_i2 = rtl.constant 1 : i2
+  %next = comb.add %count, %c1_i2 : i2
+  %d = comb.mux %en, %next, %count : i2
+  %count = seq.compreg %d, %clk, %rst, %c0_i2 : i2
+  rtl.output %count : i2
+}
+
+rtl.module @Top(%clk: i1, %rst: i1, %en: i1) -> (%count: i2, %wrapped: i1) {
+  %c3_i2 = rtl.constant 3 : i2
+  rtl.output %0, %1 : i2, i1
+  %0 = rtl.instance "counter" @Counter(%clk, %rst, %en) : (i1, i1, i1) -> i2
+  %1 = comb.icmp eq %0, %c3_i2 : i2
+}
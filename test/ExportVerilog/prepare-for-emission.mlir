@@ -0,0 +1,23 @@
+// RUN: circt-opt -prepare-for-emission %s | FileCheck %s
+// RUN: circt-opt -prepare-for-emission -prepare-for-emission %s | FileCheck %s
+
+// CHECK-LABEL: rtl.module @variadic
+// CHECK-NEXT:    %0 = comb.and %a, %b : i1
+// CHECK-NEXT:    %1 = comb.and %c, %d : i1
+// CHECK-NEXT:    %2 = comb.and %0, %1 : i1
+// CHECK-NEXT:    rtl.output %2 : i1
+rtl.module @variadic(%a: i1, %b: i1, %c: i1, %d: i1) -> (%x: i1) {
+  %0 = comb.and %a, %b, %c, %d : i1
+  rtl.output %0 : i1
+}
+
+// CHECK-LABEL: rtl.module @merge
+// CHECK-NEXT:    %0 = sv.wire : !rtl.inout<i1>
+// CHECK-NEXT:    sv.connect %0, %a : i1
+// CHECK-NEXT:    sv.connect %0, %b : i1
+// CHECK-NEXT:    %1 = sv.read_inout %0 : !rtl.inout<i1>
+// CHECK-NEXT:    rtl.output %1 : i1
+rtl.module @merge(%a: i1, %b: i1) -> (%x: i1) {
+  %0 = comb.merge %a, %b : i1
+  rtl.output %0 : i1
+}
@@ -0,0 +1,25 @@
+// RUN: circt-translate --export-verilog %s | FileCheck %s --check-prefix=INLINE
+// RUN: circt-translate --lowering-options=sourceMapIDs --export-verilog %s | FileCheck %s
+
+rtl.module @Foo(%a: i1, %b: i1) -> (%x: i1, %y: i1, %z: i1) {
+  %0 = comb.and %a, %b : i1 loc("foo.fir":1:2)
+  %1 = comb.or %a, %b : i1 loc("foo.fir":3:4)
+  %2 = comb.xor %a, %b : i1 loc("foo.fir":1:2)
+  rtl.output %0, %1, %2 : i1, i1, i1 loc("out.fir":9:1)
+}
+
+// INLINE-LABEL: module Foo(
+// INLINE:      assign x = a & b; // foo.fir:1:2, out.fir:9:1
+// INLINE-NEXT: assign y = a | b; // foo.fir:3:4, out.fir:9:1
+// INLINE-NEXT: assign z = a ^ b; // foo.fir:1:2, out.fir:9:1
+// INLINE-NOT: Source map
+
+// CHECK-LABEL: module Foo(
+// CHECK:      assign x = a & b; // @0
+// CHECK-NEXT: assign y = a | b; // @1
+// CHECK-NEXT: assign z = a ^ b; // @0
+// CHECK-NEXT: endmodule
+// CHECK-LABEL: // Source map:
+// CHECK-NEXT:  // Foo@0 foo.fir:1:2, out.fir:9:1
+// CHECK-NEXT:  // Foo@1 foo.fir:3:4, out.fir:9:1
+// CHECK-NOT:   Foo@2
@@ -0,0 +1,20 @@
+// RUN: circt-opt -rtl-legalize-names -print-parallel-schedule %s -o /dev/null 2>&1 | FileCheck %s
+// RUN: circt-opt -rtl-legalize-names -print-parallel-schedule -mlir-disable-threading %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=SERIAL
+
+// CHECK: ===- Parallel schedule: 2 operations -===
+// CHECK-DAG: s  rtl.module @Small (2 ops)
+// CHECK-DAG: s  rtl.module @Large (4 ops)
+
+// COM: The costs are not estimated when the operations are processed serially.
+// SERIAL: ===- Parallel schedule: 2 operations -===
+// SERIAL-DAG: s  rtl.module @Small{{$}}
+// SERIAL-DAG: s  rtl.module @Large{{$}}
+
+rtl.module @Small() {
+}
+
+rtl.module @Large(%a: i1) -> (%x: i1) {
+  %0 = comb.xor %a, %a : i1
+  %1 = comb.and %0, %a : i1
+  rtl.output %1 : i1
+}
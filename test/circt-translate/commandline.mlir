@@ -3,8 +3,10 @@
 // CHECK: OVERVIEW: CIRCT Translation Testing Tool
 
 // CHECK: Translation to perform
+// CHECK: --export-circt-binary
 // CHECK: --export-llhd-verilog
 // CHECK: --export-verilog
+// CHECK: --import-circt-binary
 // CHECK: --import-firrtl
 
 // CHECK: --lowering-options=<value>
\ No newline at end of file
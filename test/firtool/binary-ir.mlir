@@ -0,0 +1,16 @@
+// RUN: firtool %s --format=mlir --binary -o %t.bin
+// RUN: firtool %t.bin --verilog | FileCheck %s --check-prefix=VERILOG
+// RUN: firtool %t.bin --format=binary --mlir | FileCheck %s --check-prefix=MLIR
+
+firrtl.circuit "Top" {
+  firrtl.module @Top(%a: !firrtl.uint<4>, %b: !firrtl.flip<uint<4>>) {
+    %0 = firrtl.not %a : (!firrtl.uint<4>) -> !firrtl.uint<4>
+    firrtl.connect %b, %0 : !firrtl.flip<uint<4>>, !firrtl.uint<4>
+  }
+}
+
+// VERILOG-LABEL: module Top(
+// VERILOG: assign b = ~a;
+
+// MLIR-LABEL: firrtl.module @Top
+// MLIR-NEXT: %0 = firrtl.not %a
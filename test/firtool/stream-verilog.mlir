@@ -0,0 +1,53 @@
+// RUN: firtool %s --format=mlir -verilog > %t.sv
+// RUN: firtool %s --format=mlir -verilog -stream-verilog > %t.stream.sv
+// RUN: diff %t.sv %t.stream.sv
+// RUN: FileCheck %s < %t.stream.sv
+// RUN: firtool %s --format=mlir -verilog -stream-verilog -stats-json=%t.json \
+// RUN:     > /dev/null
+// RUN: FileCheck %s --check-prefix=STATS < %t.json
+
+// Streaming emits the modules in parallel, but the output keeps the order of
+// the design.  Only declarations of the emitted modules are left in the IR.
+
+// STATS:      "name": "emit",
+// STATS:      "opCountsBefore": {
+// STATS:        "rtl": 4,
+// STATS-NEXT:   "sv": 1
+// STATS-NEXT: },
+
+sv.verbatim "// header"
+
+rtl.module.extern @External(%a: i4) -> (%b: i4)
+
+// CHECK:      // header
+// CHECK:      // external module External
+// CHECK:      module Small(
+// CHECK:        assign b =
+// CHECK:      endmodule
+rtl.module @Small(%a: i4) -> (%b: i4) {
+  %ones = rtl.constant -1 : i4
+  %0 = comb.xor %a, %ones : i4
+  rtl.output %0 : i4
+}
+
+// CHECK:      module Large(
+// CHECK:        Small small (
+// CHECK:        External ext (
+// CHECK:      endmodule
+rtl.module @Large(%a: i4, %b: i4, %c: i4) -> (%x: i4, %y: i4) {
+  %0 = comb.add %a, %b : i4
+  %1 = comb.mul %0, %c : i4
+  %2 = comb.xor %1, %a : i4
+  %3 = comb.and %2, %b : i4
+  %small.b = rtl.instance "small" @Small(%3) : (i4) -> (i4)
+  %ext.b = rtl.instance "ext" @External(%small.b) : (i4) -> (i4)
+  rtl.output %ext.b, %3 : i4, i4
+}
+
+// CHECK:      module Top(
+// CHECK:        Large large (
+// CHECK:      endmodule
+rtl.module @Top(%a: i4) -> (%x: i4) {
+  %large.x, %large.y = rtl.instance "large" @Large(%a, %a, %a) : (i4, i4, i4) -> (i4, i4)
+  rtl.output %large.x : i4
+}
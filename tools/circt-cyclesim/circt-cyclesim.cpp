@@ -0,0 +1,262 @@
+//===- circt-cyclesim.cpp - Cycle-based RTL simulator tool ----------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a command line tool which runs a cycle-based simulation
+// of a design made of rtl.module, comb and seq.compreg operations, and prints
+// the outputs of the top-level module once per cycle.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/Comb/CombDialect.h"
+#include "circt/Dialect/RTL/RTLDialect.h"
+#include "circt/Dialect/SV/SVDialect.h"
+#include "circt/Dialect/Seq/SeqDialect.h"
+#include "circt/Dialect/Seq/Simulator/CycleSimulator.h"
+
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/Parser.h"
+#include "mlir/Support/FileUtilities.h"
+
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ToolOutputFile.h"
+
+using namespace llvm;
+using namespace mlir;
+using namespace circt;
+
+static cl::opt<std::string>
+    inputFilename(cl::Positional, cl::desc("<input-file>"), cl::init("-"));
+
+static cl::opt<std::string> outputFilename("o", cl::desc("Output filename"),
+                                           cl::value_desc("filename"),
+                                           cl::init("-"));
+
+static cl::opt<std::string> top("top", cl::desc("The top-level module"),
+                                cl::value_desc("name"), cl::Required);
+
+static cl::opt<uint64_t> numCycles("n", cl::desc("The number of cycles to run"),
+                                   cl::value_desc("cycles"), cl::init(1));
+
+static cl::list<std::string>
+    inputValues("input",
+                cl::desc("Set an input port at the start of a cycle, as "
+                         "<name>=<value>[@<cycle>].  The cycle defaults to 0, "
+                         "and the value is kept until it is set again"),
+                cl::value_desc("stimulus"), cl::ZeroOrMore);
+
+static cl::opt<unsigned>
+    numLanes("lanes",
+             cl::desc("Simulate this many independent stimuli at once with "
+                      "bit-parallel evaluation, a multiple of 64"),
+             cl::value_desc("lanes"), cl::init(0));
+
+static cl::opt<std::string>
+    vectorsFilename("vectors",
+                    cl::desc("Stimuli for bit-parallel simulation, one lane "
+                             "per line, with the syntax of -input separated "
+                             "by whitespace"),
+                    cl::value_desc("filename"));
+
+namespace {
+struct Stimulus {
+  uint64_t cycle;
+  unsigned port;
+  /// The lane the stimulus applies to, or all lanes if None.
+  Optional<unsigned> lane;
+  APInt value;
+};
+} // end anonymous namespace
+
+/// Parse a stimulus of the form <name>=<value>[@<cycle>].
+static LogicalResult parseStimulus(seq::sim::SimulatorBase &simulator,
+                                   StringRef option, Optional<unsigned> lane,
+                                   SmallVectorImpl<Stimulus> &stimuli) {
+  StringRef name, value, cycle = "0";
+  std::tie(name, value) = option.split('=');
+  if (value.contains('@'))
+    std::tie(value, cycle) = value.split('@');
+
+  auto port = simulator.lookupInput(name);
+  if (!port) {
+    errs() << "error: unknown input port '" << name << "'\n";
+    return failure();
+  }
+
+  Stimulus stimulus;
+  unsigned width = simulator.getInputs()[*port].width;
+  if (value.getAsInteger(0, stimulus.value) ||
+      cycle.getAsInteger(10, stimulus.cycle)) {
+    errs() << "error: invalid stimulus '" << option << "'\n";
+    return failure();
+  }
+  stimulus.port = *port;
+  stimulus.lane = lane;
+  stimulus.value = stimulus.value.zextOrTrunc(std::max(width, 1U));
+  stimuli.push_back(stimulus);
+  return success();
+}
+
+/// Parse the -input options and the vector file into a list of stimuli sorted
+/// by cycle, and return the number of lanes in the vector file.
+static LogicalResult parseStimuli(seq::sim::SimulatorBase &simulator,
+                                  SmallVectorImpl<Stimulus> &stimuli,
+                                  unsigned &numVectors) {
+  for (StringRef option : inputValues)
+    if (failed(parseStimulus(simulator, option, None, stimuli)))
+      return failure();
+
+  numVectors = 0;
+  if (!vectorsFilename.empty()) {
+    std::string errorMessage;
+    auto file = openInputFile(vectorsFilename, &errorMessage);
+    if (!file) {
+      errs() << errorMessage << "\n";
+      return failure();
+    }
+
+    SmallVector<StringRef, 8> lines, options;
+    file->getBuffer().split(lines, '\n');
+    for (auto line : lines) {
+      line = line.split('#').first.trim();
+      if (line.empty())
+        continue;
+      if (numVectors == numLanes) {
+        errs() << "error: more vectors than lanes in '" << vectorsFilename
+               << "'\n";
+        return failure();
+      }
+      options.clear();
+      line.split(options, ' ', -1, /*KeepEmpty=*/false);
+      for (auto option : options)
+        if (failed(parseStimulus(simulator, option, numVectors, stimuli)))
+          return failure();
+      ++numVectors;
+    }
+  }
+
+  llvm::stable_sort(stimuli, [](const Stimulus &lhs, const Stimulus &rhs) {
+    return lhs.cycle < rhs.cycle;
+  });
+  return success();
+}
+
+/// Print the outputs of the top-level module.
+static void printOutputs(raw_ostream &os, uint64_t cycle,
+                         ArrayRef<seq::sim::PortInfo> outputs,
+                         function_ref<APInt(unsigned)> getOutput) {
+  os << "cycle " << cycle << ":";
+  for (unsigned i = 0, e = outputs.size(); i != e; ++i)
+    os << " " << outputs[i].name.getValue() << "="
+       << getOutput(i).toString(10, /*Signed=*/false);
+  os << "\n";
+}
+
+/// Run the simulation, printing the outputs of every cycle.
+static LogicalResult simulate(seq::sim::CycleSimulator &simulator,
+                              raw_ostream &os) {
+  SmallVector<Stimulus, 8> stimuli;
+  unsigned numVectors;
+  if (failed(parseStimuli(simulator, stimuli, numVectors)))
+    return failure();
+
+  auto *nextStimulus = stimuli.begin();
+  for (uint64_t cycle = 0; cycle != numCycles; ++cycle) {
+    for (; nextStimulus != stimuli.end() && nextStimulus->cycle == cycle;
+         ++nextStimulus)
+      simulator.setInput(nextStimulus->port, nextStimulus->value);
+
+    printOutputs(os, cycle, simulator.getOutputs(),
+                 [&](unsigned index) { return simulator.getOutput(index); });
+    simulator.step();
+  }
+  return success();
+}
+
+/// Run the bit-parallel simulation, printing the outputs of every cycle for
+/// each lane with a vector.
+static LogicalResult simulate(seq::sim::BitParallelSimulator &simulator,
+                              raw_ostream &os) {
+  SmallVector<Stimulus, 8> stimuli;
+  unsigned numVectors;
+  if (failed(parseStimuli(simulator, stimuli, numVectors)))
+    return failure();
+
+  auto *nextStimulus = stimuli.begin();
+  for (uint64_t cycle = 0; cycle != numCycles; ++cycle) {
+    for (; nextStimulus != stimuli.end() && nextStimulus->cycle == cycle;
+         ++nextStimulus) {
+      if (nextStimulus->lane) {
+        simulator.setInput(nextStimulus->port, *nextStimulus->lane,
+                           nextStimulus->value);
+        continue;
+      }
+      for (unsigned lane = 0; lane != numLanes; ++lane)
+        simulator.setInput(nextStimulus->port, lane, nextStimulus->value);
+    }
+
+    for (unsigned lane = 0; lane != std::max(numVectors, 1U); ++lane) {
+      os << "lane " << lane << " ";
+      printOutputs(os, cycle, simulator.getOutputs(), [&](unsigned index) {
+        return simulator.getOutput(index, lane);
+      });
+    }
+    simulator.step();
+  }
+  return success();
+}
+
+int main(int argc, char **argv) {
+  InitLLVM y(argc, argv);
+
+  cl::ParseCommandLineOptions(argc, argv, "Cycle-based RTL simulator\n");
+
+  std::string errorMessage;
+  auto file = openInputFile(inputFilename, &errorMessage);
+  if (!file) {
+    errs() << errorMessage << "\n";
+    return 1;
+  }
+
+  auto output = openOutputFile(outputFilename, &errorMessage);
+  if (!output) {
+    errs() << errorMessage << "\n";
+    return 1;
+  }
+
+  SourceMgr sourceMgr;
+  sourceMgr.AddNewSourceBuffer(std::move(file), SMLoc());
+
+  MLIRContext context;
+  SourceMgrDiagnosticHandler diagHandler(sourceMgr, &context);
+  context.loadDialect<comb::CombDialect, rtl::RTLDialect, seq::SeqDialect,
+                      sv::SVDialect>();
+
+  OwningModuleRef module(parseSourceFile(sourceMgr, &context));
+  if (!module)
+    return 1;
+
+  if (numLanes) {
+    auto simulator =
+        seq::sim::BitParallelSimulator::create(*module, top, numLanes);
+    if (!simulator || failed(simulate(*simulator, output->os())))
+      return 1;
+  } else {
+    if (!vectorsFilename.empty()) {
+      errs() << "error: -vectors requires -lanes\n";
+      return 1;
+    }
+    auto simulator = seq::sim::CycleSimulator::create(*module, top);
+    if (!simulator || failed(simulate(*simulator, output->os())))
+      return 1;
+  }
+
+  output->keep();
+  return 0;
+}
@@ -12,7 +12,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "circt/InitAllDialects.h"
+#include "circt/Dialect/RTL/RTLDialect.h"
 #include "circt/InitAllPasses.h"
+#include "circt/Support/ParallelScheduling.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
@@ -38,6 +40,10 @@ int main(int argc, char **argv) {
   mlir::registerSCCPPass();
   mlir::registerInlinerPass();
 
+  // Register the CIRCT command line options.
+  circt::registerParallelSchedulingCLOptions();
+  circt::rtl::registerRTLDialectCLOptions();
+
   return mlir::failed(
       mlir::MlirOptMain(argc, argv, "CIRCT modular optimizer driver", registry,
                         /*prelaodDialectsInContext=*/false));
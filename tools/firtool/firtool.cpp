@@ -20,22 +20,39 @@
 #include "circt/Dialect/RTL/RTLDialect.h"
 #include "circt/Dialect/RTL/RTLOps.h"
 #include "circt/Dialect/SV/SVDialect.h"
+#include "circt/Dialect/SV/SVOps.h"
 #include "circt/Dialect/SV/SVPasses.h"
 #include "circt/Support/LoweringOptions.h"
+#include "circt/Support/ParallelScheduling.h"
 #include "circt/Transforms/Passes.h"
+#include "circt/Translation/BinaryIR.h"
 #include "circt/Translation/ExportVerilog.h"
+#include "circt/Translation/Passes.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/IR/AsmState.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/SymbolTable.h"
 #include "mlir/Parser.h"
 #include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassInstrumentation.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Support/FileUtilities.h"
 #include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Parallel.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/raw_sha1_ostream.h"
+
+#include <chrono>
+#include <map>
+#include <mutex>
 
 using namespace llvm;
 using namespace mlir;
@@ -44,14 +61,21 @@ using namespace circt;
 /// Allow the user to specify the input file format.  This can be used to
 /// override the input, and can be used to specify ambiguous cases like standard
 /// input.
-enum InputFormatKind { InputUnspecified, InputFIRFile, InputMLIRFile };
+enum InputFormatKind {
+  InputUnspecified,
+  InputFIRFile,
+  InputMLIRFile,
+  InputBinaryFile
+};
 
 static cl::opt<InputFormatKind> inputFormat(
     "format", cl::desc("Specify input file format:"),
     cl::values(clEnumValN(InputUnspecified, "autodetect",
                           "Autodetect input format"),
                clEnumValN(InputFIRFile, "fir", "Parse as .fir file"),
-               clEnumValN(InputMLIRFile, "mlir", "Parse as .mlir file")),
+               clEnumValN(InputMLIRFile, "mlir", "Parse as .mlir file"),
+               clEnumValN(InputBinaryFile, "binary",
+                          "Read as MLIR in the binary IR format")),
     cl::init(InputUnspecified));
 
 static cl::opt<std::string>
@@ -87,6 +111,10 @@ static cl::opt<bool>
                    cl::desc("Create a blackbox for all memory operations"),
                    cl::init(false));
 
+static cl::opt<bool>
+    dedup("dedup", cl::desc("deduplicate structurally identical modules"),
+          cl::init(false));
+
 static cl::opt<bool>
     ignoreFIRLocations("ignore-fir-locators",
                        cl::desc("ignore the @info locations in the .fir file"),
@@ -94,6 +122,7 @@ static cl::opt<bool>
 
 enum OutputFormatKind {
   OutputMLIR,
+  OutputBinary,
   OutputVerilog,
   OutputSplitVerilog,
   OutputDisabled
@@ -102,6 +131,8 @@ enum OutputFormatKind {
 static cl::opt<OutputFormatKind> outputFormat(
     cl::desc("Specify output format:"),
     cl::values(clEnumValN(OutputMLIR, "mlir", "Emit MLIR dialect"),
+               clEnumValN(OutputBinary, "binary",
+                          "Emit MLIR dialect in the binary IR format"),
                clEnumValN(OutputVerilog, "verilog", "Emit Verilog"),
                clEnumValN(OutputSplitVerilog, "split-verilog",
                           "Emit Verilog (one file per module; specify "
@@ -110,6 +141,13 @@ static cl::opt<OutputFormatKind> outputFormat(
                           "Do not output anything")),
     cl::init(OutputMLIR));
 
+static cl::opt<bool> streamVerilog(
+    "stream-verilog",
+    cl::desc("With -verilog, emit each module as part of the pass pipeline "
+             "and then free its IR, instead of emitting the whole design at "
+             "the end"),
+    cl::init(false));
+
 static cl::opt<bool>
     verifyPasses("verify-each",
                  cl::desc("Run the verifier after each transformation pass"),
@@ -120,10 +158,473 @@ static cl::opt<std::string>
                             cl::desc("Optional input annotation file"),
                             cl::value_desc("filename"));
 
-/// Process a single buffer of the input.
+static cl::opt<std::string> sourceMapFilename(
+    "source-map",
+    cl::desc("Write the source map table of '--lowering-options=sourceMapIDs' "
+             "to this file instead of appending it to the Verilog output"),
+    cl::value_desc("filename"), cl::init(""));
+
+static cl::opt<std::string> incrementalCacheFilename(
+    "incremental-cache",
+    cl::desc("With -split-verilog, record a hash of each FIRRTL module in "
+             "this file, and neither lower nor emit the modules whose hash "
+             "did not change since the previous run"),
+    cl::value_desc("filename"), cl::init(""));
+
+static cl::opt<std::string> statsJSONFilename(
+    "stats-json",
+    cl::desc("Write a machine-readable report of the wall time, heap usage "
+             "and per-dialect operation counts of each compilation phase, "
+             "including the passes nested in module pipelines"),
+    cl::value_desc("filename"), cl::init(""));
+
+//===----------------------------------------------------------------------===//
+// Compilation statistics report
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// Operation counts keyed by dialect namespace.
+using OpCounts = std::map<std::string, int64_t>;
+
+/// Add the operation counts of `counts` to `total`.
+static void addOpCounts(OpCounts &total, const OpCounts &counts) {
+  for (auto &count : counts)
+    total[count.first] += count.second;
+}
+
+/// The statistics recorded for one phase of the compilation: parsing, one
+/// pass, or emission.  A nested pass, which runs once per operation it is
+/// anchored on, has one phase which accumulates all of its runs.
+struct PhaseStats {
+  std::string name;
+  /// The elapsed time from the start of the phase to its end.  For a nested
+  /// pass, this spans from the start of its first run to the end of its last.
+  double wallTime = 0;
+  /// The heap in use by malloc when the phase ended.  This is not the peak
+  /// usage within the phase.
+  int64_t heapBytesAfter = 0;
+  OpCounts opCountsBefore, opCountsAfter;
+  /// The operation a nested pass is anchored on, or empty for a top-level
+  /// phase.
+  std::string operation;
+  unsigned runs = 1;
+  /// The sum of the times of the runs of a nested pass, which exceeds its
+  /// wall time when the runs overlap on several threads.
+  double busyTime = 0;
+  std::chrono::steady_clock::time_point startTime;
+};
+
+/// This collects the statistics printed by -stats-json.
+class StatsReport {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Count the operations nested under `root`, including `root` itself.
+  static OpCounts countOps(Operation *root) {
+    OpCounts counts;
+    root->walk([&](Operation *op) {
+      ++counts[op->getName().getStringRef().split('.').first.str()];
+    });
+    return counts;
+  }
+
+  /// Add a phase which started at `startTime` and ended now.
+  PhaseStats &addPhase(StringRef name, Clock::time_point startTime) {
+    phases.emplace_back();
+    auto &phase = phases.back();
+    phase.name = name.str();
+    phase.startTime = startTime;
+    phase.wallTime =
+        std::chrono::duration<double>(Clock::now() - startTime).count();
+    phase.heapBytesAfter = llvm::sys::Process::GetMallocUsage();
+    return phase;
+  }
+
+  /// Add a run of the nested pass `pass` on `op`, which started at
+  /// `startTime` and ended now, to the phase of the pass.  The pass manager
+  /// runs a copy of the pass on each thread, so the phase is keyed by the name
+  /// of the pass and of the operation it is anchored on, and merges the runs
+  /// of all copies.  It is added when the pass first finishes, i.e. before the
+  /// phase of the pipeline which contains it.
+  PhaseStats &addNestedRun(Pass *pass, Operation *op,
+                           Clock::time_point startTime) {
+    auto endTime = Clock::now();
+    auto runTime = std::chrono::duration<double>(endTime - startTime).count();
+    auto key = std::make_pair(pass->getName().str(),
+                              op->getName().getStringRef().str());
+    auto it = nestedPhases.find(key);
+    if (it == nestedPhases.end()) {
+      auto &phase = addPhase(pass->getName(), startTime);
+      phase.operation = key.second;
+      phase.busyTime = runTime;
+      nestedPhases.emplace(std::move(key), phases.size() - 1);
+      return phase;
+    }
+    auto &phase = phases[it->second];
+    phase.startTime = std::min(phase.startTime, startTime);
+    phase.wallTime =
+        std::chrono::duration<double>(endTime - phase.startTime).count();
+    phase.busyTime += runTime;
+    phase.heapBytesAfter = llvm::sys::Process::GetMallocUsage();
+    ++phase.runs;
+    return phase;
+  }
+
+  /// Write the report as JSON to the specified file.
+  LogicalResult write(StringRef filename);
+
+private:
+  std::vector<PhaseStats> phases;
+  /// The index of the phase of each nested pass, keyed by the name of the
+  /// pass and of the operation it is anchored on.
+  std::map<std::pair<std::string, std::string>, size_t> nestedPhases;
+};
+
+/// A pass instrumentation which records a phase in a StatsReport for every
+/// pass.  Passes nested in a pipeline on e.g. individual modules run on
+/// several threads at once, so the runs in progress are keyed by the pass and
+/// the operation, and the report is updated under a lock.
+class StatsInstrumentation : public PassInstrumentation {
+public:
+  explicit StatsInstrumentation(StatsReport &report) : report(report) {}
+
+  void runBeforePass(Pass *pass, Operation *op) override {
+    auto opCounts = StatsReport::countOps(op);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &run = runs[{pass, op}];
+    run.opCountsBefore = std::move(opCounts);
+    run.startTime = StatsReport::Clock::now();
+  }
+
+  void runAfterPass(Pass *pass, Operation *op) override {
+    auto endTime = StatsReport::Clock::now();
+    auto opCounts = StatsReport::countOps(op);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = runs.find({pass, op});
+    assert(it != runs.end() && "pass finished without starting");
+    auto run = std::move(it->second);
+    runs.erase(it);
+
+    // Leave the time spent counting the operations out of the phase.
+    run.startTime += StatsReport::Clock::now() - endTime;
+    if (!op->getParentOp()) {
+      auto &phase = report.addPhase(pass->getName(), run.startTime);
+      phase.opCountsBefore = std::move(run.opCountsBefore);
+      phase.opCountsAfter = std::move(opCounts);
+      return;
+    }
+    auto &phase = report.addNestedRun(pass, op, run.startTime);
+    addOpCounts(phase.opCountsBefore, run.opCountsBefore);
+    addOpCounts(phase.opCountsAfter, opCounts);
+  }
+
+  void runAfterPassFailed(Pass *pass, Operation *op) override {
+    runAfterPass(pass, op);
+  }
+
+private:
+  struct Run {
+    StatsReport::Clock::time_point startTime;
+    OpCounts opCountsBefore;
+  };
+
+  StatsReport &report;
+  std::mutex mutex;
+  DenseMap<std::pair<Pass *, Operation *>, Run> runs;
+};
+} // end anonymous namespace
+
+LogicalResult StatsReport::write(StringRef filename) {
+  std::string errorMessage;
+  auto output = openOutputFile(filename, &errorMessage);
+  if (!output) {
+    llvm::errs() << errorMessage << "\n";
+    return failure();
+  }
+
+  auto writeOpCounts = [](llvm::json::OStream &json, StringRef key,
+                          const OpCounts &counts) {
+    json.attributeObject(key, [&] {
+      for (auto &count : counts)
+        json.attribute(count.first, count.second);
+    });
+  };
+
+  llvm::json::OStream json(output->os(), /*IndentSize=*/2);
+  json.object([&] {
+    json.attributeArray("phases", [&] {
+      for (auto &phase : phases) {
+        json.object([&] {
+          json.attribute("name", phase.name);
+          json.attribute("wallTime", phase.wallTime);
+          json.attribute("heapBytesAfter", phase.heapBytesAfter);
+          writeOpCounts(json, "opCountsBefore", phase.opCountsBefore);
+          writeOpCounts(json, "opCountsAfter", phase.opCountsAfter);
+          if (!phase.operation.empty()) {
+            json.attribute("operation", phase.operation);
+            json.attribute("runs", phase.runs);
+            json.attribute("busyTime", phase.busyTime);
+          }
+        });
+      }
+    });
+  });
+  output->os() << '\n';
+  output->keep();
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// Incremental compilation
+//===----------------------------------------------------------------------===//
+
+/// Changing this invalidates all the caches written by earlier versions.
+static constexpr const char *incrementalCacheVersion =
+    "firtool-incremental-cache-v1";
+
+namespace {
+/// This implements -incremental-cache.  Before lowering, every FIRRTL module
+/// is hashed along with the signatures of the modules and other symbols it
+/// refers to, the command line and the circuit.  A module whose hash is the
+/// one recorded by the previous run, and whose file is still in the output
+/// directory, is replaced by an external module: it is neither lowered nor
+/// emitted, while the modules instantiating it are still lowered against its
+/// ports.
+///
+/// The header operations emitted into every file depend on the whole design,
+/// e.g. on whether any module uses register randomization.  Their hash is
+/// recorded too, and if it changed while files were reused, the design has to
+/// be compiled again without reusing any.
+class IncrementalCache {
+public:
+  IncrementalCache(StringRef filename, StringRef outputDirectory,
+                   std::string commandLine)
+      : filename(filename), outputDirectory(outputDirectory),
+        commandLine(std::move(commandLine)) {}
+
+  /// Read the hashes recorded by the previous run.  A missing cache, or one
+  /// written by another version, is treated as empty.
+  void read();
+
+  /// Write the hashes of this run, or remove the cache if the emission
+  /// failed, since the files may no longer match the recorded hashes.
+  LogicalResult write(bool emissionSucceeded);
+
+  /// Hash the modules of the FIRRTL circuit in `module`, and replace the ones
+  /// whose file can be reused by external modules.
+  void skipUnchangedModules(ModuleOp module);
+
+  /// Hash the header operations of the lowered design, and return true if
+  /// they changed while files emitted with the old ones were reused.
+  bool headerChanged(ModuleOp module);
+
+  /// Forget the hashes of the previous run, so that no file is reused when
+  /// the design is compiled again.
+  void forgetPreviousRun() {
+    previousHashes.clear();
+    hashes.clear();
+    reusedModules.clear();
+  }
+
+  /// The modules whose files are reused.
+  const llvm::StringSet<> &getReusedModules() const { return reusedModules; }
+
+private:
+  Optional<std::string> hashModule(firrtl::FModuleOp module,
+                                   SymbolTable &symbolTable,
+                                   StringRef commonInput);
+
+  StringRef filename, outputDirectory;
+  std::string commandLine;
+
+  /// The hashes of the header and of each module, keyed by the module name.
+  std::string previousHeaderHash, headerHash;
+  llvm::StringMap<std::string> previousHashes, hashes;
+
+  llvm::StringSet<> reusedModules;
+};
+} // end anonymous namespace
+
+void IncrementalCache::read() {
+  auto buffer = llvm::MemoryBuffer::getFile(filename);
+  if (!buffer)
+    return;
+  SmallVector<StringRef, 0> lines;
+  (*buffer)->getBuffer().split(lines, '\n', /*MaxSplit=*/-1,
+                               /*KeepEmpty=*/false);
+  if (lines.empty() || lines.front() != incrementalCacheVersion)
+    return;
+  for (auto line : llvm::drop_begin(lines, 1)) {
+    StringRef hash, name;
+    std::tie(hash, name) = line.split(' ');
+    if (hash == "header")
+      previousHeaderHash = name.str();
+    else if (!name.empty())
+      previousHashes[name] = hash.str();
+  }
+}
+
+LogicalResult IncrementalCache::write(bool emissionSucceeded) {
+  if (!emissionSucceeded) {
+    (void)llvm::sys::fs::remove(filename);
+    return failure();
+  }
+
+  std::string errorMessage;
+  auto output = openOutputFile(filename, &errorMessage);
+  if (!output) {
+    llvm::errs() << errorMessage << "\n";
+    return failure();
+  }
+
+  // Write the modules in a stable order.
+  std::vector<std::pair<StringRef, StringRef>> entries;
+  for (auto &entry : hashes)
+    entries.push_back({entry.getKey(), entry.getValue()});
+  llvm::sort(entries);
+
+  auto &os = output->os();
+  os << incrementalCacheVersion << '\n' << "header " << headerHash << '\n';
+  for (auto &entry : entries)
+    os << entry.second << ' ' << entry.first << '\n';
+  output->keep();
+  return success();
+}
+
+/// Hash a module and the signatures of the symbols it refers to, or return
+/// None if the module must always be lowered.
+Optional<std::string>
+IncrementalCache::hashModule(firrtl::FModuleOp module,
+                             SymbolTable &symbolTable, StringRef commonInput) {
+  // Ports whose names are not valid in Verilog are renamed in the lowered
+  // module, but not in its external declaration, which the instances would
+  // then refer to.
+  for (auto &port : module.getPorts())
+    if (!sv::isNameValid(port.getName()))
+      return None;
+
+  // Memories are lowered into modules shared by the whole design, which a
+  // skipped module would not contribute to.
+  auto hasMemory = module.walk([](Operation *op) {
+    if (isa<firrtl::MemOp, firrtl::CMemOp, firrtl::SMemOp>(op))
+      return WalkResult::interrupt();
+    return WalkResult::advance();
+  });
+  if (hasMemory.wasInterrupted())
+    return None;
+
+  // The uses are found in nested attributes and types, too.  They are unknown
+  // if the module contains operations which may define symbol tables.
+  auto uses = SymbolTable::getSymbolUses(module);
+  if (!uses)
+    return None;
+
+  llvm::raw_sha1_ostream hasher;
+  hasher << commonInput;
+  // The locations end up in comments in the Verilog.
+  OpPrintingFlags flags;
+  flags.enableDebugInfo();
+  module->print(hasher, flags);
+  for (auto &use : *uses) {
+    auto symbol = use.getSymbolRef();
+    hasher << '\0' << symbol;
+    if (auto *target = symbolTable.lookup(symbol.getRootReference()))
+      hasher << '\0' << target->getAttrDictionary();
+  }
+  return llvm::toHex(hasher.sha1(), /*LowerCase=*/true);
+}
+
+void IncrementalCache::skipUnchangedModules(ModuleOp module) {
+  auto circuits = module.getOps<firrtl::CircuitOp>();
+  if (circuits.empty())
+    return;
+  auto circuit = *circuits.begin();
+
+  // The file of a module is named after it.  If any module has to be renamed
+  // for Verilog, the renaming may cascade into other modules, so nothing is
+  // cached.
+  llvm::StringSet<> externalNames;
+  SmallVector<firrtl::FModuleOp, 0> modules;
+  for (auto &op : *circuit.getBody()) {
+    if (auto extModule = dyn_cast<firrtl::FExtModuleOp>(op))
+      externalNames.insert(
+          extModule.defname().getValueOr(extModule.getName()));
+    else if (auto fmodule = dyn_cast<firrtl::FModuleOp>(op))
+      modules.push_back(fmodule);
+  }
+  for (auto fmodule : modules)
+    if (!sv::isNameValid(fmodule.getName()) ||
+        externalNames.count(fmodule.getName()))
+      return;
+
+  std::string commonInput;
+  llvm::raw_string_ostream os(commonInput);
+  os << incrementalCacheVersion << '\0' << commandLine << '\0'
+     << module->getAttrDictionary() << '\0' << circuit->getAttrDictionary()
+     << '\0';
+  os.flush();
+
+  SymbolTable symbolTable(circuit);
+  std::vector<Optional<std::string>> moduleHashes(modules.size());
+  auto hashOne = [&](size_t index) {
+    moduleHashes[index] = hashModule(modules[index], symbolTable, commonInput);
+  };
+  if (module.getContext()->isMultithreadingEnabled())
+    llvm::parallelForEachN(0, modules.size(), hashOne);
+  else
+    for (size_t index = 0, e = modules.size(); index != e; ++index)
+      hashOne(index);
+
+  // Replace the modules only once all of them are hashed, since the hashes
+  // refer to the signatures of the modules.
+  for (size_t index = 0, e = modules.size(); index != e; ++index) {
+    auto fmodule = modules[index];
+    auto &hash = moduleHashes[index];
+    if (!hash)
+      continue;
+    auto name = fmodule.getName();
+    hashes[name] = *hash;
+
+    auto previous = previousHashes.find(name);
+    if (previous == previousHashes.end() || previous->second != *hash)
+      continue;
+    SmallString<128> path(outputDirectory);
+    llvm::sys::path::append(path, name + ".sv");
+    if (!llvm::sys::fs::exists(path))
+      continue;
+
+    OpBuilder builder(fmodule);
+    builder.create<firrtl::FExtModuleOp>(fmodule.getLoc(),
+                                         builder.getStringAttr(name),
+                                         fmodule.getPorts());
+    reusedModules.insert(name);
+    fmodule.erase();
+  }
+}
+
+bool IncrementalCache::headerChanged(ModuleOp module) {
+  // These are the operations emitted into every file.
+  llvm::raw_sha1_ostream hasher;
+  for (auto &op : *module.getBody())
+    if (isa<sv::VerbatimOp, sv::IfDefProceduralOp>(op))
+      hasher << op << '\0';
+  headerHash = llvm::toHex(hasher.sha1(), /*LowerCase=*/true);
+  return !reusedModules.empty() && headerHash != previousHeaderHash;
+}
+
+//===----------------------------------------------------------------------===//
+// Driver
+//===----------------------------------------------------------------------===//
+
+/// Compile a single buffer of the input, and record the phases of the
+/// compilation in `stats` if it is non-null.  If `verilogOS` is non-null, the
+/// Verilog is emitted into it by the pass pipeline.  If `incrementalCache` is
+/// non-null, the modules it finds unchanged are not lowered.
 static LogicalResult
-processBuffer(std::unique_ptr<llvm::MemoryBuffer> ownedBuffer,
-              StringRef annotationFilename,
+compileBuffer(std::unique_ptr<llvm::MemoryBuffer> ownedBuffer,
+              StringRef annotationFilename, StatsReport *stats,
+              raw_ostream *verilogOS, raw_ostream *sourceMapOS,
+              IncrementalCache *incrementalCache,
               std::function<LogicalResult(OwningModuleRef)> callback) {
   MLIRContext context;
 
@@ -155,6 +656,10 @@ processBuffer(std::unique_ptr<llvm::MemoryBuffer> ownedBuffer,
   pm.enableVerifier(verifyPasses);
   applyPassManagerCLOptions(pm);
 
+  if (stats)
+    pm.addInstrumentation(std::make_unique<StatsInstrumentation>(*stats));
+  auto parseStartTime = StatsReport::Clock::now();
+
   OwningModuleRef module;
   if (inputFormat == InputFIRFile) {
     firrtl::FIRParserOptions options;
@@ -175,8 +680,13 @@ processBuffer(std::unique_ptr<llvm::MemoryBuffer> ownedBuffer,
       modulePM.addPass(createSimpleCanonicalizerPass());
     }
   } else {
-    assert(inputFormat == InputMLIRFile);
-    module = parseSourceFile(sourceMgr, &context);
+    assert(inputFormat == InputMLIRFile || inputFormat == InputBinaryFile);
+    if (inputFormat == InputBinaryFile) {
+      auto *buffer = sourceMgr.getMemoryBuffer(sourceMgr.getMainFileID());
+      module = importBinaryIR(buffer->getMemBufferRef(), &context);
+    } else {
+      module = parseSourceFile(sourceMgr, &context);
+    }
 
     if (enableLowerTypes) {
       pm.addNestedPass<firrtl::CircuitOp>(firrtl::createLowerFIRRTLTypesPass());
@@ -191,12 +701,22 @@ processBuffer(std::unique_ptr<llvm::MemoryBuffer> ownedBuffer,
       }
     }
   }
+  if (stats) {
+    auto &phase = stats->addPhase("parse", parseStartTime);
+    if (module)
+      phase.opCountsAfter = StatsReport::countOps(module.get());
+  }
   if (!module)
     return failure();
 
   // Allow optimizations to run multithreaded.
   context.enableMultithreading(isMultithreaded);
 
+  // Deduplicate after the modules have been cleaned up, so that modules which
+  // only differ in redundant operations are still merged.
+  if (dedup)
+    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createDedupPass());
+
   if (imconstprop)
     pm.nest<firrtl::CircuitOp>().addPass(firrtl::createIMConstPropPass());
 
@@ -204,8 +724,9 @@ processBuffer(std::unique_ptr<llvm::MemoryBuffer> ownedBuffer,
     pm.nest<firrtl::CircuitOp>().addPass(firrtl::createBlackBoxMemoryPass());
 
   // Lower if we are going to verilog or if lowering was specifically requested.
-  if (lowerToRTL || outputFormat == OutputVerilog ||
-      outputFormat == OutputSplitVerilog) {
+  bool emitVerilog =
+      outputFormat == OutputVerilog || outputFormat == OutputSplitVerilog;
+  if (lowerToRTL || emitVerilog) {
     pm.addPass(createLowerFIRRTLToRTLPass());
     pm.addPass(sv::createRTLMemSimImplPass());
 
@@ -213,41 +734,91 @@ processBuffer(std::unique_ptr<llvm::MemoryBuffer> ownedBuffer,
     if (!disableOptimization) {
       auto &modulePM = pm.nest<rtl::RTLModuleOp>();
       modulePM.addPass(sv::createRTLCleanupPass());
-      modulePM.addPass(createCSEPass());
+      modulePM.addPass(sv::createRTLStructuralCSEPass());
       modulePM.addPass(createSimpleCanonicalizerPass());
     }
-  }
 
-  // If we are going to verilog, sanitize the module names.
-  if (outputFormat == OutputVerilog || outputFormat == OutputSplitVerilog) {
-    pm.addPass(sv::createRTLLegalizeNamesPass());
+    // If we are going to verilog, sanitize the module names once the
+    // optimizer is done with the design, then prepare the modules for
+    // emission.  When streaming, each module is emitted by the same nested
+    // pipeline, right after it has been prepared.
+    if (emitVerilog) {
+      pm.addPass(sv::createRTLLegalizeNamesPass());
+      if (verilogOS)
+        buildStreamingExportVerilogPipeline(pm, *verilogOS, sourceMapOS);
+      else
+        pm.nest<rtl::RTLModuleOp>().addPass(createPrepareForEmissionPass());
+    }
   }
 
   // Load the emitter options from the command line. Command line options if
   // specified will override any module options.
   applyLoweringCLOptions(module.get());
 
+  if (incrementalCache)
+    incrementalCache->skipUnchangedModules(module.get());
+
   if (failed(pm.run(module.get())))
     return failure();
 
-  return callback(std::move(module));
+  if (!stats)
+    return callback(std::move(module));
+
+  auto emitStartTime = StatsReport::Clock::now();
+  auto opCountsBeforeEmission = StatsReport::countOps(module.get());
+  auto result = callback(std::move(module));
+  stats->addPhase("emit", emitStartTime).opCountsBefore =
+      std::move(opCountsBeforeEmission);
+  return result;
+}
+
+/// Process a single buffer of the input.
+static LogicalResult
+processBuffer(std::unique_ptr<llvm::MemoryBuffer> ownedBuffer,
+              StringRef annotationFilename, raw_ostream *verilogOS,
+              raw_ostream *sourceMapOS, IncrementalCache *incrementalCache,
+              std::function<LogicalResult(OwningModuleRef)> callback) {
+  if (statsJSONFilename.empty())
+    return compileBuffer(std::move(ownedBuffer), annotationFilename,
+                         /*stats=*/nullptr, verilogOS, sourceMapOS,
+                         incrementalCache, callback);
+
+  // If requested, collect statistics about each phase of the compilation.
+  // The report is also written when the compilation fails, and then covers
+  // the phases up to the failure.
+  StatsReport stats;
+  auto result =
+      compileBuffer(std::move(ownedBuffer), annotationFilename, &stats,
+                    verilogOS, sourceMapOS, incrementalCache, callback);
+  if (failed(stats.write(statsJSONFilename)))
+    return failure();
+  return result;
 }
 
 /// Process a single buffer of the input into a single output stream.
 static LogicalResult
 processBufferIntoSingleStream(std::unique_ptr<llvm::MemoryBuffer> ownedBuffer,
-                              StringRef annotationFilename, raw_ostream &os) {
+                              StringRef annotationFilename, raw_ostream &os,
+                              raw_ostream *sourceMapOS) {
+  // If requested, the pass pipeline emits the Verilog itself.
+  bool streaming = streamVerilog && outputFormat == OutputVerilog;
   return processBuffer(
-      std::move(ownedBuffer), annotationFilename, [&](OwningModuleRef module) {
+      std::move(ownedBuffer), annotationFilename, streaming ? &os : nullptr,
+      sourceMapOS, /*incrementalCache=*/nullptr, [&](OwningModuleRef module) {
         // Finally, emit the output.
         switch (outputFormat) {
         case OutputMLIR:
           module->print(os);
           return success();
+        case OutputBinary:
+          exportBinaryIR(module.get(), os);
+          return success();
         case OutputDisabled:
           return success();
         case OutputVerilog:
-          return exportVerilog(module.get(), os);
+          if (streaming)
+            return success();
+          return exportVerilog(module.get(), os, sourceMapOS);
         case OutputSplitVerilog:
           llvm_unreachable("multi-file format must be handled elsewhere");
         }
@@ -259,20 +830,52 @@ processBufferIntoSingleStream(std::unique_ptr<llvm::MemoryBuffer> ownedBuffer,
 static LogicalResult
 processBufferIntoMultipleFiles(std::unique_ptr<llvm::MemoryBuffer> ownedBuffer,
                                StringRef annotationFilename,
-                               StringRef outputDirectory) {
-  return processBuffer(
-      std::move(ownedBuffer), annotationFilename, [&](OwningModuleRef module) {
-        // Finally, emit the output.
-        switch (outputFormat) {
-        case OutputMLIR:
-        case OutputDisabled:
-        case OutputVerilog:
-          llvm_unreachable("single-stream format must be handled elsewhere");
-        case OutputSplitVerilog:
-          return exportSplitVerilog(module.get(), outputDirectory);
-        }
-        llvm_unreachable("unknown output format");
-      });
+                               StringRef outputDirectory,
+                               IncrementalCache *incrementalCache) {
+  // Keep a copy of the input in case the design has to be compiled again
+  // without reusing any files.
+  std::unique_ptr<llvm::MemoryBuffer> inputCopy;
+  if (incrementalCache)
+    inputCopy = llvm::MemoryBuffer::getMemBufferCopy(
+        ownedBuffer->getBuffer(), ownedBuffer->getBufferIdentifier());
+
+  bool mustRecompile = false;
+  auto callback = [&](OwningModuleRef module) -> LogicalResult {
+    // Finally, emit the output.
+    switch (outputFormat) {
+    case OutputMLIR:
+    case OutputBinary:
+    case OutputDisabled:
+    case OutputVerilog:
+      llvm_unreachable("single-stream format must be handled elsewhere");
+    case OutputSplitVerilog: {
+      if (!incrementalCache)
+        return exportSplitVerilog(module.get(), outputDirectory);
+      if (incrementalCache->headerChanged(module.get())) {
+        mustRecompile = true;
+        return success();
+      }
+      auto result =
+          exportSplitVerilog(module.get(), outputDirectory,
+                             &incrementalCache->getReusedModules());
+      return incrementalCache->write(succeeded(result));
+    }
+    }
+    llvm_unreachable("unknown output format");
+  };
+
+  auto result = processBuffer(std::move(ownedBuffer), annotationFilename,
+                              /*verilogOS=*/nullptr, /*sourceMapOS=*/nullptr,
+                              incrementalCache, callback);
+  if (failed(result) || !mustRecompile)
+    return result;
+
+  // The reused files were emitted with a different header, so compile the
+  // whole design again.
+  incrementalCache->forgetPreviousRun();
+  return processBuffer(std::move(inputCopy), annotationFilename,
+                       /*verilogOS=*/nullptr, /*sourceMapOS=*/nullptr,
+                       incrementalCache, callback);
 }
 
 int main(int argc, char **argv) {
@@ -283,13 +886,28 @@ int main(int argc, char **argv) {
   registerPassManagerCLOptions();
   registerAsmPrinterCLOptions();
   registerLoweringCLOptions();
+  registerParallelSchedulingCLOptions();
+  rtl::registerRTLDialectCLOptions();
 
   // Parse pass names in main to ensure static initialization completed.
   cl::ParseCommandLineOptions(argc, argv, "circt modular optimizer driver\n");
 
+  // Set up the input file.  Regular files are memory mapped rather than read
+  // into a heap buffer.  The buffer is handed to the SourceMgr in
+  // compileBuffer, which keeps it mapped until the output has been emitted, so
+  // the parser can refer to token spellings in place.
+  std::string errorMessage;
+  auto input = openInputFile(inputFilename, &errorMessage);
+  if (!input) {
+    llvm::errs() << errorMessage << "\n";
+    return 1;
+  }
+
   // Figure out the input format if unspecified.
   if (inputFormat == InputUnspecified) {
-    if (StringRef(inputFilename).endswith(".fir"))
+    if (isBinaryIR(input->getBuffer()))
+      inputFormat = InputBinaryFile;
+    else if (StringRef(inputFilename).endswith(".fir"))
       inputFormat = InputFIRFile;
     else if (StringRef(inputFilename).endswith(".mlir"))
       inputFormat = InputMLIRFile;
@@ -300,18 +918,26 @@ int main(int argc, char **argv) {
     }
   }
 
-  // Set up the input file.
-  std::string errorMessage;
-  auto input = openInputFile(inputFilename, &errorMessage);
-  if (!input) {
-    llvm::errs() << errorMessage << "\n";
-    return 1;
+  // Only the modules of the split output have their own files to reuse.
+  // Intermodule optimizations make modules depend on the bodies of other
+  // modules, which are not part of their hashes.
+  if (!incrementalCacheFilename.empty()) {
+    if (outputFormat != OutputSplitVerilog) {
+      llvm::errs() << "-incremental-cache requires -split-verilog\n";
+      return 1;
+    }
+    if (imconstprop || dedup) {
+      llvm::errs() << "-incremental-cache cannot be combined with "
+                      "-imconstprop or -dedup\n";
+      return 1;
+    }
   }
 
   // Emit a single file or multiple files depending on the output format.
   switch (outputFormat) {
   // Outputs into a single stream.
   case OutputMLIR:
+  case OutputBinary:
   case OutputDisabled:
   case OutputVerilog: {
     auto output = openOutputFile(outputFilename, &errorMessage);
@@ -320,11 +946,23 @@ int main(int argc, char **argv) {
       return 1;
     }
 
+    std::unique_ptr<llvm::ToolOutputFile> sourceMap;
+    if (!sourceMapFilename.empty()) {
+      sourceMap = openOutputFile(sourceMapFilename, &errorMessage);
+      if (!sourceMap) {
+        llvm::errs() << errorMessage << "\n";
+        return 1;
+      }
+    }
+
     if (failed(processBufferIntoSingleStream(
-            std::move(input), inputAnnotationFilename, output->os())))
+            std::move(input), inputAnnotationFilename, output->os(),
+            sourceMap ? &sourceMap->os() : nullptr)))
       return 1;
 
     output->keep();
+    if (sourceMap)
+      sourceMap->keep();
     return 0;
   }
 
@@ -341,8 +979,23 @@ int main(int argc, char **argv) {
       return 1;
     }
 
+    // If requested, reuse the files of the modules which did not change
+    // since the previous run.
+    std::unique_ptr<IncrementalCache> incrementalCache;
+    if (!incrementalCacheFilename.empty()) {
+      std::string commandLine;
+      for (int i = 0; i != argc; ++i) {
+        commandLine += argv[i];
+        commandLine += '\0';
+      }
+      incrementalCache = std::make_unique<IncrementalCache>(
+          incrementalCacheFilename, outputFilename, std::move(commandLine));
+      incrementalCache->read();
+    }
+
     if (failed(processBufferIntoMultipleFiles(
-            std::move(input), inputAnnotationFilename, outputFilename)))
+            std::move(input), inputAnnotationFilename, outputFilename,
+            incrementalCache.get())))
       return 1;
     return 0;
   }
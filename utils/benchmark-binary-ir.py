@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+##===- utils/benchmark-binary-ir.py - Binary IR speed ----*- python -*-===##
+#
+# Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+#
+##===----------------------------------------------------------------------===##
+#
+# This script compares the read and write throughput of the binary IR format
+# with the one of textual IR.  It generates a synthetic design made of RTL
+# modules of configurable size, has firtool write it in both formats and read
+# it back, and reports the file sizes along with the time spent writing
+# (firtool's "emit" phase) and reading (its "parse" phase), as taken from the
+# -stats-json report.
+#
+# Usage: benchmark-binary-ir.py [--modules N] [--ops N] [--runs N]
+#
+##===----------------------------------------------------------------------===##
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+OPS = ["comb.add", "comb.xor", "comb.and", "comb.or", "comb.mul"]
+
+
+def generate_design(num_modules, num_ops, width):
+  """Return the textual IR of a synthetic design."""
+  lines = []
+  for m in range(num_modules):
+    lines.append(f"rtl.module @m{m}(%a: i{width}, %b: i{width}) -> "
+                 f"(%x: i{width}, %y: i{width}) {{")
+    prev, cur = "%a", "%b"
+    for i in range(num_ops):
+      op = OPS[i % len(OPS)]
+      lines.append(f"  %{i} = {op} {prev}, {cur} : i{width} "
+                   f"loc(\"design.fir\":{m}:{i})")
+      prev, cur = cur, f"%{i}"
+    lines.append(f"  rtl.output {prev}, {cur} : i{width}, i{width}")
+    lines.append("}")
+  return "\n".join(lines) + "\n"
+
+
+def best_phase_time(cmd, stats_path, phase, runs):
+  """Run firtool `runs` times and return the fastest time of a phase."""
+  best = None
+  for _ in range(runs):
+    subprocess.run(cmd + [f"-stats-json={stats_path}"], check=True)
+    with open(stats_path) as f:
+      phases = json.load(f)["phases"]
+    time = next(p["wallTime"] for p in phases if p["name"] == phase)
+    best = time if best is None else min(best, time)
+  return best
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__)
+  parser.add_argument("--modules", type=int, default=100,
+                      help="Number of modules in the design")
+  parser.add_argument("--ops", type=int, default=1000,
+                      help="Number of operations per module")
+  parser.add_argument("--width", type=int, default=32,
+                      help="Bit width of the values in the design")
+  parser.add_argument("--runs", type=int, default=3,
+                      help="Number of runs; the fastest one is reported")
+  parser.add_argument("--firtool", default="firtool",
+                      help="Path to the firtool binary")
+  args = parser.parse_args()
+
+  print(f"modules: {args.modules}, ops/module: {args.ops}, "
+        f"width: {args.width}")
+  with tempfile.TemporaryDirectory() as tmp:
+    input_path = os.path.join(tmp, "design.mlir")
+    stats_path = os.path.join(tmp, "stats.json")
+    with open(input_path, "w") as f:
+      f.write(generate_design(args.modules, args.ops, args.width))
+
+    for kind, flag in [("text", "-mlir"), ("binary", "-binary")]:
+      output_path = os.path.join(tmp, f"design.{kind}")
+      write_time = best_phase_time([
+          args.firtool, input_path, "--format=mlir", "-disable-opt",
+          "-mlir-print-debuginfo", flag, "-o", output_path
+      ], stats_path, "emit", args.runs)
+      read_time = best_phase_time([
+          args.firtool, output_path, "--format=mlir" if kind == "text" else
+          "--format=binary", "-disable-opt", "-disable-output"
+      ], stats_path, "parse", args.runs)
+
+      megabytes = os.path.getsize(output_path) / (1024 * 1024)
+      print(f"{kind}: {megabytes:.2f} MB, "
+            f"write: {write_time:.3f} s ({megabytes / write_time:.2f} MB/s), "
+            f"read: {read_time:.3f} s ({megabytes / read_time:.2f} MB/s)")
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main())
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+##===- utils/benchmark-constants.py - Constant folding speed -*- python -*-===##
+#
+# Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+#
+##===----------------------------------------------------------------------===##
+#
+# This script measures how fast constants are created while folding.  It
+# generates a synthetic design made of RTL modules full of foldable chains of
+# narrow constants, canonicalizes every module with circt-opt, both with and
+# without multithreading, and reports the number of folded operations per
+# second.  Most of the time goes in to creating the attributes of the folded
+# constants, so the multithreaded rate shows how much the threads contend on
+# the attribute uniquer of the context.  Each configuration is also run with
+# the per-thread integer attribute cache of the RTL dialect disabled, which
+# shows what the cache saves.
+#
+# Usage: benchmark-constants.py [--modules N] [--ops N] [--runs N]
+#                               [--no-compare]
+#
+##===----------------------------------------------------------------------===##
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+OPS = ["comb.add", "comb.xor", "comb.and", "comb.or", "comb.mul"]
+
+
+def generate_design(num_modules, num_ops, width):
+  """Return the textual IR of a synthetic design."""
+  lines = []
+  mask = (1 << width) - 1
+  for m in range(num_modules):
+    lines.append(f"rtl.module @m{m}() -> (%x: i{width}) {{")
+    prev = "%c"
+    lines.append(f"  %c = rtl.constant {m & mask} : i{width}")
+    for i in range(num_ops):
+      op = OPS[i % len(OPS)]
+      value = (m * num_ops + i * 7919) & mask
+      lines.append(f"  %k{i} = rtl.constant {value} : i{width}")
+      lines.append(f"  %{i} = {op} {prev}, %k{i} : i{width}")
+      prev = f"%{i}"
+    lines.append(f"  rtl.output {prev} : i{width}")
+    lines.append("}")
+  return "\n".join(lines) + "\n"
+
+
+def time_canonicalize(args, input_path, threaded, cached=True):
+  """Return the fastest wall time of canonicalizing the design."""
+  cmd = [
+      args.circt_opt, input_path,
+      "-pass-pipeline=rtl.module(simple-canonicalizer)", "-o", os.devnull
+  ]
+  if not threaded:
+    cmd.append("-mlir-disable-threading")
+  if not cached:
+    cmd.append("-rtl-disable-integer-attr-cache")
+
+  best = None
+  for _ in range(args.runs):
+    start = time.perf_counter()
+    subprocess.run(cmd, check=True)
+    elapsed = time.perf_counter() - start
+    best = elapsed if best is None else min(best, elapsed)
+  return best
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__)
+  parser.add_argument("--modules", type=int, default=64,
+                      help="Number of modules in the design")
+  parser.add_argument("--ops", type=int, default=10000,
+                      help="Number of foldable operations per module")
+  parser.add_argument("--width", type=int, default=32,
+                      help="Bit width of the constants, at most 64 to hit "
+                      "the narrow constant cache")
+  parser.add_argument("--runs", type=int, default=3,
+                      help="Number of runs; the fastest one is reported")
+  parser.add_argument("--circt-opt", default="circt-opt",
+                      help="Path to the circt-opt binary")
+  parser.add_argument("--no-compare", action="store_true",
+                      help="Do not compare with the integer attribute cache "
+                      "disabled")
+  args = parser.parse_args()
+
+  with tempfile.TemporaryDirectory() as tmp:
+    input_path = os.path.join(tmp, "design.mlir")
+    with open(input_path, "w") as f:
+      f.write(generate_design(args.modules, args.ops, args.width))
+
+    results = []
+    for cached in [True] if args.no_compare else [True, False]:
+      serial = time_canonicalize(args, input_path, False, cached)
+      threaded = time_canonicalize(args, input_path, True, cached)
+      results.append((cached, serial, threaded))
+
+  folds = args.modules * args.ops
+  print(f"modules: {args.modules}, ops/module: {args.ops}, "
+        f"width: {args.width}")
+  for cached, serial, threaded in results:
+    label = "cached" if cached else "uncached"
+    print(f"{label} serial: {serial:.3f} s, "
+          f"{folds / serial / 1e6:.2f} M folds/s")
+    print(f"{label} threaded: {threaded:.3f} s, "
+          f"{folds / threaded / 1e6:.2f} M folds/s, "
+          f"speedup: {serial / threaded:.2f}x")
+  if len(results) == 2:
+    print(f"cache speedup: serial {results[1][1] / results[0][1]:.2f}x, "
+          f"threaded {results[1][2] / results[0][2]:.2f}x")
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main())